@@ -300,6 +300,12 @@ class bitVector {
         return curent_rank;
     }
 
+    // prefetch the bit at pos and the rank sample it is counted from
+    void prefetch(uint64_t pos) const {
+        __builtin_prefetch(_bitArray + (pos >> 6ULL));
+        __builtin_prefetch(_ranks.data() + pos / _nb_bits_per_rank_sample);
+    }
+
     uint64_t rank(uint64_t pos) const {
         uint64_t word_idx = pos / 64ULL;
         uint64_t word_offset = pos % 64;
@@ -466,10 +472,28 @@ class mphf {
     uint64_t lookup(const elem_t &elem) const {
         if (!_built) return NOT_FOUND;
 
+        return lookup_hash(_hasher.hashpair128(elem));
+    }
+
+    // batched lookups: hash all the elements first, prefetch the first level
+    // for every hash, then resolve them with lookup_hash()
+    template<class elem_t>
+    hash_pair_t hash(const elem_t &elem) const {
+        return _hasher.hashpair128(elem);
+    }
+
+    void prefetch(const hash_pair_t &bbhash) const {
+        if (!_built || _nb_levels < 2) return;
+
+        _levels[0].bitset.prefetch(fastrange64(bbhash[0], _levels[0].hash_domain));
+    }
+
+    uint64_t lookup_hash(hash_pair_t bbhash) const {
+        if (!_built) return NOT_FOUND;
+
         uint64_t non_minimal_hp;
         unsigned level;
 
-        hash_pair_t bbhash = _hasher.hashpair128(elem);
         uint64_t level_hash = getLevel(bbhash, &level, _nb_levels);
 
         if (level == (_nb_levels-1)) {
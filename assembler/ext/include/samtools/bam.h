@@ -591,6 +591,16 @@ extern "C" {
 	int bam_lplbuf_push(const bam1_t *b, bam_lplbuf_t *buf);
 
 
+	/*!
+	  @abstract     Sort a BAM file (see bam_sort.c).
+	  @discussion   The sorted file "prefix.bam" will be created.
+	  @param  is_by_qname  sort by read name instead of coordinate
+	  @param  fn           name of the BAM file
+	  @param  prefix       prefix of the output and temporary files
+	  @param  max_mem      maximal memory to use for sorting, in bytes
+	 */
+	void bam_sort_core(int is_by_qname, const char *fn, const char *prefix, size_t max_mem);
+
 	/*********************
 	 * BAM indexing APIs *
 	 *********************/
@@ -92,6 +92,42 @@ def show_grp(file, show_seq=False):
                 print("Edge", edge, ":", start, "->", end, ", l =", len(seq), "~", edge_conj, ".")
                 print("Edge", edge_conj, ":", end_conj, "->", start_conj, ", l =", len(seq), "~", edge, ".")
 
+def show_grpk(file, show_seq=False):
+    header = [read_int(file, 8) for _ in range(9)]
+    _, _, _, _, _, vertex_cnt, link_cnt, edge_cnt, nucls_size = header
+
+    vertices = [read_int(file, 8) for _ in range(2 * vertex_cnt)]
+    offsets = [read_int(file, 8) for _ in range(2 * vertex_cnt + 1)]
+    links = [read_int(file, 8) for _ in range(link_cnt)]
+    nucls_start = file.tell()
+    file.seek(nucls_size, os.SEEK_CUR)
+    edges = [read_int(file, 8) for _ in range(3 * edge_cnt)]
+
+    conj = {}
+    for i in range(vertex_cnt):
+        conj[vertices[2 * i]] = vertices[2 * i + 1]
+        conj[vertices[2 * i + 1]] = vertices[2 * i]
+    start = {}
+    for i, v in enumerate(vertices):
+        for e in links[offsets[i]:offsets[i + 1]]:
+            start[e] = v
+
+    for i in range(edge_cnt):
+        edge, edge_conj, offset = edges[3 * i:3 * i + 3]
+        file.seek(nucls_start + offset)
+        seq = read_seq(file)
+        end = conj[start[edge_conj]]
+
+        if show_seq:
+            print(">", edge, sep="")
+            print(seq)
+            if edge != edge_conj:
+                print(">", edge_conj, sep="")
+                print(seq.reverse_complement())
+        else:
+            print("Edge", edge, ":", start[edge], "->", end, ", l =", len(seq), "~", edge_conj, ".")
+            print("Edge", edge_conj, ":", conj[end], "->", conj[start[edge]], ", l =", len(seq), "~", edge, ".")
+
 #---- Paired info --------------------------------------------------------------
 def show_prd(file, clustered=False):
     size = read_int(file)
@@ -111,6 +147,9 @@ def show_prd(file, clustered=False):
 def show_sqn(file):
     show_grp(file, True)
 
+def show_sqn_grpk(file):
+    show_grpk(file, True)
+
 #---- Edge coverage ------------------------------------------------------------
 def show_cvr(file):
     while True:
@@ -149,5 +188,8 @@ basename, ext = os.path.splitext(sys.argv[1])
 target = ext
 if ext in [".grp", ".sqn"]:
     target = ".grseq"
+    if os.path.exists(basename + ".grpk"):
+        target = ".grpk"
+        showers.update({".grp" : show_grpk, ".sqn" : show_sqn_grpk})
 with open(basename + target, "rb") as file:
     showers[ext](file)
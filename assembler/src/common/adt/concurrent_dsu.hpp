@@ -95,6 +95,48 @@ public:
         }
     }
 
+    // Unites the sets of 'x' and 'y' if 'pred(x_size, y_size)' holds for their
+    // sizes. The check and the link are atomic: the size of the surviving root
+    // is reserved first (so concurrent checks see the merged size) and released
+    // back if linking fails. Returns whether the sets were united. Must not be
+    // used concurrently with unite(), which updates the size after the link.
+    template<class Pred>
+    bool unite_if(size_t x, size_t y, Pred pred) {
+        while (true) {
+            x = find_set(x);
+            y = find_set(y);
+            if (x == y)
+                return false;
+
+            atomic_set_t x_entry = data_[x], y_entry = data_[y];
+            if (!x_entry.root || !y_entry.root)
+                continue;
+
+            if (!pred(size_t(x_entry.data), size_t(y_entry.data)))
+                return false;
+
+            // We need to link the smallest subtree to the largest
+            uint64_t x_size = x_entry.data, y_size = y_entry.data;
+            if (x_size > y_size || (x_size == y_size && x > y)) {
+                std::swap(x, y);
+                std::swap(x_size, y_size);
+                std::swap(x_entry, y_entry);
+            }
+
+            // Reserve the size of 'x' in 'y'. If someone already changed 'y' => check again.
+            atomic_set_t new_y_entry = {.data = x_size + y_size, .aux = y_entry.aux, .root = true};
+            if (!data_[y].compare_exchange_strong(y_entry, new_y_entry))
+                continue;
+
+            // Link 'x' to 'y'. If someone already changed 'x' => release the reservation and check again.
+            atomic_set_t new_x_entry = {.data = y, .aux = x_entry.aux, .root = false};
+            if (data_[x].compare_exchange_strong(x_entry, new_x_entry))
+                return true;
+
+            add_size(y, -x_size);
+        }
+    }
+
     size_t set_size(size_t i) const {
         while (true) {
             size_t el = find_set(i);
@@ -211,6 +253,22 @@ public:
     }
 
 private:
+    // Adds 'delta' (modulo 2^64) to the size of the set containing 'x'
+    void add_size(size_t x, uint64_t delta) {
+        while (true) {
+            x = find_set(x);
+            atomic_set_t x_entry = data_[x];
+            if (!x_entry.root)
+                continue;
+
+            atomic_set_t new_x_entry = {.data = x_entry.data + delta, .aux = x_entry.aux, .root = true};
+            if (!data_[x].compare_exchange_strong(x_entry, new_x_entry))
+                continue;
+
+            break;
+        }
+    }
+
     size_t parent(size_t x) const {
         atomic_set_t val = data_[x];
         return (val.root ? x : val.data);
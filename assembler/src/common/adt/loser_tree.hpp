@@ -184,6 +184,11 @@ public:
         entry_[0] = replay(winner_index);
     }
 
+    // Index of the run the top element comes from
+    size_t top_run() const {
+        return entry_[0];
+    }
+
 private:
     std::vector<adt::iterator_range<It>> runs_;
 };
@@ -126,6 +126,17 @@ public:
         return false;
     }
 
+    /**
+     * Handlers which are not queried while the graph is being modified could override this method.
+     * While the graph journals its events (see ObservableGraph::StartJournaling), such handlers get
+     * them in batches, concurrently with other deferrable handlers. So they should only read the
+     * graph and their own data. Deleted edges and vertices keep their data and conjugates until
+     * the batch is handled, but are unlinked from the graph.
+     */
+    virtual bool IsDeferrable() const {
+        return false;
+    }
+
     bool IsAttached() const {
         return attached_;
     }
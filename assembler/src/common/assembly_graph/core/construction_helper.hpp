@@ -80,6 +80,11 @@ public:
         return graph_.AddEdge(data, id, cid);
     }
 
+    // Unlike AddEdge, does not notify the handlers
+    EdgeId CreateEdge(const EdgeData &data, EdgeId id, EdgeId cid) {
+        return graph_.HiddenAddEdge(data, id, cid);
+    }
+
     void LinkIncomingEdge(VertexId v, EdgeId e) {
         VERIFY(graph_.EdgeEnd(e) == VertexId());
         graph_.cvertex(v).AddOutgoingEdge(graph_.conjugate(e));
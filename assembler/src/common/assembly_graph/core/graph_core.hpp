@@ -234,7 +234,7 @@ private:
             VERIFY(N > storage_size_);
             T *new_storage = (T*)malloc(N * sizeof(T));
             for (uint64_t id = bias_; id < storage_size_; ++id) {
-                if (!id_distributor_.occupied(id))
+                if (!id_distributor_.occupied(id) && !id_distributor_.retired(id))
                     continue;
 
                 T *val = &storage_[id];
@@ -281,6 +281,8 @@ private:
             return id < storage_size_ && id_distributor_.occupied(id);
         }
 
+        // Could be called concurrently with create(), emplace() and erase() unless
+        // the storage needs to grow, so parallel callers MUST reserve() beforehand
         template<typename... ArgTypes>
         uint64_t create(ArgTypes &&... args) {
             uint64_t id = id_distributor_.allocate();
@@ -298,7 +300,7 @@ private:
         template<typename... ArgTypes>
         uint64_t emplace(uint64_t at, ArgTypes &&... args) {
             // One MUST call reserve before using emplace()
-            VERIFY(!id_distributor_.occupied(at));
+            VERIFY(!id_distributor_.occupied(at) && !id_distributor_.retired(at));
 
             id_distributor_.acquire(at);
             new(storage_ + at) T(std::forward<ArgTypes>(args)...);;
@@ -318,6 +320,17 @@ private:
             size_ -= 1;
         }
 
+        // Hides the element, but keeps it alive and its id reserved until purge()
+        void retire(uint64_t id) {
+            id_distributor_.retire(id);
+            size_ -= 1;
+        }
+
+        // Destroys the retired elements and frees their ids
+        void purge() {
+            id_distributor_.reclaim([this](uint64_t id) { storage_[id].~T(); });
+        }
+
         T& at(uint64_t id) const noexcept {
             return storage_[id];
         }
@@ -337,6 +350,7 @@ private:
     VertexStorage vstorage_;
     using EdgeStorage = IdStorage<PairedEdge<DataMaster>>;
     EdgeStorage estorage_;
+    bool keep_deleted_ = false;
 
     PairedVertex<DataMaster>& vertex(VertexId id) const noexcept {
         return vstorage_.at(id.int_id());
@@ -573,6 +587,11 @@ private:
 
     void DestroyVertex(VertexId v) {
         VertexId cv = conjugate(v);
+        if (keep_deleted_) {
+            vstorage_.retire(v.int_id());
+            vstorage_.retire(cv.int_id());
+            return;
+        }
         vstorage_.erase(v.int_id());
         vstorage_.erase(cv.int_id());
     }
@@ -588,6 +607,12 @@ private:
     }
 
     void DestroyEdge(EdgeId e, EdgeId rc) {
+        if (keep_deleted_) {
+            if (e != rc)
+                estorage_.retire(rc.int_id());
+            estorage_.retire(e.int_id());
+            return;
+        }
         if (e != rc)
             estorage_.erase(rc.int_id());
         estorage_.erase(e.int_id());
@@ -665,6 +690,17 @@ protected:
             HiddenDeleteVertex(v);
     }
 
+    // While set, deleted vertices and edges are only unlinked and hidden: their
+    // data stays readable and their ids are not reused until PurgeDeleted()
+    void KeepDeleted(bool keep) {
+        keep_deleted_ = keep;
+    }
+
+    void PurgeDeleted() {
+        estorage_.purge();
+        vstorage_.purge();
+    }
+
 public:
     GraphCore(const DataMaster& master)
             : master_(master),
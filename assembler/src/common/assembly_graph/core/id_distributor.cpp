@@ -1,42 +1,95 @@
 #include "id_distributor.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+
 using namespace omnigraph;
 
 uint64_t ReclaimingIdDistributor::next_free(uint64_t n) const {
-    for (size_t i = n; i < free_map_.size(); ++i) {
-        if (free_map_[i])
-            return i;
+    if (n >= size_)
+        return size_;
+
+    // Bits past the end are zero, so no extra check is needed for the last word
+    size_t w = n / WORD_BITS, nwords = words(size_);
+    uint64_t word = free_map_[w].load(std::memory_order_relaxed) & (~0ULL << (n % WORD_BITS));
+    while (!word) {
+        if (++w == nwords)
+            return size_;
+        word = free_map_[w].load(std::memory_order_relaxed);
+    }
+
+    return w * WORD_BITS + __builtin_ctzll(word);
+}
+
+uint64_t ReclaimingIdDistributor::next_occupied(uint64_t n) const {
+    if (n >= size_)
+        return size_;
+
+    size_t w = n / WORD_BITS, nwords = words(size_);
+    uint64_t word = occupied_word(w) & (~0ULL << (n % WORD_BITS));
+    while (!word) {
+        if (++w == nwords)
+            return size_;
+        word = occupied_word(w);
     }
 
-    return free_map_.size();
+    return std::min<uint64_t>(w * WORD_BITS + __builtin_ctzll(word), size_);
 }
 
 void ReclaimingIdDistributor::resize(size_t sz) {
     //fprintf(stderr, "!!!RESIZE!!!! %llu\n", sz);
-    free_map_.resize(sz, true);
+    size_t nwords = words(sz);
+    std::unique_ptr<std::atomic<uint64_t>[]> free_map(new std::atomic<uint64_t>[nwords]);
+    std::unique_ptr<std::atomic<uint64_t>[]> retired_map(new std::atomic<uint64_t>[nwords]);
+    for (size_t w = 0; w < nwords; ++w) {
+        uint64_t word = (w < words(size_) ? free_map_[w].load(std::memory_order_relaxed) : 0);
+        retired_map[w].store(w < words(size_) ? retired_map_[w].load(std::memory_order_relaxed) : 0,
+                             std::memory_order_relaxed);
+        // Newly added ids are free, ids past the new end are dropped
+        uint64_t lo = std::max<uint64_t>(size_, w * WORD_BITS), hi = std::min<uint64_t>(sz, (w + 1) * WORD_BITS);
+        if (lo < hi)
+            word |= (hi - lo == WORD_BITS ? ~0ULL : (1ULL << (hi - lo)) - 1) << (lo % WORD_BITS);
+        if (hi < (w + 1) * WORD_BITS)
+            word &= ~(~0ULL << (hi % WORD_BITS));
+        free_map[w].store(word, std::memory_order_relaxed);
+    }
+
+    free_map_ = std::move(free_map);
+    retired_map_ = std::move(retired_map);
+    size_ = sz;
 }
 
 uint64_t ReclaimingIdDistributor::allocate(uint64_t offset) {
     // First hint: see if we could find any spot after last allocated
-    uint64_t hint = last_allocated_ + offset;
-    uint64_t n = next_free(hint);
-    if (n == free_map_.size()) {
-        // No luck, start from the beginning
-        n = next_free();
-    }
+    uint64_t hint = last_allocated_.load(std::memory_order_relaxed) + offset;
+    while (true) {
+        uint64_t n = next_free(hint);
+        if (n == size_) {
+            // No luck, start from the beginning
+            n = next_free();
+        }
 
-    // Still no luck, resize
-    if (n == free_map_.size())
-        resize(free_map_.size() * 2);
+        // Still no luck, resize. Retired ids are not reused until reclaimed, so
+        // the map could run out of ids while deleted elements are kept
+        if (n == size_) {
+            VERIFY_MSG(!omp_in_parallel(), "Ids ran out during parallel allocation, reserve them beforehand");
+            resize(std::max<size_t>(size_ * 2, 1));
+        }
 
-    last_allocated_ = n;
-    free_map_[n] = false;
-    return n + bias_;
+        // Claim the id, unless some other thread took it first
+        if (free_map_[n / WORD_BITS].fetch_and(~mask(n)) & mask(n)) {
+            last_allocated_.store(n, std::memory_order_relaxed);
+            return n + bias_;
+        }
+        hint = n;
+    }
 }
 
 size_t ReclaimingIdDistributor::free() const {
     size_t res = 0;
-    for (bool flag : free_map_)
-        res += flag;
+    for (size_t w = 0; w < words(size_); ++w)
+        res += __builtin_popcountll(free_map_[w].load(std::memory_order_relaxed));
     return res;
 }
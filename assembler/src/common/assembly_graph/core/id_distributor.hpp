@@ -9,17 +9,30 @@
 #include "adt/iterator_range.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
-#include <vector>
+#include <atomic>
+#include <memory>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 
 namespace omnigraph {
 
+// Free ids are tracked by a bitmap of atomic words (set bit == free id), so
+// acquire(), release() and allocate() never lock and could be called concurrently.
+// Growing the map (resize() or allocate() with no free ids left) is not thread-safe.
 class ReclaimingIdDistributor {
+    static constexpr size_t WORD_BITS = 64;
+
+    static size_t words(size_t sz) {
+        return (sz + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    static uint64_t mask(uint64_t n) {
+        return 1ULL << (n % WORD_BITS);
+    }
+
   public:
     ReclaimingIdDistributor(uint64_t bias = 0, size_t initial_size = 1)
-            : last_allocated_(0), bias_(bias) {
+            : last_allocated_(0), bias_(bias), size_(0) {
         resize(initial_size);
     }
 
@@ -27,21 +40,42 @@ class ReclaimingIdDistributor {
     uint64_t allocate(uint64_t offset = 0);
     size_t free() const;
     size_t size() const {
-        return free_map_.size();
+        return size_;
     }
     uint64_t max_id() const { return size() + bias_; }
     bool occupied(uint64_t at) const {
-        return !free_map_[at - bias_];
+        at -= bias_;
+        return occupied_word(at / WORD_BITS) & mask(at);
     }
     void acquire(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
-        free_map_[at - bias_] = false;
+        at -= bias_;
+        free_map_[at / WORD_BITS].fetch_and(~mask(at));
     }
     void release(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
-        free_map_[at - bias_] = true;
+        at -= bias_;
+        free_map_[at / WORD_BITS].fetch_or(mask(at));
+    }
+    // Retired ids are not occupied, but stay taken until reclaimed
+    void retire(uint64_t at) {
+        at -= bias_;
+        retired_map_[at / WORD_BITS].fetch_or(mask(at));
+    }
+    bool retired(uint64_t at) const {
+        at -= bias_;
+        return retired_map_[at / WORD_BITS].load(std::memory_order_relaxed) & mask(at);
+    }
+    // Calls f for every retired id and makes it free afterwards
+    template<class F>
+    void reclaim(F f) {
+        for (size_t w = 0; w < words(size_); ++w) {
+            uint64_t word = retired_map_[w].load(std::memory_order_relaxed);
+            for (; word; word &= word - 1) {
+                uint64_t bit = word & -word;
+                f(w * WORD_BITS + __builtin_ctzll(word) + bias_);
+                free_map_[w].fetch_or(bit);
+                retired_map_[w].fetch_and(~bit);
+            }
+        }
     }
 
     void clear_state(void) { last_allocated_ = 0; }
@@ -52,10 +86,9 @@ class ReclaimingIdDistributor {
                                                       uint64_t> {
       public:
         id_iterator(uint64_t start,
-                    const std::vector<bool> &map,
-                    uint64_t bias)
-                : map_(map), bias_(bias), cur_(start) {
-            if (cur_ != NPOS && map_.get()[cur_])
+                    const ReclaimingIdDistributor &map)
+                : map_(&map), cur_(start) {
+            if (cur_ != NPOS && (cur_ >= map_->size() || !map_->occupied(cur_ + map_->bias_)))
                 cur_ = next_occupied(cur_);
         }
 
@@ -63,15 +96,12 @@ class ReclaimingIdDistributor {
         friend class boost::iterator_core_access;
 
         uint64_t dereference() const {
-            return cur_ + bias_;
+            return cur_ + map_->bias_;
         }
 
         uint64_t next_occupied(uint64_t n) const {
-            for (size_t i = n + 1; i < map_.get().size(); ++i) {
-                if (!map_.get()[i])
-                    return i;
-            }
-            return NPOS;
+            uint64_t next = map_->next_occupied(n + 1);
+            return next == map_->size() ? NPOS : next;
         }
 
         void increment() {
@@ -87,15 +117,15 @@ class ReclaimingIdDistributor {
 
       private:
         static const uint64_t NPOS = -1ULL;
-        std::reference_wrapper<const std::vector<bool>> map_;
-        uint64_t bias_, cur_;
+        const ReclaimingIdDistributor *map_;
+        uint64_t cur_;
     };
 
     id_iterator begin() const {
-        return id_iterator(0, free_map_, bias_);
+        return id_iterator(0, *this);
     }
     id_iterator end() const {
-        return id_iterator(-1ULL, free_map_, bias_);
+        return id_iterator(-1ULL, *this);
     }
     adt::iterator_range<id_iterator> ids() const {
         return adt::make_range(begin(), end());
@@ -105,11 +135,20 @@ class ReclaimingIdDistributor {
   private:
     friend class id_iterator;
 
+    // Both return size() if there is no such id
     uint64_t next_free(uint64_t n = 0) const;
+    uint64_t next_occupied(uint64_t n) const;
+    // Bits of the ids which are taken and not retired
+    uint64_t occupied_word(size_t w) const {
+        return ~free_map_[w].load(std::memory_order_relaxed) & ~retired_map_[w].load(std::memory_order_relaxed);
+    }
 
-    uint64_t last_allocated_;
+    std::atomic<uint64_t> last_allocated_;
     uint64_t bias_;
-    std::vector<bool> free_map_;
+    size_t size_;
+    // Bits past size_ are always zero
+    std::unique_ptr<std::atomic<uint64_t>[]> free_map_;
+    std::unique_ptr<std::atomic<uint64_t>[]> retired_map_;
 };
 
 }
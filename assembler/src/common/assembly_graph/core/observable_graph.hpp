@@ -8,9 +8,12 @@
 #pragma once
 
 #include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <set>
 #include <cstring>
@@ -40,6 +43,53 @@ private:
    mutable std::vector<Handler*> action_handler_list_;
    std::unique_ptr<const HandlerApplier<VertexId, EdgeId>> applier_;
 
+    enum class EventType : uint8_t {
+        AddVertex, AddEdge, DeleteVertex, DeleteEdge, Merge, Glue, Split
+    };
+
+    // Int ids of the event arguments; a merge refers to its path in Journal::paths
+    // as (new edge, path index, journal index). Bit i of attached is set if
+    // deferred_handlers_[i] was attached when the event was fired.
+    struct Event {
+        uint64_t seq;
+        EventType type;
+        uint64_t id1, id2, id3;
+        uint64_t attached;
+    };
+
+    static constexpr size_t MAX_DEFERRED_HANDLERS = 64;
+
+    // Events fired by a single thread
+    struct Journal {
+        std::vector<Event> events;
+        std::vector<std::vector<EdgeId>> paths;
+    };
+
+    bool journaling_ = false;
+    size_t batch_size_ = 0;
+    mutable std::vector<Journal> journals_;
+    mutable std::atomic<uint64_t> event_seq_{0};
+    uint64_t flushed_seq_ = 0;
+    // Handlers getting the events from the journal, the ones added since the
+    // last flush get them right away. Removed handlers are nulled, so that the
+    // positions stay valid until the next flush.
+    mutable std::vector<Handler*> deferred_handlers_;
+    bool deferred_limit_warned_ = false;
+
+    bool IsDeferred(const Handler *handler) const {
+        return journaling_ &&
+               std::find(deferred_handlers_.begin(), deferred_handlers_.end(), handler) != deferred_handlers_.end();
+    }
+
+    void Record(EventType type, uint64_t id1, uint64_t id2 = 0, uint64_t id3 = 0) const;
+
+    void Deliver(Handler &handler, const Event &event) const;
+
+    void MaybeFlushEvents() {
+        if (journaling_ && !omp_in_parallel() && event_seq_ - flushed_seq_ >= batch_size_)
+            FlushEvents();
+    }
+
 public:
 //todo move to graph core
     typedef ConstructionHelper<DataMaster> HelperT;
@@ -82,6 +132,24 @@ public:
 
     bool VerifyAllDetached();
 
+    /**
+     * Starts journaling the events for the attached deferrable handlers (see
+     * ActionHandler::IsDeferrable), the rest keep getting them right away.
+     * The journaled events are handled once batch_size of them are collected,
+     * on FlushEvents() and on StopJournaling(). Deleted vertices and edges are
+     * unlinked at once, but are kept for the handlers until then. Their ids are
+     * not reused meanwhile, so vertices and edges created in parallel need the
+     * storage to be reserved for them (see GraphCore::reserve).
+     */
+    void StartJournaling(size_t batch_size = 1 << 16);
+
+    // Must be called before the deferrable handlers are queried
+    void FlushEvents();
+
+    void StopJournaling();
+
+    bool journaling() const { return journaling_; }
+
     //smart iterators
     template<typename Priority>
     SmartVertexIterator<ObservableGraph, Priority> SmartVertexBegin(
@@ -163,6 +231,7 @@ typename ObservableGraph<DataMaster>::VertexId
 ObservableGraph<DataMaster>::AddVertex(const VertexData &data, VertexId id1, VertexId id2) {
     VertexId v = base::HiddenAddVertex(data, id1, id2);
     FireAddVertex(v);
+    MaybeFlushEvents();
     return v;
 }
 
@@ -172,6 +241,7 @@ void ObservableGraph<DataMaster>::DeleteVertex(VertexId v) {
     VERIFY(v != VertexId());
     FireDeleteVertex(v);
     base::HiddenDeleteVertex(v);
+    MaybeFlushEvents();
 }
 
 template<class DataMaster>
@@ -187,6 +257,7 @@ ObservableGraph<DataMaster>::AddEdge(VertexId v1, VertexId v2, const EdgeData &d
                                      EdgeId id1, EdgeId id2) {
     EdgeId e = base::HiddenAddEdge(v1, v2, data, id1, id2);
     FireAddEdge(e);
+    MaybeFlushEvents();
     return e;
 }
 
@@ -195,6 +266,7 @@ typename ObservableGraph<DataMaster>::EdgeId
 ObservableGraph<DataMaster>::AddEdge(const EdgeData& data, EdgeId id1, EdgeId id2) {
     EdgeId e = base::HiddenAddEdge(data, id1, id2);
     FireAddEdge(e);
+    MaybeFlushEvents();
     return e;
 }
 
@@ -202,6 +274,7 @@ template<class DataMaster>
 void ObservableGraph<DataMaster>::DeleteEdge(EdgeId e) {
     FireDeleteEdge(e);
     base::HiddenDeleteEdge(e);
+    MaybeFlushEvents();
 }
 
 template<class DataMaster>
@@ -286,6 +359,8 @@ bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_hand
         auto it = std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler);
         if (it != action_handler_list_.end()) {
             action_handler_list_.erase(it);
+            std::replace(deferred_handlers_.begin(), deferred_handlers_.end(),
+                         const_cast<Handler*>(action_handler), (Handler*) nullptr);
             TRACE("Action handler " << action_handler->name() << " removed");
             result = true;
         } else {
@@ -298,7 +373,7 @@ bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_hand
 template<class DataMaster>
 bool ObservableGraph<DataMaster>::AllHandlersThreadSafe() const {
     for (Handler* handler : action_handler_list_) {
-        if (handler->IsAttached() && !handler->IsThreadSafe()) {
+        if (handler->IsAttached() && !handler->IsThreadSafe() && !IsDeferred(handler)) {
             return false;
         }
     }
@@ -324,66 +399,194 @@ void ObservableGraph<DataMaster>::FireGameOver() const {
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !IsDeferred(handler_ptr)) {
             TRACE("FireAddVertex to handler " << handler_ptr->name());
             applier_->ApplyAdd(*handler_ptr, v);
         }
     }
+    if (journaling_)
+        Record(EventType::AddVertex, v.int_id());
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !IsDeferred(handler_ptr)) {
             TRACE("FireAddEdge to handler " << handler_ptr->name());
             applier_->ApplyAdd(*handler_ptr, e);
         }
     }
+    if (journaling_)
+        Record(EventType::AddEdge, e.int_id());
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
-        if ((*it)->IsAttached()) {
+        if ((*it)->IsAttached() && !IsDeferred(*it)) {
             applier_->ApplyDelete(**it, v);
         }
     }
+    if (journaling_)
+        Record(EventType::DeleteVertex, v.int_id());
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
-        if ((*it)->IsAttached()) {
+        if ((*it)->IsAttached() && !IsDeferred(*it)) {
             applier_->ApplyDelete(**it, e);
         }
     };
+    if (journaling_)
+        Record(EventType::DeleteEdge, e.int_id());
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !IsDeferred(handler_ptr)) {
             applier_->ApplyMerge(*handler_ptr, old_edges, new_edge);
         }
     }
+    if (journaling_) {
+        size_t thread = omp_get_thread_num();
+        auto &paths = journals_[thread].paths;
+        paths.push_back(old_edges);
+        Record(EventType::Merge, new_edge.int_id(), paths.size() - 1, thread);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !IsDeferred(handler_ptr)) {
             applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2);
         }
     };
+    if (journaling_)
+        Record(EventType::Glue, new_edge.int_id(), edge1.int_id(), edge2.int_id());
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !IsDeferred(handler_ptr)) {
             applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2);
         }
     }
+    if (journaling_)
+        Record(EventType::Split, edge.int_id(), new_edge1.int_id(), new_edge2.int_id());
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::Record(EventType type, uint64_t id1, uint64_t id2, uint64_t id3) const {
+    size_t thread = omp_get_thread_num();
+    VERIFY(thread < journals_.size());
+    uint64_t attached = 0;
+    for (size_t i = 0; i < deferred_handlers_.size(); ++i) {
+        if (deferred_handlers_[i] && deferred_handlers_[i]->IsAttached())
+            attached |= 1ULL << i;
+    }
+    journals_[thread].events.push_back({event_seq_++, type, id1, id2, id3, attached});
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::Deliver(Handler &handler, const Event &event) const {
+    switch (event.type) {
+        case EventType::AddVertex:
+            applier_->ApplyAdd(handler, VertexId(event.id1));
+            break;
+        case EventType::AddEdge:
+            applier_->ApplyAdd(handler, EdgeId(event.id1));
+            break;
+        case EventType::DeleteVertex:
+            applier_->ApplyDelete(handler, VertexId(event.id1));
+            break;
+        case EventType::DeleteEdge:
+            applier_->ApplyDelete(handler, EdgeId(event.id1));
+            break;
+        case EventType::Merge:
+            applier_->ApplyMerge(handler, journals_[event.id3].paths[event.id2], EdgeId(event.id1));
+            break;
+        case EventType::Glue:
+            applier_->ApplyGlue(handler, EdgeId(event.id1), EdgeId(event.id2), EdgeId(event.id3));
+            break;
+        case EventType::Split:
+            applier_->ApplySplit(handler, EdgeId(event.id1), EdgeId(event.id2), EdgeId(event.id3));
+            break;
+    }
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::StartJournaling(size_t batch_size) {
+    VERIFY(!journaling_);
+    VERIFY(batch_size > 0);
+    journals_.resize(omp_get_max_threads());
+    batch_size_ = batch_size;
+    flushed_seq_ = event_seq_;
+    deferred_limit_warned_ = false;
+    base::KeepDeleted(true);
+    journaling_ = true;
+    FlushEvents();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FlushEvents() {
+    if (!journaling_)
+        return;
+
+    VERIFY(!omp_in_parallel());
+    std::vector<const Event*> events;
+    for (const auto &journal : journals_)
+        for (const auto &event : journal.events)
+            events.push_back(&event);
+    std::sort(events.begin(), events.end(),
+              [](const Event *a, const Event *b) { return a->seq < b->seq; });
+
+    // The handlers are independent, so they could consume the batch concurrently.
+    // Each one gets only the events fired while it was attached.
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < deferred_handlers_.size(); ++i) {
+        if (!deferred_handlers_[i])
+            continue;
+        Handler &handler = *deferred_handlers_[i];
+        for (const Event *event : events) {
+            if (event->attached & (1ULL << i))
+                Deliver(handler, *event);
+        }
+    }
+
+    for (auto &journal : journals_) {
+        journal.events.clear();
+        journal.paths.clear();
+    }
+    flushed_seq_ = event_seq_;
+    base::PurgeDeleted();
+
+    // Handlers beyond the limit keep getting the events right away
+    deferred_handlers_.clear();
+    for (Handler *handler : action_handler_list_) {
+        if (!handler->IsAttached() || !handler->IsDeferrable())
+            continue;
+        if (deferred_handlers_.size() < MAX_DEFERRED_HANDLERS) {
+            deferred_handlers_.push_back(handler);
+        } else if (!deferred_limit_warned_) {
+            WARN("More than " << MAX_DEFERRED_HANDLERS << " deferrable handlers are attached, "
+                 << handler->name() << " and the following ones are not deferred");
+            deferred_limit_warned_ = true;
+        }
+    }
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::StopJournaling() {
+    VERIFY(journaling_);
+    FlushEvents();
+    journaling_ = false;
+    deferred_handlers_.clear();
+    journals_.clear();
+    base::KeepDeleted(false);
 }
 
 template<class DataMaster>
@@ -413,6 +616,8 @@ void ObservableGraph<DataMaster>::clear() {
 
 template<class DataMaster>
 ObservableGraph<DataMaster>::~ObservableGraph<DataMaster>() {
+    if (journaling_)
+        StopJournaling();
     FireGameOver();
     clear();
 }
@@ -468,6 +673,7 @@ typename ObservableGraph<DataMaster>::EdgeId
     FireDeletePath(edges_to_delete, vertices_to_delete);
     FireAddEdge(new_edge);
     base::HiddenDeletePath(edges_to_delete, vertices_to_delete);
+    MaybeFlushEvents();
     return new_edge;
 }
 
@@ -488,6 +694,7 @@ std::pair<typename ObservableGraph<DataMaster>::EdgeId, typename ObservableGraph
     FireAddEdge(new_edge1);
     FireAddEdge(new_edge2);
     base::HiddenDeleteEdge(edge);
+    MaybeFlushEvents();
     return {new_edge1, new_edge2};
 }
 
@@ -510,7 +717,27 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
         DeleteVertex(end);
     }
     DEBUG("Delete vertex");
+    MaybeFlushEvents();
     return new_edge;
 }
 
+// Journals the graph events within the scope, unless they are journaled already
+template<class Graph>
+class EventJournalScope {
+    Graph &g_;
+    bool started_;
+
+public:
+    explicit EventJournalScope(Graph &g, size_t batch_size = 1 << 16)
+            : g_(g), started_(!g.journaling()) {
+        if (started_)
+            g_.StartJournaling(batch_size);
+    }
+
+    ~EventJournalScope() {
+        if (started_)
+            g_.StopJournaling();
+    }
+};
+
 } // namespace omnigraph
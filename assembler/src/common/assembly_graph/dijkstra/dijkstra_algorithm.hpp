@@ -7,62 +7,25 @@
 #pragma once
 
 #include "dijkstra_settings.hpp"
+#include "dijkstra_storage.hpp"
 
 #include "utils/stl_utils.hpp"
 #include "utils/logger/logger.hpp"
 
-#include <parallel_hashmap/phmap.h>
-
-#include <queue>
 #include <vector>
 
 namespace omnigraph {
 
-template<typename Graph, typename distance_t = size_t>
-struct element_t {
-    typedef typename Graph::VertexId VertexId;
-    typedef typename Graph::EdgeId EdgeId;
-
-    distance_t distance;
-    VertexId curr_vertex;
-    VertexId prev_vertex;
-    EdgeId edge_between;
-
-    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
-              EdgeId new_edge_between) noexcept
-            : distance(new_distance),
-              curr_vertex(new_cur_vertex), prev_vertex(new_prev_vertex),
-              edge_between(new_edge_between) { }
-};
-
-template<typename T>
-class ReverseDistanceComparator {
-public:
-    ReverseDistanceComparator() {}
-
-    bool operator()(T obj1, T obj2) const {
-        if (obj1.distance != obj2.distance)
-            return obj2.distance < obj1.distance;
-        if (obj2.curr_vertex != obj1.curr_vertex)
-            return obj2.curr_vertex < obj1.curr_vertex;
-        if (obj2.prev_vertex != obj1.prev_vertex)
-            return obj2.prev_vertex < obj1.prev_vertex;
-        return obj2.edge_between < obj1.edge_between;
-    }
-};
-
-template<class Graph, class DijkstraSettings, typename distance_t = size_t>
+// Storage keeps distances, processed vertices, traceback and the queue,
+// see HashedDijkstraStorage and DenseDijkstraStorage
+template<class Graph, class DijkstraSettings, typename distance_t = size_t,
+         class Storage = HashedDijkstraStorage<Graph, distance_t>>
 class Dijkstra {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
     typedef distance_t DistanceType;
     using queue_element = element_t<Graph, distance_t>;
-
-    typedef phmap::flat_hash_map<VertexId, distance_t> distances_map;
-    typedef typename distances_map::const_iterator distances_map_ci;
-    typedef typename std::priority_queue<queue_element,
-                                         std::vector<queue_element>,
-                                         ReverseDistanceComparator<queue_element>> queue_t;
+    typedef DijkstraQueue<queue_element> queue_t;
     // constructor parameters
     const Graph& graph_;
     DijkstraSettings settings_;
@@ -75,20 +38,16 @@ class Dijkstra {
     bool vertex_limit_exceeded_;
 
     // accumulative structures
-    distances_map distances_;
-    phmap::flat_hash_set<VertexId> processed_vertices_;
-    phmap::flat_hash_map<VertexId, std::pair<VertexId, EdgeId>> prev_vert_map_;
+    Storage storage_;
 
     void Init(VertexId start, queue_t &queue) {
         vertex_number_ = 0;
-        distances_.clear();
-        processed_vertices_.clear();
-        prev_vert_map_.clear();
+        storage_.Init(graph_);
         set_finished(false);
         settings_.Init(start);
         queue.push(queue_element(0, start, VertexId(), EdgeId()));
         if (collect_traceback_)
-            prev_vert_map_[start] = std::pair<VertexId, EdgeId>(VertexId(), EdgeId());
+            storage_.SetPrev(start, VertexId(), EdgeId());
     }
 
     void set_finished(bool state) {
@@ -154,37 +113,34 @@ public:
     }
 
     bool DistanceCounted(VertexId vertex) const {
-        return distances_.count(vertex);
+        return storage_.DistanceCounted(vertex);
     }
 
     distance_t GetDistance(VertexId vertex) const {
-        auto it = distances_.find(vertex);
-        VERIFY(it != distances_.end());
-        return it->second;
+        return storage_.GetDistance(vertex);
     }
 
     void Run(VertexId start) {
         TRACE("Starting dijkstra run from vertex " << graph_.str(start));
-        queue_t queue;
+        queue_t &queue = storage_.queue();
         Init(start, queue);
         TRACE("Priority queue initialized. Starting search");
 
         while (!queue.empty() && !finished()) {
             // TRACE("Dijkstra iteration started");
-            const auto& next = queue.top();
+            queue_element next = queue.pop();
             distance_t distance = next.distance;
             VertexId vertex = next.curr_vertex;
 
             if (collect_traceback_)
-                prev_vert_map_[vertex] = std::pair<VertexId, EdgeId>(next.prev_vertex, next.edge_between);
-            queue.pop();
+                storage_.SetPrev(vertex, next.prev_vertex, next.edge_between);
             // TRACE("Vertex " << graph_.str(vertex) << " with distance " << distance << " fetched from queue");
 
             if (DistanceCounted(vertex)) {
                 // TRACE("Distance to vertex " << graph_.str(vertex) << " already counted. Proceeding to next queue entry.");
                 continue;
             }
-            distances_.emplace(vertex, distance);
+            storage_.SetDistance(vertex, distance);
 
             // TRACE("Vertex " << graph_.str(vertex) << " is found to be at distance "
             //       << distance << " from vertex " << graph_.str(start));
@@ -192,7 +148,7 @@ public:
                 // TRACE("Check for processing vertex failed. Proceeding to the next queue entry.");
                 continue;
             }
-            processed_vertices_.insert(vertex);
+            storage_.SetProcessed(vertex);
             AddNeighboursToQueue(vertex, distance, queue);
         }
         set_finished(true);
@@ -202,39 +158,37 @@ public:
     std::vector<EdgeId> GetShortestPathTo(VertexId vertex) {
         VERIFY_MSG(collect_traceback_, "GetShortestPathTo() is available only if traceback is collected");
         std::vector<EdgeId> path;
-        if (prev_vert_map_.find(vertex) == prev_vert_map_.end())
+        std::pair<VertexId, EdgeId> prev_v_e;
+        if (!storage_.GetPrev(vertex, prev_v_e))
             return path;
 
-        VertexId curr_vertex = vertex;
-        VertexId prev_vertex = utils::get(prev_vert_map_, vertex).first;
-        EdgeId edge = utils::get(prev_vert_map_, curr_vertex).second;
-
-        while (prev_vertex != VertexId()) {
+        while (prev_v_e.first != VertexId()) {
+            VertexId prev_vertex = prev_v_e.first;
+            EdgeId edge = prev_v_e.second;
             if (graph_.EdgeStart(edge) == prev_vertex)
                 path.insert(path.begin(), edge);
             else
                 path.push_back(edge);
-            curr_vertex = prev_vertex;
-            const auto& prev_v_e = utils::get(prev_vert_map_, curr_vertex);
-            prev_vertex = prev_v_e.first;
-            edge = prev_v_e.second;
+            bool traced = storage_.GetPrev(prev_vertex, prev_v_e);
+            VERIFY_MSG(traced, "No traceback for vertex " << graph_.str(prev_vertex));
         }
         return path;
     }
 
     std::vector<VertexId> ReachedVertices() const {
-        std::vector<VertexId> result;
-        result.reserve(distances_.size());
-
-        for (const auto &el : distances_)
-            result.push_back(el.first);
+        std::vector<VertexId> result = storage_.ReachedVertices();
         std::sort(result.begin(), result.end());
 
         return result;
     }
 
-    const auto& ProcessedVertices() const {
-        return processed_vertices_;
+    bool IsProcessed(VertexId vertex) const {
+        return storage_.IsProcessed(vertex);
+    }
+
+    // Every storage lists processed vertices in the order of processing
+    const std::vector<VertexId> &ProcessedVertices() const {
+        return storage_.ProcessedVertices();
     }
 
     bool VertexLimitExceeded() const {
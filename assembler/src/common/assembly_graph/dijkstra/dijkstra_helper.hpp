@@ -39,11 +39,15 @@ public:
             ForwardNeighbourIteratorFactory<Graph> > BoundedDijkstraSettings;
 
     typedef Dijkstra<Graph, BoundedDijkstraSettings> BoundedDijkstra;
-
-    static BoundedDijkstra CreateBoundedDijkstra(const Graph &graph, size_t length_bound,
-                                                 size_t max_vertex_number = -1ul,
-                                                 bool collect_traceback = false) {
-        return BoundedDijkstra(graph,
+    // Keeps its state in a workspace from the per-thread pool, see DijkstraWorkspace
+    typedef Dijkstra<Graph, BoundedDijkstraSettings, size_t, DenseDijkstraStorage<Graph>> DenseBoundedDijkstra;
+
+    template<class Storage = HashedDijkstraStorage<Graph>>
+    static Dijkstra<Graph, BoundedDijkstraSettings, size_t, Storage>
+    CreateBoundedDijkstra(const Graph &graph, size_t length_bound,
+                          size_t max_vertex_number = -1ul,
+                          bool collect_traceback = false) {
+        return Dijkstra<Graph, BoundedDijkstraSettings, size_t, Storage>(graph,
                                BoundedDijkstraSettings(
                                    LengthCalculator<Graph>(graph),
                                    BoundProcessChecker<Graph>(length_bound),
@@ -93,11 +97,12 @@ public:
 
     typedef Dijkstra<Graph, UnorientedBoundedDijkstraSettings> UnorientedBoundedDijkstra;
 
-    static UnorientedBoundedDijkstra
+    template<class Storage = HashedDijkstraStorage<Graph>>
+    static Dijkstra<Graph, UnorientedBoundedDijkstraSettings, size_t, Storage>
     CreateUnorientedBoundedDijkstra(const Graph &graph,
                                   size_t bound,
                                   size_t max_vertex_number = size_t(-1)) {
-        return UnorientedBoundedDijkstra(graph,
+        return Dijkstra<Graph, UnorientedBoundedDijkstraSettings, size_t, Storage>(graph,
                                        UnorientedBoundedDijkstraSettings(
                                                LengthCalculator<Graph>(graph),
                                                BoundProcessChecker<Graph>(bound),
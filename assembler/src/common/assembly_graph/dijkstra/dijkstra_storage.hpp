@@ -0,0 +1,347 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace omnigraph {
+
+template<typename Graph, typename distance_t = size_t>
+struct element_t {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    distance_t distance;
+    VertexId curr_vertex;
+    VertexId prev_vertex;
+    EdgeId edge_between;
+
+    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
+              EdgeId new_edge_between) noexcept
+            : distance(new_distance),
+              curr_vertex(new_cur_vertex), prev_vertex(new_prev_vertex),
+              edge_between(new_edge_between) { }
+};
+
+template<typename T>
+class ReverseDistanceComparator {
+public:
+    ReverseDistanceComparator() {}
+
+    bool operator()(T obj1, T obj2) const {
+        if (obj1.distance != obj2.distance)
+            return obj2.distance < obj1.distance;
+        if (obj2.curr_vertex != obj1.curr_vertex)
+            return obj2.curr_vertex < obj1.curr_vertex;
+        if (obj2.prev_vertex != obj1.prev_vertex)
+            return obj2.prev_vertex < obj1.prev_vertex;
+        return obj2.edge_between < obj1.edge_between;
+    }
+};
+
+// Binary heap on top of a vector, so its memory could be kept between the runs
+template<typename T>
+class DijkstraQueue {
+    std::vector<T> heap_;
+    ReverseDistanceComparator<T> comparator_;
+
+public:
+    bool empty() const { return heap_.empty(); }
+    void clear() { heap_.clear(); }
+
+    void push(const T &element) {
+        heap_.push_back(element);
+        std::push_heap(heap_.begin(), heap_.end(), comparator_);
+    }
+
+    T pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), comparator_);
+        T top = heap_.back();
+        heap_.pop_back();
+        return top;
+    }
+};
+
+// Dijkstra state kept in hash maps, allocated anew for every Dijkstra instance
+template<class Graph, typename distance_t = size_t>
+class HashedDijkstraStorage {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    phmap::flat_hash_map<VertexId, distance_t> distances_;
+    phmap::flat_hash_set<VertexId> processed_set_;
+    std::vector<VertexId> processed_vertices_;
+    phmap::flat_hash_map<VertexId, std::pair<VertexId, EdgeId>> prev_vert_map_;
+    DijkstraQueue<element_t<Graph, distance_t>> queue_;
+
+public:
+    void Init(const Graph &) {
+        distances_.clear();
+        processed_set_.clear();
+        processed_vertices_.clear();
+        prev_vert_map_.clear();
+        queue_.clear();
+    }
+
+    DijkstraQueue<element_t<Graph, distance_t>> &queue() { return queue_; }
+
+    bool DistanceCounted(VertexId vertex) const {
+        return distances_.count(vertex);
+    }
+
+    distance_t GetDistance(VertexId vertex) const {
+        auto it = distances_.find(vertex);
+        VERIFY(it != distances_.end());
+        return it->second;
+    }
+
+    void SetDistance(VertexId vertex, distance_t distance) {
+        distances_.emplace(vertex, distance);
+    }
+
+    void SetProcessed(VertexId vertex) {
+        if (processed_set_.insert(vertex).second)
+            processed_vertices_.push_back(vertex);
+    }
+
+    bool IsProcessed(VertexId vertex) const {
+        return processed_set_.count(vertex);
+    }
+
+    // In the order of processing
+    const std::vector<VertexId> &ProcessedVertices() const {
+        return processed_vertices_;
+    }
+
+    void SetPrev(VertexId vertex, VertexId prev_vertex, EdgeId edge) {
+        prev_vert_map_[vertex] = std::make_pair(prev_vertex, edge);
+    }
+
+    // false if there is no traceback for the vertex
+    bool GetPrev(VertexId vertex, std::pair<VertexId, EdgeId> &prev) const {
+        auto it = prev_vert_map_.find(vertex);
+        if (it == prev_vert_map_.end())
+            return false;
+
+        prev = it->second;
+        return true;
+    }
+
+    std::vector<VertexId> ReachedVertices() const {
+        std::vector<VertexId> result;
+        result.reserve(distances_.size());
+        for (const auto &el : distances_)
+            result.push_back(el.first);
+
+        return result;
+    }
+};
+
+// Dense per-vertex arrays indexed by vertex int ids. Instead of being cleared
+// before every run they are invalidated by bumping the epoch, so bounded runs
+// cost only the vertices they visit. Workspaces are pooled per thread (see
+// DenseDijkstraStorage), so after a warm-up the runs do not allocate.
+template<class Graph, typename distance_t = size_t>
+class DijkstraWorkspace {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    struct VertexState {
+        uint32_t reached = 0;
+        uint32_t processed = 0;
+        distance_t distance;
+    };
+
+    // Traceback is rarely collected, so it is kept apart not to dilute the cache
+    struct VertexTrace {
+        uint32_t traced = 0;
+        VertexId prev_vertex;
+        EdgeId prev_edge;
+    };
+
+    std::vector<VertexState> states_;
+    std::vector<VertexTrace> traces_;
+    std::vector<VertexId> reached_vertices_;
+    std::vector<VertexId> processed_vertices_;
+    DijkstraQueue<element_t<Graph, distance_t>> queue_;
+    uint32_t epoch_ = 0;
+
+    template<class T>
+    static const T *Find(const std::vector<T> &v, VertexId vertex) {
+        size_t id = vertex.int_id();
+        return id < v.size() ? &v[id] : nullptr;
+    }
+
+    // Drops the memory kept for the vertex ids which are far beyond the current
+    // graph, e.g. after the previous graph was bigger
+    template<class T>
+    static void Fit(std::vector<T> &v, size_t id_bound) {
+        if (v.capacity() <= 2 * id_bound)
+            return;
+        v.resize(std::min(v.size(), id_bound));
+        v.shrink_to_fit();
+    }
+
+    template<class T>
+    static T &Get(std::vector<T> &v, VertexId vertex) {
+        size_t id = vertex.int_id();
+        if (id >= v.size())
+            v.resize(std::max(id + 1, 2 * v.size()));
+        return v[id];
+    }
+
+    struct Releaser {
+        void operator()(DijkstraWorkspace *workspace) const {
+            Pool().emplace_back(workspace);
+        }
+    };
+
+    static std::vector<std::unique_ptr<DijkstraWorkspace>> &Pool() {
+        static thread_local std::vector<std::unique_ptr<DijkstraWorkspace>> pool;
+        return pool;
+    }
+
+public:
+    typedef std::unique_ptr<DijkstraWorkspace, Releaser> Lease;
+
+    // Takes a free workspace of the calling thread, it returns to the pool of
+    // the thread destroying the lease
+    static Lease Acquire() {
+        auto &pool = Pool();
+        if (pool.empty())
+            return Lease(new DijkstraWorkspace());
+
+        Lease workspace(pool.back().release());
+        pool.pop_back();
+        return workspace;
+    }
+
+    // Vertex ids of the graph should be less than id_bound
+    void Init(size_t id_bound) {
+        Fit(states_, id_bound);
+        Fit(traces_, id_bound);
+        Fit(reached_vertices_, id_bound);
+        Fit(processed_vertices_, id_bound);
+        if (++epoch_ == 0) {
+            for (auto &state : states_)
+                state.reached = state.processed = 0;
+            for (auto &trace : traces_)
+                trace.traced = 0;
+            epoch_ = 1;
+        }
+        reached_vertices_.clear();
+        processed_vertices_.clear();
+        queue_.clear();
+    }
+
+    DijkstraQueue<element_t<Graph, distance_t>> &queue() { return queue_; }
+
+    bool DistanceCounted(VertexId vertex) const {
+        const VertexState *state = Find(states_, vertex);
+        return state && state->reached == epoch_;
+    }
+
+    distance_t GetDistance(VertexId vertex) const {
+        VERIFY(DistanceCounted(vertex));
+        return Find(states_, vertex)->distance;
+    }
+
+    void SetDistance(VertexId vertex, distance_t distance) {
+        VertexState &state = Get(states_, vertex);
+        if (state.reached == epoch_)
+            return;
+
+        state.reached = epoch_;
+        state.distance = distance;
+        reached_vertices_.push_back(vertex);
+    }
+
+    void SetProcessed(VertexId vertex) {
+        VertexState &state = Get(states_, vertex);
+        if (state.processed == epoch_)
+            return;
+
+        state.processed = epoch_;
+        processed_vertices_.push_back(vertex);
+    }
+
+    bool IsProcessed(VertexId vertex) const {
+        const VertexState *state = Find(states_, vertex);
+        return state && state->processed == epoch_;
+    }
+
+    const std::vector<VertexId> &ProcessedVertices() const {
+        return processed_vertices_;
+    }
+
+    void SetPrev(VertexId vertex, VertexId prev_vertex, EdgeId edge) {
+        VertexTrace &trace = Get(traces_, vertex);
+        trace.traced = epoch_;
+        trace.prev_vertex = prev_vertex;
+        trace.prev_edge = edge;
+    }
+
+    bool GetPrev(VertexId vertex, std::pair<VertexId, EdgeId> &prev) const {
+        const VertexTrace *trace = Find(traces_, vertex);
+        if (!trace || trace->traced != epoch_)
+            return false;
+
+        prev = std::make_pair(trace->prev_vertex, trace->prev_edge);
+        return true;
+    }
+
+    const std::vector<VertexId> &ReachedVertices() const {
+        return reached_vertices_;
+    }
+};
+
+// Dijkstra state kept in a DijkstraWorkspace leased from the per-thread pool
+// for the lifetime of the Dijkstra instance
+template<class Graph, typename distance_t = size_t>
+class DenseDijkstraStorage {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef DijkstraWorkspace<Graph, distance_t> Workspace;
+
+    typename Workspace::Lease workspace_;
+
+public:
+    DenseDijkstraStorage()
+            : workspace_(Workspace::Acquire()) {}
+
+    void Init(const Graph &g) { workspace_->Init(g.min_id() + g.vreserved()); }
+
+    DijkstraQueue<element_t<Graph, distance_t>> &queue() { return workspace_->queue(); }
+
+    bool DistanceCounted(VertexId vertex) const { return workspace_->DistanceCounted(vertex); }
+    distance_t GetDistance(VertexId vertex) const { return workspace_->GetDistance(vertex); }
+    void SetDistance(VertexId vertex, distance_t distance) { workspace_->SetDistance(vertex, distance); }
+
+    void SetProcessed(VertexId vertex) { workspace_->SetProcessed(vertex); }
+    bool IsProcessed(VertexId vertex) const { return workspace_->IsProcessed(vertex); }
+    const std::vector<VertexId> &ProcessedVertices() const { return workspace_->ProcessedVertices(); }
+
+    void SetPrev(VertexId vertex, VertexId prev_vertex, EdgeId edge) {
+        workspace_->SetPrev(vertex, prev_vertex, edge);
+    }
+
+    bool GetPrev(VertexId vertex, std::pair<VertexId, EdgeId> &prev) const {
+        return workspace_->GetPrev(vertex, prev);
+    }
+
+    std::vector<VertexId> ReachedVertices() const {
+        return workspace_->ReachedVertices();
+    }
+};
+
+}
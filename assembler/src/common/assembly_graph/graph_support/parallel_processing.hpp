@@ -14,8 +14,13 @@
 #include "utils/perf/timetracer.hpp"
 #include "utils/logger/logger.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace omnigraph {
 
+// Reasonable number of candidates to be checked concurrently at once
+const size_t DEFAULT_PROCESSING_BATCH_SIZE = 1 << 12;
+
 template<class Graph, class ElementId>
 class InterestingElementFinder {
 protected:
@@ -316,16 +321,162 @@ public:
 };
 
 //FIXME only potentially relevant edges should be stored at any point
+/**
+ * If batch_size_ is positive, the candidates are checked concurrently in batches (see Check)
+ * and then committed one by one in the same order as the serial run would process them.
+ * Results of the checks are only used for the candidates with no changes in their
+ * neighbourhoods since the batch was formed, the others are processed from scratch.
+ * Thus the outcome does not depend on the number of threads.
+ */
 template<class Graph, class ElementId,
          class Priority = adt::identity>
 class PersistentProcessingAlgorithm : public PersistentAlgorithmBase<Graph> {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    // Collects the vertices affected by the graph changes and the deleted elements
+    class ChangeTracker : public GraphActionHandler<Graph> {
+        phmap::flat_hash_set<VertexId> touched_;
+        phmap::flat_hash_set<ElementId> deleted_;
+
+        void Retire(ElementId el) {
+            deleted_.insert(el);
+        }
+
+        template<class OtherId>
+        void Retire(OtherId) {}
+
+    public:
+        ChangeTracker(const Graph &g)
+                : GraphActionHandler<Graph>(g, "PersistentProcessingChangeTracker") {}
+
+        void HandleAdd(VertexId v) override {
+            touched_.insert(v);
+        }
+
+        void HandleAdd(EdgeId e) override {
+            touched_.insert(this->g().EdgeStart(e));
+            touched_.insert(this->g().EdgeEnd(e));
+        }
+
+        void HandleDelete(VertexId v) override {
+            touched_.insert(v);
+            Retire(v);
+        }
+
+        void HandleDelete(EdgeId e) override {
+            touched_.insert(this->g().EdgeStart(e));
+            touched_.insert(this->g().EdgeEnd(e));
+            Retire(e);
+        }
+
+        bool touched(const std::vector<VertexId> &vertices) const {
+            if (touched_.empty())
+                return false;
+            for (VertexId v : vertices) {
+                if (touched_.count(v))
+                    return true;
+            }
+            return false;
+        }
+
+        bool deleted(ElementId el) const {
+            return deleted_.count(el);
+        }
+
+        void clear() {
+            touched_.clear();
+            deleted_.clear();
+        }
+    };
+
 protected:
     typedef std::shared_ptr<InterestingElementFinder<Graph, ElementId>> CandidateFinderPtr;
     CandidateFinderPtr interest_el_finder_;
+    size_t batch_size_;
 
 private:
     SmartSetIterator<Graph, ElementId, Priority> it_;
+    const Priority priority_;
     const bool tracking_;
+    ChangeTracker changes_;
+
+    bool Precedes(ElementId el1, ElementId el2) const {
+        return std::make_pair(priority_(el1), el1) < std::make_pair(priority_(el2), el2);
+    }
+
+    // false if the proceed condition turned false on the current element
+    bool ProcessCurrent(size_t &triggered) {
+        ElementId el = *it_;
+        if (!Proceed(el)) {
+            TRACE("Proceed condition turned false on element " << this->g().str(el));
+            it_.ReleaseCurrent();
+            return false;
+        }
+        TRACE("Processing edge " << this->g().str(el));
+        if (Process(el))
+            triggered++;
+        ++it_;
+        return true;
+    }
+
+    size_t ProcessBatches() {
+        size_t triggered = 0;
+        std::vector<ElementId> batch;
+        std::vector<std::vector<VertexId>> neighbourhoods;
+        bool proceed = true;
+        while (proceed && !it_.IsEnd()) {
+            batch.clear();
+            for (; !it_.IsEnd() && batch.size() < batch_size_; ++it_)
+                batch.push_back(*it_);
+            neighbourhoods.resize(batch.size());
+
+            TRACE("Checking batch of " << batch.size() << " elements");
+            PrepareBatch(batch.size());
+            #pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < batch.size(); ++i) {
+                neighbourhoods[i].clear();
+                Check(batch[i], i, neighbourhoods[i]);
+            }
+
+            changes_.clear();
+            changes_.Attach();
+            for (size_t i = 0; i < batch.size(); ++i) {
+                ElementId el = batch[i];
+                if (changes_.deleted(el))
+                    continue;
+
+                // New elements preceding the current one go first, as in the serial run
+                while (proceed && !it_.IsEnd()) {
+                    if (!Precedes(*it_, el)) {
+                        it_.ReleaseCurrent();
+                        break;
+                    }
+                    proceed = ProcessCurrent(triggered);
+                }
+
+                if (proceed && !Proceed(el)) {
+                    TRACE("Proceed condition turned false on element " << this->g().str(el));
+                    proceed = false;
+                }
+
+                if (!proceed) {
+                    for (; i < batch.size(); ++i) {
+                        if (!changes_.deleted(batch[i]))
+                            it_.push(batch[i]);
+                    }
+                    break;
+                }
+
+                TRACE("Processing edge " << this->g().str(el));
+                if (changes_.touched(neighbourhoods[i]) ? Process(el) : Commit(el, i))
+                    triggered++;
+            }
+            changes_.Detach();
+        }
+        changes_.clear();
+        return triggered;
+    }
 
 protected:
     void ReturnForConsideration(ElementId el) {
@@ -336,18 +487,36 @@ protected:
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
 
+    // Batched processing, see the class description
+    virtual void PrepareBatch(size_t /*size*/) {}
+
+    /**
+     * Called concurrently for the elements of the batch, must not modify the graph.
+     * @param idx index of the element in the batch
+     * @param neighbourhood vertices, changes around which might affect the result of the check
+     */
+    virtual void Check(ElementId /*el*/, size_t /*idx*/, std::vector<VertexId> &/*neighbourhood*/) {}
+
+    // Applies the result of the check, which is still valid
+    virtual bool Commit(ElementId el, size_t /*idx*/) { return Process(el); }
+
 public:
 
     PersistentProcessingAlgorithm(Graph& g,
                                   CandidateFinderPtr interest_el_finder,
                                   bool canonical_only = false,
                                   const Priority& priority = Priority(),
-                                  bool track_changes = true) :
+                                  bool track_changes = true,
+                                  size_t batch_size = 0) :
             PersistentAlgorithmBase<Graph>(g),
             interest_el_finder_(interest_el_finder),
+            batch_size_(batch_size),
             it_(g, true, priority, canonical_only),
-            tracking_(track_changes) {
+            priority_(priority),
+            tracking_(track_changes),
+            changes_(g) {
         it_.Detach();
+        changes_.Detach();
     }
 
     size_t Run(bool force_primary_launch = false,
@@ -374,16 +543,10 @@ public:
 
         size_t triggered = 0;
         TRACE("Start processing");
-        for (; !it_.IsEnd(); ++it_) {
-            ElementId el = *it_;
-            if (!Proceed(el)) {
-                TRACE("Proceed condition turned false on element " << this->g().str(el));
-                it_.ReleaseCurrent();
-                break;
-            }
-            TRACE("Processing edge " << this->g().str(el));
-            if (Process(el))
-                triggered++;
+        if (batch_size_ > 0 && omp_get_max_threads() > 1) {
+            triggered = ProcessBatches();
+        } else {
+            while (!it_.IsEnd() && ProcessCurrent(triggered)) {}
         }
         TRACE("Finished processing. Triggered = " << triggered);
         if (!tracking_)
@@ -402,11 +565,14 @@ class ParallelEdgeRemovingAlgorithm : public PersistentProcessingAlgorithm<Graph
         typename Graph::EdgeId,
         Priority> {
     typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
     typedef PersistentProcessingAlgorithm<Graph, EdgeId, Priority> base;
 
     const func::TypedPredicate<EdgeId> remove_condition_;
     EdgeRemover<Graph> edge_remover_;
 
+    std::vector<uint8_t> checked_;
+
 protected:
 
     bool Process(EdgeId e) override {
@@ -420,17 +586,39 @@ protected:
         return false;
     }
 
+    void PrepareBatch(size_t size) override {
+        checked_.assign(size, false);
+    }
+
+    void Check(EdgeId e, size_t idx, std::vector<VertexId> &neighbourhood) override {
+        neighbourhood = {this->g().EdgeStart(e), this->g().EdgeEnd(e)};
+        checked_[idx] = remove_condition_(e);
+    }
+
+    bool Commit(EdgeId e, size_t idx) override {
+        if (!checked_[idx])
+            return false;
+        TRACE("Check passed, removing");
+        edge_remover_.DeleteEdge(e);
+        return true;
+    }
+
 public:
+    /**
+     * @param batch_size positive value enables concurrent checks of the candidates,
+     *        only valid for the conditions depending on the edge and the edges incident to its ends
+     */
     ParallelEdgeRemovingAlgorithm(Graph& g,
                                   func::TypedPredicate<EdgeId> remove_condition,
                                   size_t chunk_cnt,
                                   std::function<void(EdgeId)> removal_handler = boost::none,
                                   bool canonical_only = false,
                                   const Priority& priority = Priority(),
-                                  bool track_changes = true)
+                                  bool track_changes = true,
+                                  size_t batch_size = 0)
             : base(g,
                    std::make_shared<ParallelInterestingElementFinder<Graph>>(remove_condition, chunk_cnt),
-                   canonical_only, priority, track_changes),
+                   canonical_only, priority, track_changes, batch_size),
                    remove_condition_(remove_condition),
                    edge_remover_(g, removal_handler) {
     }
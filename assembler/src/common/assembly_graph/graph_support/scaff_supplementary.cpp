@@ -188,8 +188,8 @@ void ScaffoldingUniqueEdgeAnalyzer::CheckCorrectness(ScaffoldingUniqueEdgeStorag
 set<VertexId> ScaffoldingUniqueEdgeAnalyzer::GetChildren(VertexId v, map<VertexId, set<VertexId>> &dijkstra_cash_) const {
     using omnigraph::DijkstraHelper;
     using debruijn_graph::Graph;
-    DijkstraHelper<Graph>::BoundedDijkstra dijkstra(
-            DijkstraHelper<Graph>::CreateBoundedDijkstra(graph_, max_dijkstra_depth_, max_dijkstra_vertices_));
+    DijkstraHelper<Graph>::DenseBoundedDijkstra dijkstra(
+            DijkstraHelper<Graph>::CreateBoundedDijkstra<omnigraph::DenseDijkstraStorage<Graph>>(graph_, max_dijkstra_depth_, max_dijkstra_vertices_));
     dijkstra.Run(v);
 
     if (dijkstra_cash_.find(v) == dijkstra_cash_.end()) {
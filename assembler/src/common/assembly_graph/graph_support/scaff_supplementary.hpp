@@ -49,6 +49,10 @@ public:
         return unique_edges_.erase(iter);
     }
 
+    void insert(EdgeId e) {
+        unique_edges_.insert(e);
+    }
+
     size_t size() const noexcept {
         return unique_edges_.size();
     }
@@ -117,6 +121,8 @@ class UsedUniqueStorage {
     std::unordered_map<size_t, std::unordered_set<EdgeId>> used_by_paths_; // for fast check 'whether the path contains the edge'
     const ScaffoldingUniqueEdgeStorage& unique_;
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
+    // Read-only storage consulted on lookups, used for speculative extension
+    const UsedUniqueStorage *base_;
 
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
@@ -127,7 +133,15 @@ public:
     explicit UsedUniqueStorage(const ScaffoldingUniqueEdgeStorage& unique,
                                const debruijn_graph::ConjugateDeBruijnGraph &g)
         : unique_(unique)
-        , g_(g) 
+        , g_(g)
+        , base_(nullptr)
+    {}
+
+    // Overlay storage: lookups fall through to base, insertions stay local
+    explicit UsedUniqueStorage(const UsedUniqueStorage *base)
+        : unique_(base->unique_)
+        , g_(base->g_)
+        , base_(base)
     {}
 
     void insert(EdgeId e, size_t path_id) {
@@ -142,11 +156,23 @@ public:
 
     bool IsUsed(EdgeId e, size_t path_id) const {
         auto it = used_by_paths_.find(path_id);
-        return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
+        if (it != used_by_paths_.end() && it->second.find(e) != it->second.end())
+            return true;
+        return base_ && base_->IsUsed(e, path_id);
     }
 
     bool IsUsed(EdgeId e) const {
-        return used_.find(e) != used_.end();
+        return used_.find(e) != used_.end() || (base_ && base_->IsUsed(e));
+    }
+
+    // Edges inserted into this storage (not including the base one)
+    const std::unordered_set<EdgeId> &local_used() const {
+        return used_;
+    }
+
+    void clear() {
+        used_.clear();
+        used_by_paths_.clear();
     }
 
     bool IsUsedAndUnique(EdgeId e, size_t path_id) const {
@@ -177,6 +177,10 @@ public:
         TRACE("~EdgePositionHandler ok");
     }
 
+    bool IsDeferrable() const override {
+        return true;
+    }
+
     virtual void HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
 //        TRACE("Handle glue ");
         auto positions1 = GetEdgePositions(edge1);
@@ -31,7 +31,7 @@ class PathProcessor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
     typedef std::vector<EdgeId> Path;
-    typedef typename DijkstraHelper<Graph>::BoundedDijkstra DijkstraT;
+    typedef typename DijkstraHelper<Graph>::DenseBoundedDijkstra DijkstraT;
 public:
     class Callback {
 
@@ -188,7 +188,7 @@ public:
                   size_t dijkstra_vertex_limit = MAX_DIJKSTRA_VERTICES) :
               g_(g),
               start_(start),
-              dijkstra_(DijkstraHelper<Graph>::CreateBoundedDijkstra(g, length_bound,
+              dijkstra_(DijkstraHelper<Graph>::template CreateBoundedDijkstra<DenseDijkstraStorage<Graph>>(g, length_bound,
                                                                      dijkstra_vertex_limit)) {
         //TIME_TRACE_SCOPE("PathProcessor:Dijkstra");
         TRACE("Dijkstra launched");
@@ -221,6 +221,11 @@ public:
         return error_code;
     }
 
+    // Vertices reached by Dijkstra, all the paths found pass only through them
+    std::vector<VertexId> ReachedVertices() const {
+        return dijkstra_.ReachedVertices();
+    }
+
     static const size_t MAX_CALL_CNT = 3000;
     static const size_t MAX_DIJKSTRA_VERTICES = 3000;
     static const size_t VERTEX_USAGE_ENABLE_THRESHOLD = 500;
@@ -262,6 +262,8 @@ struct detail_info_printer {
     void operator()(config::info_printer_pos pos, const std::string &folder_suffix = "") {
         auto pos_name = ModeName(pos, config::InfoPrinterPosNames());
 
+        // The handlers below could be queried
+        gp_.get_mutable<Graph>().FlushEvents();
         ProduceDetailedInfo(pos_name + folder_suffix, pos);
     }
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "io_base.hpp"
+#include "packed_graph.hpp"
 
 #include "assembly_graph/core/graph.hpp"
 #include "common/sequence/sequence.hpp"
@@ -15,6 +16,10 @@ namespace io {
 
 namespace binary {
 
+/**
+ * @brief  Graph files are saved in the packed format, the older .grseq ones are still loaded.
+ *         Binary streams keep the vertex by vertex layout.
+ */
 template<typename Graph>
 class GraphIO : public IOSingle<Graph> {
 public:
@@ -22,6 +27,18 @@ public:
             : IOSingle<Graph>("debruijn graph", ".grseq") {
     }
 
+    void Save(const std::string &basename, const Graph &graph) override {
+        PackedGraphIO<Graph>().Save(basename, graph);
+    }
+
+    bool Load(const std::string &basename, Graph &graph) override {
+        return PackedGraphIO<Graph>().Load(basename, graph) || LoadUnpacked(basename, graph);
+    }
+
+    bool LoadUnpacked(const std::string &basename, Graph &graph) {
+        return IOSingle<Graph>::Load(basename, graph);
+    }
+
 private:
     void SaveImpl(BinOStream &str, const Graph &graph) override {
         str << graph.vreserved() << graph.ereserved();
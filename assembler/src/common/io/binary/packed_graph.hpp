@@ -0,0 +1,169 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io_base.hpp"
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/construction_helper.hpp"
+#include "io/kmers/mmapped_reader.hpp"
+#include "sequence/sequence.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+namespace io {
+
+namespace binary {
+
+/**
+ * @brief  Saves the graph in a columnar layout which is mapped into memory and
+ *         constructed in parallel on load. All the sections are arrays of 64-bit words:
+ *         - header;
+ *         - vertex pairs (id, conjugate id);
+ *         - offsets of the outgoing edges of every vertex of the pairs in the next section;
+ *         - outgoing edges (every edge occurs once);
+ *         - sequences of canonical edges, as written by Sequence::BinWrite;
+ *         - canonical edges (id, conjugate id, offset of the sequence).
+ */
+template<typename Graph>
+class PackedGraphIO : public IOBase<Graph> {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    static constexpr uint64_t MAGIC = 0x4b50524753445053ULL; // "SPDSGRPK"
+    static constexpr uint64_t VERSION = 1;
+
+    struct Header {
+        uint64_t magic, version, k;
+        uint64_t vreserved, ereserved;
+        uint64_t vertex_cnt, link_cnt, edge_cnt, nucls_size;
+    };
+
+    static void WriteWords(std::ostream &file, const std::vector<uint64_t> &words) {
+        file.write((const char *)words.data(), words.size() * sizeof(uint64_t));
+    }
+
+public:
+    static std::string FileName(const std::string &basename) {
+        return basename + ".grpk";
+    }
+
+    void Save(const std::string &basename, const Graph &graph) override {
+        std::string filename = FileName(basename);
+        std::ofstream file(filename, std::ios::binary);
+        DEBUG("Saving packed graph into " << filename);
+        VERIFY(file);
+
+        std::vector<uint64_t> vertices, offsets(1, 0), links;
+        for (VertexId v : graph) {
+            VertexId cv = graph.conjugate(v);
+            if (cv < v)
+                continue;
+            vertices.push_back(v.int_id());
+            vertices.push_back(cv.int_id());
+            for (VertexId u : {v, cv}) {
+                for (EdgeId e : graph.OutgoingEdges(u))
+                    links.push_back(e.int_id());
+                offsets.push_back(links.size());
+            }
+        }
+
+        Header header = {MAGIC, VERSION, graph.k(),
+                         graph.vreserved(), graph.ereserved(),
+                         vertices.size() / 2, links.size(), 0, 0};
+        file.write((const char *)&header, sizeof(header));
+        WriteWords(file, vertices);
+        WriteWords(file, offsets);
+        WriteWords(file, links);
+
+        std::vector<uint64_t> edges;
+        auto nucls_start = file.tellp();
+        for (auto it = graph.ConstEdgeBegin(/*canonical_only*/true); !it.IsEnd(); ++it) {
+            EdgeId e = *it;
+            edges.push_back(e.int_id());
+            edges.push_back(graph.conjugate(e).int_id());
+            edges.push_back(uint64_t(file.tellp() - nucls_start));
+            graph.EdgeNucls(e).BinWrite(file);
+        }
+        header.edge_cnt = edges.size() / 3;
+        header.nucls_size = uint64_t(file.tellp() - nucls_start);
+        WriteWords(file, edges);
+
+        file.seekp(0);
+        file.write((const char *)&header, sizeof(header));
+        VERIFY(file);
+    }
+
+    /**
+     * @return false if the file is missing. true if the graph was successfully loaded.
+     */
+    bool Load(const std::string &basename, Graph &graph) override {
+        std::string filename = FileName(basename);
+        if (!fs::check_existence(filename))
+            return false;
+
+        DEBUG("Loading packed graph from " << filename);
+        MMappedReader file(filename, /* unlink */ false, /* whole file */ -1ULL);
+        Header header;
+        CHECK_FATAL_ERROR(file.size() >= sizeof(header), "Failed to read " << filename);
+        memcpy(&header, file.data(), sizeof(header));
+        CHECK_FATAL_ERROR(header.magic == MAGIC && header.version == VERSION,
+                          "Unsupported graph format in " << filename);
+        VERIFY_MSG(header.k == graph.k(), "Graph in " << filename << " has k = " << header.k);
+
+        const uint64_t *vertices = (const uint64_t *)((const uint8_t *)file.data() + sizeof(header));
+        const uint64_t *offsets = vertices + 2 * header.vertex_cnt;
+        const uint64_t *links = offsets + 2 * header.vertex_cnt + 1;
+        const uint8_t *nucls = (const uint8_t *)(links + header.link_cnt);
+        const uint64_t *edges = (const uint64_t *)(nucls + header.nucls_size);
+        CHECK_FATAL_ERROR((const uint8_t *)(edges + 3 * header.edge_cnt) == (const uint8_t *)file.data() + file.size(),
+                          "Failed to read " << filename);
+
+        graph.clear();
+        graph.reserve(header.vreserved, header.ereserved);
+        auto helper = graph.GetConstructionHelper();
+
+        // The ids are fixed and reserved, so the storage could be filled concurrently
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.vertex_cnt; ++i) {
+            VertexId v = helper.CreateVertex(typename Graph::VertexData(), vertices[2 * i], vertices[2 * i + 1]);
+            VERIFY(v == vertices[2 * i]);
+        }
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.edge_cnt; ++i) {
+            Sequence seq;
+            seq.BinRead(nucls + edges[3 * i + 2]);
+            EdgeId e = helper.CreateEdge(typename Graph::EdgeData(seq), edges[3 * i], edges[3 * i + 1]);
+            VERIFY(e == edges[3 * i]);
+            VERIFY(graph.conjugate(e) == edges[3 * i + 1]);
+        }
+
+        // Every vertex links only its own outgoing edges
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < 2 * header.vertex_cnt; ++i) {
+            for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+                helper.LinkOutgoingEdge(vertices[i], links[j]);
+        }
+
+        bool parallel = graph.AllHandlersThreadSafe();
+#       pragma omp parallel for schedule(guided) if(parallel)
+        for (size_t i = 0; i < header.vertex_cnt; ++i)
+            graph.FireAddVertex(vertices[2 * i]);
+#       pragma omp parallel for schedule(guided) if(parallel)
+        for (size_t i = 0; i < header.edge_cnt; ++i)
+            graph.FireAddEdge(edges[3 * i]);
+
+        return true;
+    }
+
+private:
+    DECL_LOGGER("PackedGraphIO");
+};
+
+} // namespace binary
+
+} // namespace io
@@ -18,6 +18,7 @@
 
 #include "threadpool/threadpool.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 
@@ -62,7 +63,8 @@ bool ReadConverter::LoadLibIfExists(SequencingLibraryT& lib) {
 }
 
 void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
-                                    ThreadPool::ThreadPool *pool) {
+                                    ThreadPool::ThreadPool *pool,
+                                    unsigned decompress_threads) {
     auto& data = lib.data();
     std::ofstream info;
     info.open(data.binary_reads_info.bin_reads_info_file, std::ios_base::out);
@@ -74,12 +76,16 @@ void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
     BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix);
 
     FileReadFlags flags{ PhredOffset, /* use name */ false, /* use quality */ false, /* validate */ false };
+    flags.threads = (uint16_t)std::min(decompress_threads, 0xFFFFu);
+    // Both files of a pair are decompressed at once, so they share the threads
+    FileReadFlags paired_flags = flags;
+    paired_flags.threads = std::max<unsigned>(flags.threads / 2, 1);
     PairedStream paired_reader = paired_easy_reader(lib,
                                                     false, /* followed_by_rc */
                                                     0, /* insert_size */
                                                     false, /* use orientation */
                                                     true, /* handle Ns */
-                                                    flags, pool);
+                                                    paired_flags, pool);
     ReadStreamStat read_stat = paired_converter.ToBinary(paired_reader, lib.orientation(), pool);
     read_stat.read_count *= 2;
 
@@ -134,6 +140,7 @@ void ReadConverter::WriteBinaryInfo(const std::string &filename, LibraryData &da
          data.total_nucls << "\n";
 
     info.close();
+    CHECK_FATAL_ERROR(!info.fail(), "Failed to write binary reads info to " << filename);
     data.binary_reads_info.binary_converted = true;
 }
 
@@ -145,7 +152,7 @@ void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads) {
 
     for (auto &lib : data) {
         if (!ReadConverter::LoadLibIfExists(lib))
-            ReadConverter::ConvertToBinary(lib, pool.get());
+            ReadConverter::ConvertToBinary(lib, pool.get(), nthreads);
     }
 }
 
@@ -30,7 +30,8 @@ class ReadConverter {
 public:
     static bool LoadLibIfExists(SequencingLibraryT& lib);
     static void ConvertToBinary(SequencingLibraryT& lib,
-                                ThreadPool::ThreadPool *pool = nullptr);
+                                ThreadPool::ThreadPool *pool = nullptr,
+                                unsigned decompress_threads = 1);
 
     static void ConvertEdgeSequencesToBinary(const debruijn_graph::Graph &g, const std::string &contigs_output_dir,
                                              unsigned nthreads);
@@ -168,7 +168,7 @@ public:
     }
 
     void read(void *buf, size_t amount) {
-        if (BytesRead + amount < BlockOffset + BlockSize) {
+        if (BytesRead + amount <= BlockOffset + BlockSize) {
             // Easy case, no remap is necessary
             read_internal(buf, amount);
             return;
@@ -191,8 +191,10 @@ public:
         }
 
         // Finally, remap and read remaining.
-        remap();
-        read_internal(cbuf, amount);
+        if (amount) {
+            remap();
+            read_internal(cbuf, amount);
+        }
     }
 
     void *skip(size_t amount) {
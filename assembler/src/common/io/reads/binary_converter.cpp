@@ -107,6 +107,10 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     // Rewrite the reserved space with actual stats
     file_ds_->seekp(0);
     read_stats.write(*file_ds_);
+    // A truncated copy (e.g. on a full disk) must not be picked up later as valid
+    file_ds_->flush();
+    offset_ds_->flush();
+    CHECK_FATAL_ERROR(*file_ds_ && *offset_ds_, "Failed to write binary reads to " << file_name_prefix_);
 
     INFO(read_count << " reads written");
     return read_stats;
@@ -13,15 +13,17 @@
 
 namespace io {
 
-bool BinaryFileSingleStream::ReadImpl(SingleReadSeq &read) {
-    return read.BinRead(stream_);
+const uint8_t *BinaryFileSingleStream::ReadImpl(const uint8_t *data, Sequence::SharedStorage &storage,
+                                                SingleReadSeq &read) {
+    return read.BinRead(data, storage);
 }
 
 BinaryFileSingleStream::BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
         : BinaryFileStream(file_name_prefix, portion_count, portion_num) {}
 
-bool BinaryFilePairedStream::ReadImpl(PairedReadSeq& read) {
-    return read.BinRead(stream_, insert_size_);
+const uint8_t *BinaryFilePairedStream::ReadImpl(const uint8_t *data, Sequence::SharedStorage &storage,
+                                                PairedReadSeq &read) {
+    return read.BinRead(data, storage, insert_size_);
 }
 
 BinaryFilePairedStream::BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
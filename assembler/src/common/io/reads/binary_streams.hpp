@@ -12,30 +12,46 @@
 #include "paired_read.hpp"
 #include "binary_converter.hpp"
 
+#include "io/kmers/mmapped_reader.hpp"
 #include "utils/verify.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_opener.hpp"
 
 #include <fstream>
+#include <vector>
 
 namespace io {
 
 template<typename SeqT>
 class BinaryFileStream {
 protected:
-    std::ifstream stream_;
-
-    virtual bool ReadImpl(SeqT &read) = 0;
+    /**
+     * Deserializes a read stored at data, placing its nucleotides into storage.
+     * @return Pointer past the read.
+     */
+    virtual const uint8_t *ReadImpl(const uint8_t *data, Sequence::SharedStorage &storage, SeqT &read) = 0;
 
 private:
-    size_t offset_, count_, current_;
+    // Whole reads file is mapped, reads are decoded right from the page cache
+    MMappedReader file_;
+    // Offsets of the portion chunks in the reads file followed by the end of the last one
+    std::vector<size_t> chunks_;
+    size_t count_, current_, pos_;
+    // Nucleotides of the current chunk, reads are views into it
+    Sequence::SharedStorage storage_;
+    bool is_open_;
 
     void Init() {
-        stream_.clear();
-        stream_.seekg(offset_);
-        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
         current_ = 0;
+        pos_ = 0;
+    }
+
+    void NextChunk() {
+        size_t chunk = current_ / BinaryWriter::CHUNK;
+        VERIFY(chunk + 1 < chunks_.size());
+        pos_ = chunks_[chunk];
+        storage_ = Sequence::SharedStorage(Sequence::SharedStorage::WordsFor(chunks_[chunk + 1] - pos_));
     }
 
 public:
@@ -45,13 +61,14 @@ public:
      * @param portion_count Total number of (roughly equal) portions.
      * @param portion_num Index of the portion (0..portion_count - 1).
      */
-    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num) {
+    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
+            : file_(file_name_prefix + ".seq", /* unlink */ false, /* whole file */ -1ULL),
+              count_(0), is_open_(true) {
         DEBUG("Preparing binary stream #" << portion_num << "/" << portion_count);
         VERIFY(portion_num < portion_count);
-        const std::string fname = file_name_prefix + ".seq";
-        stream_.open(fname, std::ios_base::binary | std::ios_base::in);
+        VERIFY(file_.size() >= sizeof(ReadStreamStat));
         ReadStreamStat stat;
-        stat.read(stream_);
+        memcpy(&stat.read_count, file_.data(), sizeof(stat.read_count));
 
         const std::string offset_name = file_name_prefix + ".off";
         const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
@@ -73,23 +90,25 @@ public:
         VERIFY_MSG(chunk_num <= chunk_count, "chunk_num " << chunk_num << " chunk_count " << chunk_count << " big_portion_before " << big_portion_before << " big_portion_size " << big_portion_size << " small_portion_size " << small_portion_size << " portion_num " << portion_num);
 
         if (chunk_num < chunk_count) {  // if we start from existing chunk
-            // Calculating the absolute offset in the reads file
+            const bool is_big_portion = portion_num < big_portion_count;
+            const size_t portion_size = is_big_portion ? big_portion_size : small_portion_size;
+            // Offsets of the portion chunks and of the chunk following it, if any
+            const size_t offset_count = std::min(portion_size + 1, chunk_count - chunk_num);
+            chunks_.resize(offset_count);
             auto offset_stream = fs::open_file(offset_name, std::ios_base::binary | std::ios_base::in);
             offset_stream.seekg(chunk_num * sizeof(size_t));
-            offset_stream.read(reinterpret_cast<char *>(&offset_), sizeof(offset_));
-            DEBUG("Offset read: " << offset_ << " chunk_count " << chunk_count << " chunk_num " << chunk_num << " portion_count " << portion_count << " portion_num " << portion_num << " prefix " << file_name_prefix << " name " << offset_name);
+            offset_stream.read(reinterpret_cast<char *>(chunks_.data()), offset_count * sizeof(size_t));
             VERIFY(offset_stream);
-            const bool is_big_portion = portion_num < big_portion_count;
+            if (offset_count == portion_size)
+                chunks_.push_back(file_.size());
+            DEBUG("Offset read: " << chunks_.front() << " chunk_count " << chunk_count << " chunk_num " << chunk_num << " portion_count " << portion_count << " portion_num " << portion_num << " prefix " << file_name_prefix << " name " << offset_name);
+
             const size_t start_num = chunk_num * BinaryWriter::CHUNK;
             // Last chunk could be incomplete => we should truncate count_ for last portions
-            count_ = std::min(stat.read_count - start_num,
-                              (is_big_portion ? big_portion_size : small_portion_size) * BinaryWriter::CHUNK);
+            count_ = std::min(stat.read_count - start_num, portion_size * BinaryWriter::CHUNK);
 
-            DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << offset_);
+            DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << chunks_.front());
         } else {  // current portion has size 0 (the case of chunk_count == 0 is also included here)
-            // Setup safe offset value
-            offset_ = sizeof(ReadStreamStat);
-            count_ = 0;
             DEBUG("Empty BinaryFileStream constructed");
         }
 
@@ -102,15 +121,23 @@ public:
     BinaryFileStream(const std::string &file_name_prefix)
             : BinaryFileStream(file_name_prefix, 1, 0) {}
 
+    BinaryFileStream(BinaryFileStream&&) = default;
+    BinaryFileStream<SeqT>& operator=(BinaryFileStream&&) = default;
+    virtual ~BinaryFileStream() = default;
+
     BinaryFileStream<SeqT>& operator>>(SeqT &read) {
-        ReadImpl(read);
         VERIFY(current_ < count_);
+        if (current_ % BinaryWriter::CHUNK == 0)
+            NextChunk();
+
+        const uint8_t *data = static_cast<const uint8_t *>(file_.data());
+        pos_ = ReadImpl(data + pos_, storage_, read) - data;
         ++current_;
         return *this;
     }
 
     bool is_open() {
-        return stream_.is_open();
+        return is_open_;
     }
 
     bool eof() {
@@ -119,7 +146,9 @@ public:
 
     void close() {
         current_ = 0;
-        stream_.close();
+        count_ = 0;
+        file_ = MMappedReader();
+        is_open_ = false;
     }
 
     void reset() {
@@ -130,7 +159,7 @@ public:
 
 class BinaryFileSingleStream : public BinaryFileStream<SingleReadSeq>  {
 protected:
-    bool ReadImpl(SingleReadSeq &read) override;
+    const uint8_t *ReadImpl(const uint8_t *data, Sequence::SharedStorage &storage, SingleReadSeq &read) override;
 public:
     BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num);
 };
@@ -138,7 +167,7 @@ public:
 class BinaryFilePairedStream: public BinaryFileStream<PairedReadSeq> {
     size_t insert_size_;
 protected:
-    bool ReadImpl(PairedReadSeq& read) override;
+    const uint8_t *ReadImpl(const uint8_t *data, Sequence::SharedStorage &storage, PairedReadSeq &read) override;
 public:
     BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
                            size_t portion_count, size_t portion_num);
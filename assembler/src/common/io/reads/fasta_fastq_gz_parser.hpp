@@ -11,6 +11,7 @@
 
 #include "utils/verify.hpp"
 #include "io/reads/parser.hpp"
+#include "io/reads/parallel_gz_reader.hpp"
 #include "sequence/quality.hpp"
 #include "sequence/nucl.hpp"
 
@@ -29,6 +30,30 @@ namespace fastafastqgz {
 // STEP 1: declare the type of file handler and the read() function
 KSEQ_INIT(gzFile, gzread)
 #pragma GCC diagnostic pop
+
+template<class Seq>
+SingleRead MakeRead(const Seq *seq, const FileReadFlags &flags) {
+    if (seq->qual.s && flags.use_name && flags.use_quality)
+        return SingleRead(seq->name.s, seq->seq.s, seq->qual.s, flags.offset,
+                          0, 0, flags.validate);
+    else if (flags.use_name)
+        return SingleRead(seq->name.s, seq->seq.s,
+                          0, 0, flags.validate);
+
+    return SingleRead(seq->seq.s,
+                      0, 0, flags.validate);
+}
+}
+
+namespace parallelgz {
+inline int ParallelGzRead(ParallelGzReader *reader, void *buf, unsigned len) {
+    return reader->read(buf, len);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+KSEQ_INIT(ParallelGzReader*, ParallelGzRead)
+#pragma GCC diagnostic pop
 }
 
 class FastaFastqGzParser: public Parser {
@@ -65,16 +90,7 @@ public:
         if (!is_open_ || eof_)
             return *this;
 
-        if (seq_->qual.s && flags_.use_name && flags_.use_quality) {
-            read = SingleRead(seq_->name.s, seq_->seq.s, seq_->qual.s, flags_.offset,
-                              0, 0, flags_.validate);
-        } else if (flags_.use_name) {
-            read = SingleRead(seq_->name.s, seq_->seq.s,
-                              0, 0, flags_.validate);
-        } else
-            read = SingleRead(seq_->seq.s,
-                              0, 0, flags_.validate);
-
+        read = fastafastqgz::MakeRead(seq_, flags_);
         ReadAhead();
         return *this;
     }
@@ -145,4 +161,68 @@ private:
     void operator=(const FastaFastqGzParser& parser);
 };
 
+/*
+ * Same as FastaFastqGzParser, but decompression runs on a pool of
+ * flags.threads threads (see ParallelGzReader) concurrently with parsing.
+ */
+class ParallelFastaFastqGzParser: public Parser {
+public:
+    ParallelFastaFastqGzParser(const std::string& filename,
+                               FileReadFlags flags = FileReadFlags())
+            : Parser(filename, flags), seq_(NULL) {
+        open();
+    }
+
+    ~ParallelFastaFastqGzParser() {
+        close();
+    }
+
+    ParallelFastaFastqGzParser& operator>>(SingleRead& read) {
+        if (!is_open_ || eof_)
+            return *this;
+
+        read = fastafastqgz::MakeRead(seq_, flags_);
+        ReadAhead();
+        return *this;
+    }
+
+    void close() {
+        if (!is_open_)
+            return;
+
+        parallelgz::kseq_destroy(seq_);
+        reader_.reset();
+        is_open_ = false;
+        eof_ = true;
+    }
+
+private:
+    std::unique_ptr<ParallelGzReader> reader_;
+    parallelgz::kseq_t* seq_;
+
+    void open() {
+        reader_ = std::make_unique<ParallelGzReader>(filename_, size_t(flags_.threads));
+        if (!reader_->is_open()) {
+            reader_.reset();
+            is_open_ = false;
+            return;
+        }
+        seq_ = parallelgz::kseq_init(reader_.get());
+        eof_ = false;
+        is_open_ = true;
+        ReadAhead();
+    }
+
+    void ReadAhead() {
+        VERIFY(is_open_);
+        VERIFY(!eof_);
+        if (parallelgz::kseq_read(seq_) < 0) {
+            eof_ = true;
+        }
+    }
+
+    ParallelFastaFastqGzParser(const ParallelFastaFastqGzParser& parser) = delete;
+    void operator=(const ParallelFastaFastqGzParser& parser) = delete;
+};
+
 }
@@ -26,15 +26,17 @@ struct FileReadFlags {
     bool use_name     : 1;
     bool use_quality  : 1;
     bool validate     : 1;
+    // Number of threads used to decompress gzipped input, 1 means inline decompression
+    unsigned threads  : 16;
 
     FileReadFlags()
-            : offset(PhredOffset), use_name(true), use_quality(true), validate(true) {}
+            : offset(PhredOffset), use_name(true), use_quality(true), validate(true), threads(1) {}
     FileReadFlags(OffsetType o)
-            : offset(o), use_name(true), use_quality(true) {}
+            : offset(o), use_name(true), use_quality(true), threads(1) {}
     FileReadFlags(OffsetType o, bool n, bool q)
-            : offset(o), use_name(n), use_quality(q) {}
+            : offset(o), use_name(n), use_quality(q), threads(1) {}
     FileReadFlags(OffsetType o, bool n, bool q, bool v)
-            : offset(o), use_name(n), use_quality(q), validate(v) {}
+            : offset(o), use_name(n), use_quality(q), validate(v), threads(1) {}
 
 };
 
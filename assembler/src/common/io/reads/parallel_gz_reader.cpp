@@ -0,0 +1,211 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "parallel_gz_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace io {
+
+// gzip member header (RFC 1952) up to the extra field; BGZF stores member size in the "BC" subfield
+static constexpr size_t GZ_HEADER_SIZE = 12;
+static constexpr size_t GZ_FOOTER_SIZE = 8;
+static constexpr size_t BGZF_BATCH_BLOCKS = 64;
+static constexpr size_t GZ_CHUNK_SIZE = 1 << 22;
+
+static uint32_t ReadLE32(const unsigned char *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static bool IsGzHeader(const unsigned char *header) {
+    return header[0] == 31 && header[1] == 139 && header[2] == 8 && (header[3] & 4);
+}
+
+bool ParallelGzReader::IsBGZF(const std::string &filename) {
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (!f)
+        return false;
+
+    unsigned char header[18];
+    size_t n = fread(header, 1, sizeof(header), f);
+    fclose(f);
+
+    return n == sizeof(header) && IsGzHeader(header) &&
+           (header[10] | header[11] << 8) >= 6 &&
+           header[12] == 'B' && header[13] == 'C' && header[14] == 2 && header[15] == 0;
+}
+
+ParallelGzReader::ParallelGzReader(const std::string &filename, size_t nthreads)
+        : filename_(filename), is_open_(false), bgzf_(IsBGZF(filename)), input_eof_(false),
+          depth_(0), file_(nullptr), gz_(nullptr), pos_(0) {
+    nthreads = std::max<size_t>(nthreads, 1);
+    if (bgzf_) {
+        file_ = fopen(filename_.c_str(), "rb");
+        is_open_ = (file_ != nullptr);
+        depth_ = 2 * nthreads;
+    } else {
+        // Members of generic gzip files cannot be located without inflating, so only prefetch
+        gz_ = gzopen(filename_.c_str(), "r");
+        is_open_ = (gz_ != nullptr);
+        nthreads = 1;
+        depth_ = 2;
+    }
+    if (!is_open_)
+        return;
+
+    DEBUG("Reading " << filename_ << (bgzf_ ? " (BGZF)" : "") << " using " << nthreads << " decompression threads");
+    pool_ = std::make_unique<ThreadPool::ThreadPool>(nthreads);
+    Dispatch();
+}
+
+ParallelGzReader::~ParallelGzReader() {
+    for (auto &task : pending_)
+        task.wait();
+    pending_.clear();
+    pool_.reset();
+
+    if (file_)
+        fclose(file_);
+    if (gz_)
+        gzclose(gz_);
+}
+
+int ParallelGzReader::read(void *buf, unsigned len) {
+    unsigned char *out = static_cast<unsigned char*>(buf);
+    size_t copied = 0;
+    while (copied < len) {
+        if (pos_ == current_.size() && !NextChunk())
+            break;
+
+        size_t n = std::min<size_t>(len - copied, current_.size() - pos_);
+        memcpy(out + copied, current_.data() + pos_, n);
+        pos_ += n;
+        copied += n;
+    }
+
+    return int(copied);
+}
+
+bool ParallelGzReader::NextChunk() {
+    while (!pending_.empty()) {
+        current_ = pending_.front().get();
+        pending_.pop_front();
+        pos_ = 0;
+
+        // gzread() fills the whole buffer unless the end of file is reached
+        if (!bgzf_ && current_.size() < GZ_CHUNK_SIZE)
+            input_eof_ = true;
+        Dispatch();
+
+        if (!current_.empty())
+            return true;
+    }
+
+    return false;
+}
+
+void ParallelGzReader::Dispatch() {
+    while (!input_eof_ && pending_.size() < depth_) {
+        if (!bgzf_) {
+            // Single-threaded pool runs tasks in order, so gzread() calls are never concurrent
+            pending_.push_back(pool_->run([this] { return ReadGzChunk(); }));
+            continue;
+        }
+
+        auto raw = std::make_shared<Buffer>();
+        auto offsets = std::make_shared<std::vector<size_t>>();
+        if (!ReadBGZFBatch(*raw, *offsets))
+            break;
+
+        pending_.push_back(pool_->run([raw, offsets] { return InflateBGZF(*raw, *offsets); }));
+    }
+}
+
+bool ParallelGzReader::ReadBGZFBatch(Buffer &raw, std::vector<size_t> &offsets) {
+    while (offsets.size() < BGZF_BATCH_BLOCKS) {
+        size_t start = raw.size();
+        raw.resize(start + GZ_HEADER_SIZE);
+        size_t n = fread(raw.data() + start, 1, GZ_HEADER_SIZE, file_);
+        if (n == 0) {
+            raw.resize(start);
+            input_eof_ = true;
+            break;
+        }
+        CHECK_FATAL_ERROR(n == GZ_HEADER_SIZE && IsGzHeader(raw.data() + start),
+                          "Corrupted BGZF block in " << filename_);
+
+        size_t xlen = raw[start + 10] | raw[start + 11] << 8;
+        raw.resize(start + GZ_HEADER_SIZE + xlen);
+        CHECK_FATAL_ERROR(fread(raw.data() + start + GZ_HEADER_SIZE, 1, xlen, file_) == xlen,
+                          "Truncated BGZF block in " << filename_);
+
+        const unsigned char *extra = raw.data() + start + GZ_HEADER_SIZE;
+        size_t block_size = 0;
+        for (size_t i = 0; i + 4 <= xlen; ) {
+            size_t slen = extra[i + 2] | extra[i + 3] << 8;
+            if (extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2 && i + 6 <= xlen)
+                block_size = (extra[i + 4] | extra[i + 5] << 8) + 1;
+            i += 4 + slen;
+        }
+        CHECK_FATAL_ERROR(block_size >= GZ_HEADER_SIZE + xlen + GZ_FOOTER_SIZE,
+                          "Non-BGZF gzip member found in " << filename_);
+
+        size_t rest = block_size - GZ_HEADER_SIZE - xlen;
+        raw.resize(start + block_size);
+        CHECK_FATAL_ERROR(fread(raw.data() + start + GZ_HEADER_SIZE + xlen, 1, rest, file_) == rest,
+                          "Truncated BGZF block in " << filename_);
+        offsets.push_back(start);
+    }
+
+    return !offsets.empty();
+}
+
+ParallelGzReader::Buffer ParallelGzReader::ReadGzChunk() {
+    Buffer chunk(GZ_CHUNK_SIZE);
+    int n = gzread(gz_, chunk.data(), unsigned(chunk.size()));
+    // gzread() returns the data read so far from a truncated file and only sets the error
+    int err = Z_OK;
+    const char *msg = gzerror(gz_, &err);
+    CHECK_FATAL_ERROR(n >= 0 && err == Z_OK, "Failed to decompress " << filename_ << ": " << msg);
+    chunk.resize(size_t(n));
+    return chunk;
+}
+
+ParallelGzReader::Buffer ParallelGzReader::InflateBGZF(const Buffer &raw, const std::vector<size_t> &offsets) {
+    Buffer out;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    CHECK_FATAL_ERROR(inflateInit2(&zs, -15) == Z_OK, "Failed to initialize zlib");
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        const unsigned char *block = raw.data() + offsets[i];
+        size_t block_size = (i + 1 < offsets.size() ? offsets[i + 1] : raw.size()) - offsets[i];
+        size_t xlen = block[10] | block[11] << 8;
+        uint32_t crc = ReadLE32(block + block_size - 8);
+        uint32_t isize = ReadLE32(block + block_size - 4);
+        // Empty blocks (e.g. the end-of-file marker) carry no data
+        if (isize == 0)
+            continue;
+
+        size_t out_start = out.size();
+        out.resize(out_start + isize);
+
+        inflateReset(&zs);
+        zs.next_in = const_cast<Bytef*>(block + GZ_HEADER_SIZE + xlen);
+        zs.avail_in = unsigned(block_size - GZ_HEADER_SIZE - xlen - GZ_FOOTER_SIZE);
+        zs.next_out = out.data() + out_start;
+        zs.avail_out = isize;
+        int ret = inflate(&zs, Z_FINISH);
+        CHECK_FATAL_ERROR(ret == Z_STREAM_END && zs.avail_out == 0, "Failed to decompress BGZF block");
+        CHECK_FATAL_ERROR(crc32(0L, out.data() + out_start, isize) == crc, "CRC mismatch in BGZF block");
+    }
+
+    inflateEnd(&zs);
+    return out;
+}
+
+}
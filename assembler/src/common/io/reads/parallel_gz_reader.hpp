@@ -0,0 +1,79 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/logger/logger.hpp"
+
+#include "threadpool/threadpool.hpp"
+
+#include <zlib.h>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace io {
+
+/*
+ * Decompresses a gzip (or plain) file ahead of its consumer.
+ * BGZF files (as produced by bgzip) consist of independent gzip members of known size,
+ * so batches of members are inflated concurrently on a private thread pool. Any other
+ * file is inflated by a single background task, overlapping decompression with parsing.
+ * Decompressed data is always returned in file order.
+ */
+class ParallelGzReader {
+public:
+    ParallelGzReader(const std::string &filename, size_t nthreads);
+    ~ParallelGzReader();
+
+    bool is_open() const {
+        return is_open_;
+    }
+
+    bool is_bgzf() const {
+        return bgzf_;
+    }
+
+    /*
+     * Copy up to len decompressed bytes into buf (gzread-compatible).
+     *
+     * @return Number of bytes copied, 0 at the end of file.
+     */
+    int read(void *buf, unsigned len);
+
+    static bool IsBGZF(const std::string &filename);
+
+private:
+    typedef std::vector<unsigned char> Buffer;
+
+    bool NextChunk();
+    void Dispatch();
+    bool ReadBGZFBatch(Buffer &raw, std::vector<size_t> &offsets);
+    Buffer ReadGzChunk();
+    static Buffer InflateBGZF(const Buffer &raw, const std::vector<size_t> &offsets);
+
+    std::string filename_;
+    bool is_open_;
+    bool bgzf_;
+    // Whole input has been handed to decompression tasks
+    bool input_eof_;
+    size_t depth_;
+
+    FILE *file_;
+    gzFile gz_;
+    std::unique_ptr<ThreadPool::ThreadPool> pool_;
+    std::deque<std::future<Buffer>> pending_;
+
+    Buffer current_;
+    size_t pos_;
+
+    DECL_LOGGER("ParallelGzReader");
+};
+
+}
@@ -70,6 +70,9 @@ Parser* SelectParser(const std::string& filename,
   if (ext == "bam")
       return new BAMParser(filename, flags);
 
+  if (flags.threads > 1)
+      return new ParallelFastaFastqGzParser(filename, flags);
+
   return new FastaFastqGzParser(filename, flags);
   /*
   if ((ext == "fastq") || (ext == "fastq.gz") ||
@@ -10,8 +10,11 @@
 
 #include "io/reads/mpmc_bounded.hpp"
 #include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
 
+#include <iterator>
 #include <memory>
+#include <vector>
 #include <sched.h>
 
 #pragma GCC diagnostic push
@@ -65,6 +68,34 @@ private:
         }
     }
 
+    template<class Reader, class Op>
+    bool RunSingleBatched(Reader &irs, Op &op, std::vector<typename Reader::ReadT> &pending) {
+        typename Reader::ReadT r;
+
+        std::vector<typename Reader::ReadT> input;
+        input.swap(pending);
+        for (size_t i = 0; i < input.size(); ++i) {
+            processed_ += 1;
+            if (op(input[i])) {
+                pending.insert(pending.end(),
+                               std::make_move_iterator(input.begin() + i + 1),
+                               std::make_move_iterator(input.end()));
+                return true;
+            }
+        }
+
+        while (!irs.eof()) {
+            irs >> r;
+            read_ += 1;
+
+            processed_ += 1;
+            if (op(r))
+                return true;
+        }
+
+        return false;
+    }
+
 public:
     ReadProcessor(unsigned nthreads)
             : nthreads_(nthreads), read_(0), processed_(0) { }
@@ -134,6 +165,136 @@ public:
         return stop;
     }
 
+    /*
+     * Same as Run, but reads are passed through the queue in blocks of batch_size
+     * and the blocks (together with the reads they hold) are recycled via a free-list,
+     * so no per-read allocation or queue operation is made. Op is called with a
+     * reference to the read, which is only valid during the call.
+     * Once op returns true, no more reads are processed by any thread. Reads already
+     * fetched but not processed are moved to pending, they are processed first by
+     * the next call. read() counts only the reads fetched from the reader.
+     */
+    template<class Reader, class Op>
+    bool RunBatched(Reader &irs, Op &op, std::vector<typename Reader::ReadT> &pending,
+                    size_t batch_size = 256) {
+        using ReadT = typename Reader::ReadT;
+        struct Block {
+            std::vector<ReadT> reads;
+            size_t size;
+        };
+
+        if (nthreads_ < 2)
+            return RunSingleBatched(irs, op, pending);
+
+        // Round nthreads to next power of two
+        unsigned bufsize = nthreads_ - 1;
+        bufsize = (bufsize >> 1) | bufsize;
+        bufsize = (bufsize >> 2) | bufsize;
+        bufsize = (bufsize >> 4) | bufsize;
+        bufsize = (bufsize >> 8) | bufsize;
+        bufsize = (bufsize >> 16) | bufsize;
+        bufsize += 1;
+
+        // Both queues can hold all the blocks at once
+        size_t nblocks = 2 * bufsize;
+        std::vector<Block> blocks(nblocks);
+        mpmc_bounded_queue<Block*> in_queue(nblocks), free_queue(nblocks);
+        for (Block &block : blocks) {
+            block.reads.resize(batch_size);
+            block.size = 0;
+            free_queue.enqueue(&block);
+        }
+
+        std::vector<ReadT> input;
+        input.swap(pending);
+        size_t next_input = 0;
+
+        bool stop = false;
+        auto process = [&](Block *block) {
+            size_t i = 0;
+            for (; i < block->size; ++i) {
+                bool stopped;
+#         pragma omp atomic read
+                stopped = stop;
+                if (stopped)
+                    break;
+
+                if (op(block->reads[i])) {
+#           pragma omp atomic write
+                    stop = true;
+                    i += 1;
+                    break;
+                }
+            }
+
+#       pragma omp atomic
+            processed_ += i;
+
+            if (i < block->size) {
+#         pragma omp critical(read_processor_pending)
+                pending.insert(pending.end(),
+                               std::make_move_iterator(block->reads.begin() + i),
+                               std::make_move_iterator(block->reads.begin() + block->size));
+            }
+            free_queue.enqueue(block);
+        };
+
+#   pragma omp parallel shared(in_queue, free_queue, irs, op, stop) num_threads(nthreads_)
+        {
+#     pragma omp master
+            {
+                while (next_input < input.size() || !irs.eof()) {
+                    Block *block;
+                    while (!free_queue.dequeue(block))
+                        sched_yield();
+
+                    size_t size = 0, fetched = 0;
+                    for (; size < batch_size && next_input < input.size(); ++size)
+                        block->reads[size] = std::move(input[next_input++]);
+                    for (; size < batch_size && !irs.eof(); ++fetched)
+                        irs >> block->reads[size++];
+                    block->size = size;
+#         pragma omp atomic
+                    read_ += fetched;
+
+                    while (!in_queue.enqueue(block))
+                        sched_yield();
+
+#         pragma omp flush (stop)
+                    if (stop)
+                        break;
+                }
+
+                in_queue.close();
+            }
+
+            Block *block;
+            while (in_queue.wait_dequeue(block))
+                process(block);
+        }
+
+        // Pick up blocks enqueued right before the queue was closed
+        Block *block;
+        while (in_queue.dequeue(block))
+            process(block);
+
+        pending.insert(pending.end(),
+                       std::make_move_iterator(input.begin() + next_input),
+                       std::make_move_iterator(input.end()));
+
+#   pragma omp flush(stop)
+        return stop;
+    }
+
+    // Same as above for ops which never request a stop
+    template<class Reader, class Op>
+    bool RunBatched(Reader &irs, Op &op, size_t batch_size = 256) {
+        std::vector<typename Reader::ReadT> pending;
+        bool stop = RunBatched(irs, op, pending, batch_size);
+        VERIFY_MSG(pending.empty(), "Reads were left unprocessed");
+        return stop;
+    }
+
     template<class Reader, class Op, class Writer>
     void Run(Reader &irs, Op &op, Writer &writer) {
         using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
@@ -11,6 +11,7 @@
 #include "sequence/quality.hpp"
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
+#include "sequence/nucl_pack.hpp"
 #include "sequence/sequence_tools.hpp"
 #include "utils/verify.hpp"
 #include "utils/stl_utils.hpp"
@@ -168,12 +169,7 @@ public:
     }
 
     static bool IsValid(const std::string &seq) {
-        size_t sz = seq.size();
-        for (size_t i = 0; i < sz; ++i) {
-            if (!is_nucl(seq[i]))
-                return false;
-        }
-        return true;
+        return nucl_pack::Valid(seq.data(), seq.size());
     }
 
     SequenceOffsetT GetLeftOffset() const {
@@ -283,6 +279,14 @@ public:
         return !file.fail();
     }
 
+    const uint8_t *BinRead(const uint8_t *data, Sequence::SharedStorage &storage) {
+        data = seq_.BinRead(data, storage);
+        memcpy(&left_offset_, data, sizeof(left_offset_));
+        data += sizeof(left_offset_);
+        memcpy(&right_offset_, data, sizeof(right_offset_));
+        return data + sizeof(right_offset_);
+    }
+
     bool BinWrite(std::ostream &file, bool rc = false) const {
         if (rc)
             (!seq_).BinWrite(file);
@@ -60,6 +60,10 @@ public:
         return is_aligned() && is_main_alignment() && map_qual() != 0;
     }
 
+    bool is_first_in_pair() const {
+        return (data_->core.flag & 0x40) != 0;
+    }
+
     bool strand() const {
         return (data_->core.flag & 0x10) == 0;
     }
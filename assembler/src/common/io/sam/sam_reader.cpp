@@ -8,6 +8,7 @@
 #include "io/sam/read.hpp"
 #include "io/sam/sam_reader.hpp"
 
+#include "utils/filesystem/path_helper.hpp"
 #include "utils/verify.hpp"
 
 namespace sam_reader {
@@ -72,4 +73,98 @@ void MappedSamStream::open() {
     }
 }
 
+IndexedBamStream::IndexedBamStream(const std::string &filename)
+        : reader_(nullptr), header_(nullptr), index_(nullptr), iter_(nullptr),
+          filename_(filename), is_open_(false), eof_(true) {
+    if ((reader_ = bam_open(filename_.c_str(), "r")) == NULL) {
+        WARN("Fail to open BAM file " << filename_);
+        return;
+    }
+    header_ = bam_header_read(reader_);
+    for (int i = 0; i < header_->n_targets; ++i)
+        target_ids_.emplace(header_->target_name[i], i);
+    if ((index_ = bam_index_load(filename_.c_str())) == NULL) {
+        WARN("Fail to load index of BAM file " << filename_);
+        return;
+    }
+    is_open_ = true;
+}
+
+IndexedBamStream::~IndexedBamStream() {
+    if (iter_)
+        bam_iter_destroy(iter_);
+    if (index_)
+        bam_index_destroy(index_);
+    if (header_)
+        bam_header_destroy(header_);
+    if (reader_)
+        bam_close(reader_);
+    bam_destroy1(seq_);
+}
+
+bool IndexedBamStream::is_open() const {
+    return is_open_;
+}
+
+bool IndexedBamStream::eof() const {
+    return eof_;
+}
+
+bool IndexedBamStream::fetch(const std::string &contig_name) {
+    eof_ = true;
+    if (!is_open_)
+        return false;
+    if (iter_) {
+        bam_iter_destroy(iter_);
+        iter_ = nullptr;
+    }
+    auto it = target_ids_.find(contig_name);
+    if (it == target_ids_.end())
+        return false;
+
+    int tid = it->second;
+    iter_ = bam_iter_query(index_, tid, 0, header_->target_len[tid]);
+    advance();
+    return true;
+}
+
+void IndexedBamStream::advance() {
+    eof_ = (0 > bam_iter_read(reader_, iter_, seq_));
+}
+
+IndexedBamStream& IndexedBamStream::operator>>(SingleSamRead& read) {
+    if (!is_open_ || eof_)
+        return *this;
+    read.set_data(seq_);
+    advance();
+    return *this;
+}
+
+const char* IndexedBamStream::get_contig_name(int i) const {
+    VERIFY(i < header_->n_targets);
+    return (header_->target_name[i]);
+}
+
+std::string SortAndIndexSam(const std::string &sam_filename, const std::string &prefix, size_t max_memory) {
+    // Sorting works on BAM files only, so convert first. The temporary file is left uncompressed.
+    std::string unsorted_filename = prefix + ".unsorted.bam";
+    samfile_t *in = samopen(sam_filename.c_str(), "r", NULL);
+    CHECK_FATAL_ERROR(in, "Fail to open SAM file " + sam_filename);
+    samfile_t *out = samopen(unsorted_filename.c_str(), "wbu", in->header);
+    CHECK_FATAL_ERROR(out, "Fail to create BAM file " + unsorted_filename);
+    bam1_t *b = bam_init1();
+    while (samread(in, b) >= 0)
+        samwrite(out, b);
+    bam_destroy1(b);
+    samclose(out);
+    samclose(in);
+
+    std::string sorted_filename = prefix + ".bam";
+    bam_sort_core(0, unsorted_filename.c_str(), prefix.c_str(), max_memory);
+    fs::remove_if_exists(unsorted_filename);
+    CHECK_FATAL_ERROR(bam_index_build(sorted_filename.c_str()) == 0, "Fail to index BAM file " + sorted_filename);
+
+    return sorted_filename;
+}
+
 }
@@ -14,6 +14,7 @@
 #include <samtools/bam.h>
 
 #include <string>
+#include <unordered_map>
 
 namespace sam_reader {
 
@@ -45,5 +46,38 @@ private:
     void open();
 };
 
+// Streams the alignments to a single target of a coordinate-sorted and indexed
+// BAM file. The index is loaded once, so one stream could serve many targets.
+class IndexedBamStream {
+public:
+    IndexedBamStream(const std::string &filename);
+    ~IndexedBamStream();
+
+    bool is_open() const;
+    // Positions the stream at the first alignment to the target, returns false if there is no such target
+    bool fetch(const std::string &contig_name);
+    bool eof() const;
+    IndexedBamStream& operator >>(SingleSamRead& read);
+    const char* get_contig_name(int i) const;
+
+private:
+    bamFile reader_;
+    bam_header_t *header_;
+    bam_index_t *index_;
+    bam_iter_t iter_;
+    std::unordered_map<std::string, int> target_ids_;
+    bam1_t *seq_ = bam_init1();
+    std::string filename_;
+    bool is_open_;
+    bool eof_;
+
+    void advance();
+};
+
+// Converts SAM file into coordinate-sorted BAM file <prefix>.bam and builds its
+// index. Only max_memory bytes of alignments are sorted in memory at once.
+// Returns the name of the BAM file.
+std::string SortAndIndexSam(const std::string &sam_filename, const std::string &prefix, size_t max_memory);
+
 }
 ;
@@ -12,23 +12,52 @@
 #include "bwa/rope.h"
 #include "bwa/utils.h"
 
+#include "utils/filesystem/glob.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <memory>
+#include <vector>
 
 #define MEM_F_SOFTCLIP  0x200
 
 #define _set_pac(pac, l, c) ((pac)[(l)>>2] |= uint8_t((c)<<((~(l)&3)<<1)))
 #define _get_pac(pac, l) ((pac)[(l)>>2]>>((~(l)&3)<<1)&3)
 extern "C" {
-int is_bwt(uint8_t *T, bwtint_t n);
+int is_sa(const ubyte_t *T, int *SA, int n);
 };
 
 namespace alignment {
 
-BWAIndex::BWAIndex(const debruijn_graph::Graph& g, AlignmentMode mode)
+namespace {
+
+// The index of the last graph seen, while some mapper still uses it. Mappers
+// over the same graph created meanwhile share it.
+struct IndexCache {
+    std::mutex mutex;
+    uint64_t hash = 0;
+    std::weak_ptr<bwaidx_t> idx;
+};
+
+IndexCache &LastIndex() {
+    static IndexCache cache;
+    return cache;
+}
+
+}
+
+BWAIndex::BWAIndex(const debruijn_graph::Graph& g, AlignmentMode mode, const std::string &index_dir)
         : g_(g),
           memopt_(mem_opt_init(), free),
-          idx_(nullptr, bwa_idx_destroy),
           mode_(mode),
           skip_secondary_(true) {
     memopt_->flag |= MEM_F_SOFTCLIP;
@@ -56,7 +85,7 @@ BWAIndex::BWAIndex(const debruijn_graph::Graph& g, AlignmentMode mode)
             break;
     };
 
-    Init();
+    Init(index_dir);
 }
 
 BWAIndex::~BWAIndex() {}
@@ -159,19 +188,45 @@ static bwt_t *seqlib_bwt_pac2bwt(const uint8_t *pac, size_t bwt_seq_lenr) {
     bwt->bwt_size = (bwt->seq_len + 15) >> 4;
 
     // Prepare sequence
-    memset(bwt->L2, 0, 5 * 4);
+    memset(bwt->L2, 0, 5 * sizeof(bwtint_t));
     buf = (ubyte_t*)calloc(bwt->seq_len + 1, 1);
+    bwtint_t cnt[4] = {0, 0, 0, 0};
+#   pragma omp parallel for reduction(+:cnt[:4])
     for (bwtint_t i = 0; i < bwt->seq_len; ++i) {
         buf[i] = pac[i>>2] >> ((3 - (i&3)) << 1) & 3;
-        ++bwt->L2[1+buf[i]];
+        ++cnt[buf[i]];
     }
-    for (bwtint_t i = 2; i <= 4; ++i)
-        bwt->L2[i] += bwt->L2[i-1];
+    for (bwtint_t i = 1; i <= 4; ++i)
+        bwt->L2[i] = bwt->L2[i-1] + cnt[i-1];
 
     // Burrows-Wheeler Transform
     if (bwt_seq_lenr < 50000000) {
         INFO("Using BWA IS algorithm");
-        bwt->primary = is_bwt(buf, bwt->seq_len);
+        // Keep the whole suffix array, so that both the BWT and the sampled
+        // suffix array are obtained from it directly instead of walking the BWT
+        bwtint_t n = bwt->seq_len;
+        std::vector<int> SA(n + 1);
+        int ret = is_sa(buf, SA.data(), int(n));
+        VERIFY_MSG(ret == 0, "Suffix array construction failed");
+        bwt->primary = std::find(SA.begin(), SA.end(), 0) - SA.begin();
+
+        ubyte_t *bwt_buf = (ubyte_t*)calloc(n + 1, 1);
+#       pragma omp parallel for
+        for (bwtint_t i = 0; i < n; ++i) {
+            bwtint_t j = i < bwt->primary ? i : i + 1;
+            bwt_buf[i] = buf[SA[j] - 1];
+        }
+        free(buf);
+        buf = bwt_buf;
+
+        // Same sampling as bwt_cal_sa(bwt, 32)
+        bwt->sa_intv = 32;
+        bwt->n_sa = (n + bwt->sa_intv) / bwt->sa_intv;
+        bwt->sa = (bwtint_t*)calloc(bwt->n_sa, sizeof(bwtint_t));
+#       pragma omp parallel for
+        for (bwtint_t i = 0; i < bwt->n_sa; ++i)
+            bwt->sa[i] = SA[i * bwt->sa_intv];
+        bwt->sa[0] = (bwtint_t)-1;
     } else {
         INFO("Using BWA RopeBWT algorithm");
         rope_t *r;
@@ -201,8 +256,11 @@ static bwt_t *seqlib_bwt_pac2bwt(const uint8_t *pac, size_t bwt_seq_lenr) {
         rope_destroy(r);
     }
     bwt->bwt = (uint32_t*)calloc(bwt->bwt_size, 4);
-    for (bwtint_t  i = 0; i < bwt->seq_len; ++i)
-        bwt->bwt[i>>4] |= buf[i] << ((15 - (i&15)) << 1);
+#   pragma omp parallel for
+    for (bwtint_t w = 0; w < bwt->bwt_size; ++w) {
+        for (bwtint_t i = w << 4; i < std::min((w + 1) << 4, bwt->seq_len); ++i)
+            bwt->bwt[w] |= buf[i] << ((15 - (i&15)) << 1);
+    }
     free(buf);
     return bwt;
 }
@@ -219,13 +277,8 @@ static bntann1_t* seqlib_add_to_anns(const std::string& name, const std::string&
     return ann;
 }
 
-void BWAIndex::Init() {
-    idx_.reset((bwaidx_t*)calloc(1, sizeof(bwaidx_t)));
-    ids_.clear();
-
-    for (debruijn_graph::EdgeId e : g_.canonical_edges()) {
-        ids_.push_back(e);
-    }
+bwaidx_t *BWAIndex::Build() const {
+    bwaidx_t *idx = (bwaidx_t*)calloc(1, sizeof(bwaidx_t));
 
     // construct the forward-only pac
     uint8_t* fwd_pac = seqlib_make_pac(g_, ids_, true); // true->for_only
@@ -243,8 +296,9 @@ void BWAIndex::Init() {
     bwt_bwtupdate_core(bwt);
     free(pac); // done with fwd-rev pac
 
-    // construct sa from bwt and occ. adds it to bwt struct
-    bwt_cal_sa(bwt, 32);
+    // construct sa from bwt and occ unless it was sampled together with bwt. adds it to bwt struct
+    if (!bwt->sa)
+        bwt_cal_sa(bwt, 32);
     bwt_gen_cnt_table(bwt);
 
     // make the bns
@@ -269,9 +323,131 @@ void BWAIndex::Init() {
     bns->ambs = 0;
 
     // Make the in-memory idx struct
-    idx_->bwt = bwt;
-    idx_->bns = bns;
-    idx_->pac = fwd_pac;
+    idx->bwt = bwt;
+    idx->bns = bns;
+    idx->pac = fwd_pac;
+
+    return idx;
+}
+
+uint64_t BWAIndex::GraphHash() const {
+    XXH64_state_t state;
+    XXH64_reset(&state, 0);
+    for (debruijn_graph::EdgeId e : ids_) {
+        std::string seq = g_.EdgeNucls(e).str();
+        uint64_t header[2] = { g_.int_id(e), seq.size() };
+        XXH64_update(&state, header, sizeof(header));
+        XXH64_update(&state, seq.data(), seq.size());
+    }
+    return XXH64_digest(&state);
+}
+
+static const char *INDEX_EXTENSIONS[] = { ".ann", ".amb", ".pac", ".sa", ".bwt" };
+
+bwaidx_t *BWAIndex::Load(const std::string &prefix) const {
+    for (const char *ext : INDEX_EXTENSIONS) {
+        if (!fs::check_existence(prefix + ext))
+            return nullptr;
+    }
+
+    INFO("Loading BWA index from " << prefix);
+    bwaidx_t *idx = (bwaidx_t*)calloc(1, sizeof(bwaidx_t));
+    idx->bwt = bwt_restore_bwt((prefix + ".bwt").c_str());
+    bwt_restore_sa((prefix + ".sa").c_str(), idx->bwt);
+    idx->bns = bns_restore(prefix.c_str());
+    // same as bwa_idx_load_from_disk()
+    idx->pac = (uint8_t*)calloc(idx->bns->l_pac/4 + 1, 1);
+    err_fread_noeof(idx->pac, 1, idx->bns->l_pac/4 + 1, idx->bns->fp_pac);
+    err_fclose(idx->bns->fp_pac);
+    idx->bns->fp_pac = 0;
+
+    size_t tlen = 0;
+    for (auto e : ids_)
+        tlen += g_.EdgeNucls(e).size();
+    if (size_t(idx->bns->n_seqs) != ids_.size() || size_t(idx->bns->l_pac) != tlen ||
+        idx->bwt->seq_len != 2 * tlen) {
+        WARN("BWA index " << prefix << " does not match the graph, rebuilding");
+        bwa_idx_destroy(idx);
+        return nullptr;
+    }
+
+    return idx;
+}
+
+void BWAIndex::Save(const bwaidx_t *idx, const std::string &prefix) const {
+    INFO("Saving BWA index to " << prefix);
+    // Everything is written aside and renamed into place, so that an interrupted
+    // save is never picked up
+    std::string tmp = prefix + ".tmp";
+    bns_dump(idx->bns, tmp.c_str());
+    {
+        // same layout as bns_fasta2bntseq() writes
+        FILE *fp = xopen((tmp + ".pac").c_str(), "wb");
+        int64_t l_pac = idx->bns->l_pac;
+        err_fwrite(idx->pac, 1, (l_pac >> 2) + ((l_pac & 3) == 0 ? 0 : 1), fp);
+        uint8_t ct = 0;
+        if (l_pac % 4 == 0)
+            err_fwrite(&ct, 1, 1, fp);
+        ct = uint8_t(l_pac % 4);
+        err_fwrite(&ct, 1, 1, fp);
+        err_fflush(fp);
+        err_fclose(fp);
+    }
+    bwt_dump_sa((tmp + ".sa").c_str(), idx->bwt);
+    bwt_dump_bwt((tmp + ".bwt").c_str(), idx->bwt);
+
+    for (const char *ext : INDEX_EXTENSIONS) {
+        if (std::rename((tmp + ext).c_str(), (prefix + ext).c_str())) {
+            WARN("Failed to save BWA index to " << prefix);
+            return;
+        }
+    }
+}
+
+void BWAIndex::Init(const std::string &index_dir) {
+    ids_.clear();
+
+    for (debruijn_graph::EdgeId e : g_.canonical_edges()) {
+        ids_.push_back(e);
+    }
+
+    uint64_t hash = GraphHash();
+    std::string prefix;
+    if (!index_dir.empty() && fs::check_existence(index_dir)) {
+        std::ostringstream name;
+        name << "bwa_" << std::hex << std::setw(16) << std::setfill('0') << hash;
+        prefix = fs::append_path(index_dir, name.str());
+        // bwa uses fixed-size buffers for the file names
+        if (prefix.size() > 1000)
+            prefix.clear();
+    }
+
+    IndexCache &cache = LastIndex();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.hash == hash)
+        idx_ = cache.idx.lock();
+    bool rebuilt = false;
+    if (idx_) {
+        DEBUG("Reusing BWA index of the same graph");
+    } else {
+        bwaidx_t *idx = prefix.empty() ? nullptr : Load(prefix);
+        if (!idx) {
+            idx = Build();
+            rebuilt = true;
+        }
+        idx_.reset(idx, bwa_idx_destroy);
+        cache.hash = hash;
+        cache.idx = idx_;
+    }
+
+    // A stale index under the same name is overwritten, otherwise it would be
+    // rejected and rebuilt on every run
+    if (!prefix.empty() && (rebuilt || !fs::check_existence(prefix + ".bwt"))) {
+        // Only the index of the latest graph is kept
+        for (const auto &file : fs::glob(fs::append_path(index_dir, "bwa_*")))
+            fs::remove_if_exists(file);
+        Save(idx_.get(), prefix);
+    }
 }
 
 #if 0
@@ -9,6 +9,9 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/paths/mapping_path.hpp"
 
+#include <memory>
+#include <string>
+
 extern "C" {
 struct bwaidx_s;
 typedef struct bwaidx_s bwaidx_t;
@@ -34,13 +37,20 @@ class BWAIndex {
 
     // bwaidx / memopt are incomplete below, therefore we need to outline ctor
     // and dtor.
-    BWAIndex(const debruijn_graph::Graph& g, AlignmentMode mode = AlignmentMode::Default);
+    // If index_dir exists, the index is cached there under the hash of the graph
+    // and is loaded instead of being rebuilt for the same graph.
+    BWAIndex(const debruijn_graph::Graph& g, AlignmentMode mode = AlignmentMode::Default,
+             const std::string &index_dir = "");
     ~BWAIndex();
 
     omnigraph::MappingPath<debruijn_graph::EdgeId> AlignSequence(const Sequence &sequence,
                                                                  bool only_simple = false) const;
   private:
-    void Init();
+    void Init(const std::string &index_dir);
+    uint64_t GraphHash() const;
+    bwaidx_t *Build() const;
+    bwaidx_t *Load(const std::string &prefix) const;
+    void Save(const bwaidx_t *idx, const std::string &prefix) const;
     omnigraph::MappingPath<debruijn_graph::EdgeId> GetMappingPath(const mem_alnreg_v&, const std::string &, bool = false) const;
 
     const debruijn_graph::Graph& g_;
@@ -48,8 +58,8 @@ class BWAIndex {
     // Store the options in memory
     std::unique_ptr<mem_opt_t, void(*)(void*)> memopt_;
 
-    // hold the full index structure
-    std::unique_ptr<bwaidx_t, void(*)(bwaidx_t*)> idx_;
+    // hold the full index structure, shared between the indices of the same graph
+    std::shared_ptr<bwaidx_t> idx_;
 
     std::vector<debruijn_graph::EdgeId> ids_;
 
@@ -120,6 +120,10 @@ public:
         TRACE("~EdgeIndex OK")
     }
 
+    bool IsDeferrable() const override {
+        return true;
+    }
+
     size_t k() const {
         return this->g().k() + 1;
     }
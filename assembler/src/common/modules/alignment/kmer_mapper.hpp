@@ -55,6 +55,10 @@ public:
 
     virtual ~KmerMapper() {}
 
+    bool IsDeferrable() const override {
+        return true;
+    }
+
     auto begin() const -> decltype(mapping_.begin()) {
         return mapping_.begin();
     }
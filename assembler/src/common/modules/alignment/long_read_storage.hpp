@@ -12,11 +12,17 @@
 #include "common/utils/logger/logger.hpp"
 #include "utils/filesystem/file_opener.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 #include <algorithm>
+#include <numeric>
 
 namespace debruijn_graph {
 
@@ -66,85 +72,128 @@ template<class Graph>
 class PathStorage {
     friend class PathInfo<Graph> ;
     typedef typename Graph::EdgeId EdgeId;
-    typedef std::map<EdgeId, std::set<PathInfo<Graph>>> InnerIndex;
+
+    // Every distinct path is stored once: its edges live in the common arena and
+    // the path is found by the fingerprint of the edges
+    struct PathRecord {
+        size_t offset;
+        size_t length;
+        size_t weight;
+        uint64_t fingerprint;
+        size_t next; // the next path with the same fingerprint
+    };
+    static constexpr size_t NO_PATH = -1ULL;
 
     const Graph &g_;
-    InnerIndex inner_index_;
+    std::vector<EdgeId> edges_;
+    std::vector<PathRecord> paths_;
+    phmap::flat_hash_map<uint64_t, size_t> index_;
     static const size_t kLongEdgeForStats = 500;
 
+    static uint64_t Fingerprint(const EdgeId *p, size_t length) {
+        static_assert(std::is_trivially_copyable<EdgeId>::value, "edge ids are hashed as raw bytes");
+        return XXH3_64bits(p, length * sizeof(EdgeId));
+    }
+
+    const EdgeId *path_begin(const PathRecord &r) const {
+        return edges_.data() + r.offset;
+    }
+
+    const EdgeId *path_end(const PathRecord &r) const {
+        return edges_.data() + r.offset + r.length;
+    }
+
+    size_t Find(const EdgeId *p, size_t length, uint64_t fingerprint) const {
+        auto it = index_.find(fingerprint);
+        if (it == index_.end())
+            return NO_PATH;
+        for (size_t id = it->second; id != NO_PATH; id = paths_[id].next) {
+            const PathRecord &r = paths_[id];
+            if (r.length == length && std::equal(p, p + length, path_begin(r)))
+                return id;
+        }
+        return NO_PATH;
+    }
+
+    // p must not point into the own arena
+    void Insert(const EdgeId *p, size_t length, uint64_t fingerprint, size_t w) {
+        size_t id = Find(p, length, fingerprint);
+        if (id != NO_PATH) {
+            paths_[id].weight += w;
+            return;
+        }
+
+        auto res = index_.emplace(fingerprint, paths_.size());
+        if (!res.second) {
+            id = res.first->second;
+            while (paths_[id].next != NO_PATH)
+                id = paths_[id].next;
+            paths_[id].next = paths_.size();
+        }
+        paths_.push_back({ edges_.size(), length, w, fingerprint, NO_PATH });
+        edges_.insert(edges_.end(), p, p + length);
+    }
+
     void HiddenAddPath(const std::vector<EdgeId> &p, int w) {
         if (p.size() == 0 ) return;
-        for (typename std::set<PathInfo<Graph>>::iterator iter = inner_index_[p[0]].begin(); iter != inner_index_[p[0]].end(); ++iter) {
-            if (iter->path() == p) {
-                iter->increase_weight(w);
-                return;
-            }
+        Insert(p.data(), p.size(), Fingerprint(p.data(), p.size()), w);
+    }
+
+    // The order of the paths in the dumps: by the first edge, then lexicographically
+    std::vector<size_t> SortedPaths() const {
+        std::vector<size_t> order(paths_.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return std::lexicographical_compare(path_begin(paths_[a]), path_end(paths_[a]),
+                                                path_begin(paths_[b]), path_end(paths_[b]));
+        });
+        return order;
+    }
+
+    // Splits the sorted paths into the runs sharing the first edge
+    template<class F>
+    void ForEachFirstEdge(const std::vector<size_t> &order, F f) const {
+        for (size_t i = 0, j; i < order.size(); i = j) {
+            EdgeId first = edges_[paths_[order[i]].offset];
+            for (j = i + 1; j < order.size() && edges_[paths_[order[j]].offset] == first; ++j);
+            f(order.begin() + i, order.begin() + j);
         }
-        inner_index_[p[0]].insert(PathInfo<Graph>(p, w));
-        size_++;
+    }
+
+    PathInfo<Graph> Info(size_t id) const {
+        const PathRecord &r = paths_[id];
+        return PathInfo<Graph>(std::vector<EdgeId>(path_begin(r), path_end(r)), r.weight);
     }
 
 public:
     PathStorage(const Graph &g)
-            : g_(g),
-              inner_index_(),
-              size_(0) {
-    }
-
-    PathStorage(const PathStorage & p)
-            : g_(p.g_),
-              inner_index_(),
-              size_(0) {
-        for (auto iter = p.inner_index_.begin(); iter != p.inner_index_.end();
-                iter++) {
-            for (auto j_iter = iter->second.begin();
-                    j_iter != iter->second.end(); j_iter++) {
-                this->AddPath(j_iter->path(), (int) j_iter->weight());
-            }
-        }
+            : g_(g) {
     }
 
     void ReplaceEdges(std::map<EdgeId, EdgeId> &old_to_new){
-        std::map<int, EdgeId> tmp_map;
-//        for (auto iter = g_.SmartEdgeBegin(); !iter.IsEnd(); ++iter ){
-//            tmp_map[g_.int_id(*iter)] = *iter;
-//        }
-        InnerIndex new_index;
-        for (auto iter = inner_index_.begin(); iter != inner_index_.end(); iter++) {
-            auto tmp = iter->second;
-            EdgeId new_first;
-            if (old_to_new.find(iter->first) == old_to_new.end())
-                new_first = iter->first;
-            else {
-                DEBUG("new first edge: "<< g_.int_id(old_to_new[iter->first]) << " with " << tmp.size() << " edges ");
-                new_first = old_to_new[iter->first];
-            }
-            std::set<PathInfo<Graph>> new_tmp;
-            for (auto j_iter = tmp.begin(); j_iter != tmp.end(); j_iter++) {
-                PathInfo<Graph> pi = *(j_iter);
-                for (size_t k = 0; k < pi.path().size(); k++)
-                    if (old_to_new.find(pi.path()[k]) != old_to_new.end()) {
-//                        INFO(g_.int_id(old_to_new[pi.path[k]]));
-                        pi.path()[k] = old_to_new[pi.path()[k]];
-                    }
-                DEBUG(pi.str(g_));
-                new_tmp.insert(pi);
-
-            }
-            if (new_first != iter->first) {
-                TRACE("and mmew_tmp.size: "<< new_tmp.size());
-            }
-            if (new_index.find(new_first) == new_index.end()) {
-                new_index[new_first] = new_tmp;
-            } else {
-                for (auto j_iter = new_tmp.begin(); j_iter != new_tmp.end(); j_iter++) {
-                    new_index[new_first].insert(*j_iter);
-                }
-            }
-
+        auto order = SortedPaths();
+        std::vector<EdgeId> edges;
+        std::vector<PathRecord> paths;
+        std::swap(edges, edges_);
+        std::swap(paths, paths_);
+        index_.clear();
+
+        for (EdgeId &e : edges) {
+            auto it = old_to_new.find(e);
+            if (it != old_to_new.end())
+                e = it->second;
         }
 
-        inner_index_ = new_index;
+        // Paths which became the same are not merged, the first one is kept
+        for (size_t id : order) {
+            const EdgeId *p = edges.data() + paths[id].offset;
+            size_t length = paths[id].length;
+            uint64_t fingerprint = Fingerprint(p, length);
+            if (Find(p, length, fingerprint) == NO_PATH)
+                Insert(p, length, fingerprint, paths[id].weight);
+            else
+                TRACE("Dropping duplicate path of " << length << " edges");
+        }
     }
 
     void AddPath(const std::vector<EdgeId> &p, int w, bool add_rc = false) {
@@ -164,21 +213,25 @@ public:
 
     void BinWrite(std::ostream &str) const {
         using io::binary::BinWrite;
-        BinWrite(str, inner_index_.size());
-        for (const auto &i : inner_index_) {
-            BinWrite(str, (size_t)i.second.size());
-            for (const auto &j : i.second) {
-                BinWrite(str, j.weight());
-                BinWrite(str, j.path().size());
-                for (const auto &p : j.path()) {
-                    BinWrite(str, g_.int_id(p));
+        auto order = SortedPaths();
+        size_t first_edges = 0;
+        ForEachFirstEdge(order, [&](auto, auto) { ++first_edges; });
+        BinWrite(str, first_edges);
+        ForEachFirstEdge(order, [&](auto begin, auto end) {
+            BinWrite(str, (size_t)(end - begin));
+            for (auto it = begin; it != end; ++it) {
+                const PathRecord &r = paths_[*it];
+                BinWrite(str, r.weight);
+                BinWrite(str, r.length);
+                for (const EdgeId *p = path_begin(r); p != path_end(r); ++p) {
+                    BinWrite(str, g_.int_id(*p));
                 }
             }
-        }
+        });
     }
 
     void BinRead(std::istream &str) {
-        inner_index_.clear();
+        Clear();
         using io::binary::BinRead;
 
         auto size = BinRead<size_t>(str);
@@ -201,28 +254,25 @@ public:
     void DumpToFile(const std::string& filename, const std::map<EdgeId, EdgeId>& replacement,
                     size_t stats_weight_cutoff = 1, bool need_log = false) const {
         std::ofstream filestr(filename);
-        std::set<EdgeId> continued_edges;
-
-        for(auto iter = inner_index_.begin(); iter != inner_index_.end(); ++iter){
-            filestr << iter->second.size() << std::endl;
-            int non1 = 0;
-            for (auto j_iter = iter->second.begin(); j_iter != iter->second.end(); ++j_iter) {
-                filestr << " Weight: " << j_iter->weight();
-                if (j_iter->weight() > stats_weight_cutoff)
-                    non1++;
-
-                filestr << " length: " << j_iter->path().size() << " ";
-                for (auto p_iter = j_iter->path().begin(); p_iter != j_iter->path().end(); ++p_iter) {
-                    if (p_iter != j_iter->path().end() - 1 && j_iter->weight() > stats_weight_cutoff) {
-                        continued_edges.insert(*p_iter);
+        phmap::flat_hash_set<EdgeId> continued_edges;
+
+        ForEachFirstEdge(SortedPaths(), [&](auto begin, auto end) {
+            filestr << end - begin << std::endl;
+            for (auto it = begin; it != end; ++it) {
+                const PathRecord &r = paths_[*it];
+                filestr << " Weight: " << r.weight;
+                filestr << " length: " << r.length << " ";
+                for (const EdgeId *p = path_begin(r); p != path_end(r); ++p) {
+                    if (p != path_end(r) - 1 && r.weight > stats_weight_cutoff) {
+                        continued_edges.insert(*p);
                     }
 
-                    filestr << g_.int_id(*p_iter) << "(" << g_.length(*p_iter) << ") ";
+                    filestr << g_.int_id(*p) << "(" << g_.length(*p) << ") ";
                 }
                 filestr << std::endl;
             }
             filestr << std::endl;
-        }
+        });
 
         int noncontinued = 0;
         int long_gapped = 0;
@@ -257,11 +307,10 @@ public:
     }
 
     void SaveAllPaths(std::vector<PathInfo<Graph>> &res) const {
-        for (auto iter = inner_index_.begin(); iter != inner_index_.end(); ++iter) {
-            for (auto j_iter = iter->second.begin(); j_iter != iter->second.end(); ++j_iter) {
-                res.push_back(*j_iter);
-            }
-        }
+        auto order = SortedPaths();
+        res.reserve(res.size() + order.size());
+        for (size_t id : order)
+            res.push_back(Info(id));
     }
 
     void LoadFromFile(const std::string &s, bool force_exists = true) {
@@ -317,34 +366,27 @@ public:
     }
 
     void AddStorage(PathStorage<Graph> &to_add) {
-        for (auto iter = to_add.inner_index_.begin(); iter != to_add.inner_index_.end(); iter++) {
-            for(auto j_iter = iter->second.begin(); j_iter != iter->second.end(); j_iter ++) {
-                this->AddPath(j_iter->path(), (int) j_iter->weight());
-            }
-        }
+        VERIFY(&to_add != this);
+        // The fingerprints are reused, so merging the per-thread buffers does not rehash the paths
+        for (const PathRecord &r : to_add.paths_)
+            Insert(to_add.path_begin(r), r.length, r.fingerprint, r.weight);
     }
 
     void Clear() {
-        inner_index_.clear();
-        size_ = 0;
+        edges_.clear();
+        paths_.clear();
+        index_.clear();
     }
 
     size_t size() const {
-        return size_;
-    }
-
-//    typename InnerIndex::iterator begin() const {
-//        return inner_index.begin();
-//    }
-//
-//    typename InnerIndex::iterator end() const {
-//        return inner_index.end();
-//    }
-//    typename InnerIndex::iterator operator*(){
-//        return this->first;
-//    }
-private:
-    size_t size_;
+        return paths_.size();
+    }
+
+    size_t mem_size() const {
+        return edges_.capacity() * sizeof(EdgeId) +
+               paths_.capacity() * sizeof(PathRecord) +
+               index_.capacity() * (sizeof(typename decltype(index_)::value_type) + 1);
+    }
 };
 
 template<class Graph>
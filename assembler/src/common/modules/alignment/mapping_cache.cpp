@@ -0,0 +1,145 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "mapping_cache.hpp"
+
+#include "io/binary/binary.hpp"
+#include "utils/filesystem/path_helper.hpp"
+
+#include <fstream>
+
+namespace debruijn_graph {
+
+namespace {
+
+// FNV-1a hash of the nucleotides, used to check that the replayed reads are the recorded ones
+uint32_t NuclHash(const std::string &s) {
+    uint32_t h = 2166136261u;
+    for (char c : s)
+        h = (h ^ uint8_t(c)) * 16777619u;
+    return h;
+}
+
+uint32_t NuclHash(const Sequence &s) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < s.size(); ++i)
+        h = (h ^ uint8_t(nucl(s[i]))) * 16777619u;
+    return h;
+}
+
+// Every path is stored as the length and the hash of the mapped sequence and the number
+// of mapping ranges followed by the ranges themselves. Integers are LEB128-encoded,
+// qualities are stored only for paths having some of them different from 1.
+class RecordingSequenceMapper : public SequenceMapper<Graph> {
+    const SequenceMapper<Graph> &inner_mapper_;
+    mutable std::ofstream os_;
+
+    void Write(const MappingPath<EdgeId> &path, size_t length, uint32_t hash) const {
+        bool with_quality = false;
+        for (size_t i = 0; i < path.size(); ++i)
+            with_quality |= (path[i].second.quality != 1.0);
+
+        io::binary::BinWrite(os_, length, hash, (path.size() << 1) | size_t(with_quality));
+        for (size_t i = 0; i < path.size(); ++i) {
+            const auto &mapping = path[i];
+            const Range &initial = mapping.second.initial_range, &mapped = mapping.second.mapped_range;
+            io::binary::BinWrite(os_, mapping.first.int_id(),
+                                 initial.start_pos, initial.size(),
+                                 mapped.start_pos, mapped.size());
+            if (with_quality)
+                io::binary::BinWrite(os_, mapping.second.quality);
+        }
+    }
+
+public:
+    RecordingSequenceMapper(const std::string &file, const SequenceMapper<Graph> &inner_mapper)
+            : inner_mapper_(inner_mapper), os_(file, std::ios::binary) {
+        CHECK_FATAL_ERROR(os_.good(), "Cannot open mapping cache file " << file);
+    }
+
+    MappingPath<EdgeId> MapSequence(const Sequence &s,
+                                    bool only_simple = false) const override {
+        auto path = inner_mapper_.MapSequence(s, only_simple);
+        Write(path, s.size(), NuclHash(s));
+        return path;
+    }
+
+    MappingPath<EdgeId> MapRead(const io::SingleRead &r,
+                                bool only_simple = false) const override {
+        auto path = inner_mapper_.MapRead(r, only_simple);
+        Write(path, r.size(), NuclHash(r.GetSequenceString()));
+        return path;
+    }
+};
+
+class ReplayingSequenceMapper : public SequenceMapper<Graph> {
+    mutable std::ifstream is_;
+
+    MappingPath<EdgeId> Read(size_t length, uint32_t hash) const {
+        size_t recorded_length, size;
+        uint32_t recorded_hash;
+        io::binary::BinRead(is_, recorded_length, recorded_hash, size);
+        VERIFY_MSG(is_.good(), "Mapping cache ended before the reads");
+        VERIFY_MSG(recorded_length == length && recorded_hash == hash,
+                   "Mapping cache is out of sync with the reads: expected read of length " <<
+                   recorded_length << " and hash " << recorded_hash << ", got " << length << " and " << hash);
+
+        bool with_quality = size & 1;
+        size >>= 1;
+
+        MappingPath<EdgeId> path;
+        for (size_t i = 0; i < size; ++i) {
+            uint64_t id;
+            size_t initial_start, initial_size, mapped_start, mapped_size;
+            io::binary::BinRead(is_, id, initial_start, initial_size, mapped_start, mapped_size);
+            double quality = 1.0;
+            if (with_quality)
+                io::binary::BinRead(is_, quality);
+            path.push_back(EdgeId(id),
+                           MappingRange(initial_start, initial_start + initial_size,
+                                        mapped_start, mapped_start + mapped_size, quality));
+        }
+
+        return path;
+    }
+
+public:
+    explicit ReplayingSequenceMapper(const std::string &file)
+            : is_(file, std::ios::binary) {
+        CHECK_FATAL_ERROR(is_.good(), "Cannot open mapping cache file " << file);
+    }
+
+    MappingPath<EdgeId> MapSequence(const Sequence &s,
+                                    bool /*only_simple*/ = false) const override {
+        return Read(s.size(), NuclHash(s));
+    }
+
+    MappingPath<EdgeId> MapRead(const io::SingleRead &r,
+                                bool /*only_simple*/ = false) const override {
+        return Read(r.size(), NuclHash(r.GetSequenceString()));
+    }
+};
+
+}
+
+MappingCache::MappingCache(fs::TmpDir workdir, size_t chunk_num)
+        : workdir_(workdir), chunk_num_(chunk_num), recorded_(false) {}
+
+std::string MappingCache::ChunkFile(size_t chunk) const {
+    VERIFY(chunk < chunk_num_);
+    return fs::append_path(workdir_->dir(), "chunk_" + std::to_string(chunk) + ".map");
+}
+
+std::unique_ptr<MappingCache::SequenceMapperT> MappingCache::ChunkMapper(size_t chunk,
+                                                                         const SequenceMapperT *mapper) const {
+    if (recorded_)
+        return std::make_unique<ReplayingSequenceMapper>(ChunkFile(chunk));
+
+    VERIFY(mapper);
+    return std::make_unique<RecordingSequenceMapper>(ChunkFile(chunk), *mapper);
+}
+
+} // namespace debruijn_graph
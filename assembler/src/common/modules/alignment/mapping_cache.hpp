@@ -0,0 +1,47 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "sequence_mapper.hpp"
+
+#include "utils/filesystem/temporary.hpp"
+
+#include <memory>
+#include <string>
+
+namespace debruijn_graph {
+
+// On-disk cache of the mappings of a read library, one file per binary read chunk.
+// The first pass over the library records the paths produced by the mapper, the
+// following passes over the same chunks replay them instead of mapping the reads again.
+// Paths refer to edge ids, so the cache is valid only while the graph stays intact.
+class MappingCache {
+public:
+    typedef SequenceMapper<Graph> SequenceMapperT;
+
+    MappingCache(fs::TmpDir workdir, size_t chunk_num);
+
+    size_t chunk_num() const { return chunk_num_; }
+    bool recorded() const { return recorded_; }
+
+    // Mapper to be used for the reads of a given chunk. Records the paths produced by
+    // mapper until the cache is marked as recorded, replays them afterwards (then mapper
+    // is not used and could be null).
+    // Reads should be mapped in the same order in every pass
+    std::unique_ptr<SequenceMapperT> ChunkMapper(size_t chunk, const SequenceMapperT *mapper) const;
+
+    void MarkRecorded() { recorded_ = true; }
+
+private:
+    std::string ChunkFile(size_t chunk) const;
+
+    fs::TmpDir workdir_;
+    size_t chunk_num_;
+    bool recorded_;
+};
+
+} // namespace debruijn_graph
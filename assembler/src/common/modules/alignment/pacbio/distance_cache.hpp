@@ -0,0 +1,107 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+namespace sensitive_aligner {
+
+// Memoized vertex-to-vertex distances shared by all aligning threads. Entries are
+// spread over independently locked shards, so lookups rarely wait for each other.
+class DistanceCache {
+  public:
+    typedef debruijn_graph::VertexId VertexId;
+
+    // Looks the distance up, counting the hit or miss
+    bool find(VertexId start, VertexId end, size_t &distance) const {
+        size_t h = Hash(start, end);
+        const Shard &shard = shards_[ShardIdx(h)];
+        std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+        auto it = shard.distances.find(std::make_pair(start, end));
+        if (it == shard.distances.end()) {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        distance = it->second;
+        return true;
+    }
+
+    bool contains(VertexId start, VertexId end) const {
+        size_t h = Hash(start, end);
+        const Shard &shard = shards_[ShardIdx(h)];
+        std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+        return shard.distances.find(std::make_pair(start, end)) != shard.distances.end();
+    }
+
+    void insert(VertexId start, VertexId end, size_t distance) {
+        size_t h = Hash(start, end);
+        Shard &shard = shards_[ShardIdx(h)];
+        std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+        shard.distances.emplace(std::make_pair(start, end), distance);
+    }
+
+    size_t hits() const {
+        size_t res = 0;
+        for (const auto &shard : shards_)
+            res += shard.hits.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    size_t misses() const {
+        size_t res = 0;
+        for (const auto &shard : shards_)
+            res += shard.misses.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    size_t size() const {
+        size_t res = 0;
+        for (const auto &shard : shards_) {
+            std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+            res += shard.distances.size();
+        }
+        return res;
+    }
+
+  private:
+    static constexpr size_t SHARDS = 64;
+
+    struct PairHash {
+        size_t operator()(const std::pair<VertexId, VertexId> &p) const {
+            return Hash(p.first, p.second);
+        }
+    };
+
+    // Keep the shards on separate cache lines, as counters are updated on every lookup
+    struct alignas(64) Shard {
+        mutable std::shared_timed_mutex mutex;
+        phmap::flat_hash_map<std::pair<VertexId, VertexId>, size_t, PairHash> distances;
+        mutable std::atomic<size_t> hits{0};
+        mutable std::atomic<size_t> misses{0};
+    };
+
+    static size_t Hash(VertexId start, VertexId end) {
+        return phmap::HashState().combine(0, start.int_id(), end.int_id());
+    }
+
+    static size_t ShardIdx(size_t h) {
+        return h % SHARDS;
+    }
+
+    std::array<Shard, SHARDS> shards_;
+};
+
+}
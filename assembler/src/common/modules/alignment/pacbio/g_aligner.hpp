@@ -40,8 +40,9 @@ class GAligner {
 
   GAligner(const debruijn_graph::Graph &g,
            const debruijn_graph::config::pacbio_processor &pb_config,
-           const alignment::BWAIndex::AlignmentMode &mode)
-    : pac_index_(g, pb_config, mode), g_(g), pb_config_(pb_config), restore_ends_(false), gap_filler_(g, GAlignerConfig(pb_config, mode)) {}
+           const alignment::BWAIndex::AlignmentMode &mode,
+           const std::string &index_dir = "")
+    : pac_index_(g, pb_config, mode, index_dir), g_(g), pb_config_(pb_config), restore_ends_(false), gap_filler_(g, GAlignerConfig(pb_config, mode)) {}
 
 
  private:
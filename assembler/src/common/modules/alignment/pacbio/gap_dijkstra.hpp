@@ -12,6 +12,8 @@
 #include "sequence/sequence_tools.hpp"
 #include "utils/perf/perfcounter.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace sensitive_aligner {
 
 using debruijn_graph::EdgeId;
@@ -156,6 +158,8 @@ class DijkstraGraphSequenceBase {
         , start_p_(start_p)
         , path_max_length_(path_max_length)
         , min_score_(std::numeric_limits<int>::max())
+        , min_bucket_(0)
+        , queue_size_(0)
         , queue_limit_(gap_cfg_.queue_limit)
         , iter_limit_(gap_cfg_.iteration_limit)
         , updates_(0) {
@@ -234,9 +238,26 @@ class DijkstraGraphSequenceBase {
     static const int SHORT_SEQ_LENGTH = 100;
     static const int ED_DEVIATION = 20;
 
-    std::set<std::pair<int, QueueState>> q_;
-    std::unordered_map<QueueState, int> visited_;
-    std::unordered_map<QueueState, QueueState> prev_states_;
+    struct StateInfo {
+        int score = 0;
+        bool in_queue = false;
+        QueueState prev;
+    };
+
+    // Scores are small non-negative edit distances, so the queue is a vector of
+    // buckets indexed by score. Each bucket is a min-heap to pop the states in the
+    // same order as an ordered set would. Entries of states which were rescored or
+    // removed since are not erased, but skipped when popped.
+    void Enqueue(const QueueState &state, StateInfo &info);
+
+    void Dequeue(StateInfo &info);
+
+    bool PopMin(QueueState &state, int &score);
+
+    std::vector<std::vector<QueueState>> buckets_;
+    size_t min_bucket_;
+    size_t queue_size_;
+    phmap::flat_hash_map<QueueState, StateInfo> states_;
     std::vector<int> best_ed_;
 
     const size_t queue_limit_;
@@ -36,11 +36,10 @@ GapFillerResult GapFiller::BestScoredPathDijkstra(const string &s,
                                 CreateBoundedDijkstra(g_, path_max_length);
     path_searcher.Run(start_v);
     const auto &reached_vertices_b = path_searcher_b.ProcessedVertices();
-    const auto &reached_vertices = path_searcher.ProcessedVertices();
 
     unordered_map<VertexId, size_t> vertex_pathlen;
     for (auto v : reached_vertices_b) {
-        if (reached_vertices.count(v) > 0) {
+        if (path_searcher.IsProcessed(v)) {
             vertex_pathlen[v] = path_searcher_b.GetDistance(v);
         }
     }
@@ -20,6 +20,7 @@
 
 #include "modules/alignment/pacbio/pacbio_read_structures.hpp"
 #include "modules/alignment/pacbio/gap_filler.hpp"
+#include "modules/alignment/pacbio/distance_cache.hpp"
 
 namespace sensitive_aligner {
 
@@ -37,19 +38,25 @@ class PacBioMappingIndex {
 
     PacBioMappingIndex(const Graph &g,
                        debruijn_graph::config::pacbio_processor pb_config,
-                       alignment::BWAIndex::AlignmentMode mode)
+                       alignment::BWAIndex::AlignmentMode mode,
+                       const std::string &index_dir = "")
         : g_(g),
           pb_config_(pb_config),
-          bwa_mapper_(g, mode) {
+          bwa_mapper_(g, mode, index_dir) {
         DEBUG("PB Mapping Index construction started");
         DEBUG("Index constructed");
         read_count_ = 0;
         rna_filtering_count_ = 0;
+        dijkstra_runs_ = 0;
     }
     ~PacBioMappingIndex(){
         if (pb_config_.rna_filtering) {
             INFO(rna_filtering_count_ << " times RNA alignmnent read filtering worked" );
         }
+        if (dijkstra_runs_) {
+            INFO("Distance cache: " << distance_cache_.hits() << " hits, " << distance_cache_.misses() << " misses, "
+                 << distance_cache_.size() << " distances from " << dijkstra_runs_ << " Dijkstra runs");
+        }
     }
     std::vector<std::vector<QualityRange>> GetChainingPaths(const io::SingleRead &read) const {
         std::vector<ColoredRange> ranged_colors = GetRangedColors(read);
@@ -94,8 +101,8 @@ class PacBioMappingIndex {
 
     static const size_t DISTANT_IN_GRAPH = 1000;
     static const size_t MAX_VERTICES_IN_DIJKSTRA_FILTERING = 500;
-    //presumably separate class for this and GetDistance
-    mutable std::map<std::pair<VertexId, VertexId>, size_t> distance_cashed_;
+    mutable DistanceCache distance_cache_;
+    mutable std::atomic<size_t> dijkstra_runs_;
     size_t read_count_;
     
     mutable size_t rna_filtering_count_;
@@ -173,7 +180,7 @@ class PacBioMappingIndex {
         size_t result = DISTANT_IN_GRAPH;
         for (auto v: first_edge) {
             auto dijkstra(
-                    omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateUnorientedBoundedDijkstra(g_,
+                    omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateUnorientedBoundedDijkstra<omnigraph::DenseDijkstraStorage<debruijn_graph::Graph>>(g_,
                                                                                             DISTANT_IN_GRAPH,
                                                                                             MAX_VERTICES_IN_DIJKSTRA_FILTERING
                     ));
@@ -302,6 +309,14 @@ class PacBioMappingIndex {
         size_t i = 0;
         for (auto i_iter = mapping_descr.begin(); i_iter != mapping_descr.end();
                 ++i_iter, ++i) {
+            // All distances from the same vertex are obtained by a single Dijkstra run
+            std::vector<VertexId> ends;
+            for (auto j_iter = std::next(i_iter); j_iter != mapping_descr.end(); ++j_iter) {
+                if (!TooFarInRead(*i_iter, *j_iter))
+                    ends.push_back(g_.EdgeStart(j_iter->edgeId));
+            }
+            PrefetchDistances(g_.EdgeEnd(i_iter->edgeId), ends);
+
             size_t j = i;
             for (auto j_iter = i_iter;
                     j_iter != mapping_descr.end(); ++j_iter, ++j) {
@@ -398,39 +413,56 @@ class PacBioMappingIndex {
         return res;
     }
 
+    omnigraph::DijkstraHelper<debruijn_graph::Graph>::DenseBoundedDijkstra RunDijkstra(VertexId start_v) const {
+        omnigraph::DijkstraHelper<debruijn_graph::Graph>::DenseBoundedDijkstra dijkstra(
+            omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra<omnigraph::DenseDijkstraStorage<debruijn_graph::Graph>>(g_,
+                    pb_config_.max_path_in_dijkstra,
+                    pb_config_.max_vertex_in_dijkstra));
+        dijkstra.Run(start_v);
+        dijkstra_runs_ += 1;
+        return dijkstra;
+    }
+
     size_t GetDistance(VertexId start_v, VertexId end_v,
                        bool update_cache = true) const {
         size_t result = size_t(-1);
-        auto vertex_pair = std::make_pair(start_v, end_v);
-        bool not_found;
-        auto distance_it = distance_cashed_.begin();
-        //FIXME should permit multiple readers
-        #pragma omp critical(pac_index)
-        {
-            distance_it = distance_cashed_.find(vertex_pair);
-            not_found = (distance_it == distance_cashed_.end());
-        }
-        if (not_found) {
-            omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
-                omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
-                        pb_config_.max_path_in_dijkstra,
-                        pb_config_.max_vertex_in_dijkstra));
-            dijkstra.Run(start_v);
-            if (dijkstra.DistanceCounted(end_v)) {
-                result = dijkstra.GetDistance(end_v);
-            }
-            if (update_cache) {
-                #pragma omp critical(pac_index)
-                distance_cashed_.insert({vertex_pair, result});
-            }
-        } else {
+        if (distance_cache_.find(start_v, end_v, result)) {
             TRACE("taking from cashed");
-            result = distance_it->second;
+            return result;
         }
 
+        auto dijkstra = RunDijkstra(start_v);
+        result = dijkstra.DistanceCounted(end_v) ? dijkstra.GetDistance(end_v) : size_t(-1);
+        if (update_cache)
+            distance_cache_.insert(start_v, end_v, result);
+
         return result;
     }
 
+    // Caches distances to all the vertices not yet known. Dijkstra run does not
+    // depend on the target, so the results are the same as of separate queries.
+    void PrefetchDistances(VertexId start_v, const std::vector<VertexId> &end_vs) const {
+        std::vector<VertexId> missing;
+        for (VertexId end_v : end_vs) {
+            if (!distance_cache_.contains(start_v, end_v))
+                missing.push_back(end_v);
+        }
+        if (missing.empty())
+            return;
+
+        auto dijkstra = RunDijkstra(start_v);
+        for (VertexId end_v : missing)
+            distance_cache_.insert(start_v, end_v,
+                                   dijkstra.DistanceCounted(end_v) ? dijkstra.GetDistance(end_v) : size_t(-1));
+    }
+
+    bool TooFarInRead(const QualityRange &a,
+                      const QualityRange &b) const {
+        return a.sorted_positions[a.last_trustable_index].read_position +
+               (int) pb_config_.max_path_in_dijkstra <
+               b.sorted_positions[b.first_trustable_index].read_position;
+    }
+
     bool IsConsistent(const QualityRange &a,
                       const QualityRange &b) const {
         EdgeId a_edge = a.edgeId;
@@ -442,9 +474,7 @@ class PacBioMappingIndex {
             return true;
         }
         //FIXME: Is this check useful?
-        if (a.sorted_positions[a.last_trustable_index].read_position +
-                (int) pb_config_.max_path_in_dijkstra <
-                b.sorted_positions[b.first_trustable_index].read_position) {
+        if (TooFarInRead(a, b)) {
             DEBUG("Clusters are too far in read");
             return false;
         }
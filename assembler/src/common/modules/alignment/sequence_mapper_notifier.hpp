@@ -9,6 +9,7 @@
 #define SEQUENCE_MAPPER_NOTIFIER_HPP_
 
 #include "sequence_mapper.hpp"
+#include "mapping_cache.hpp"
 
 #include "assembly_graph/paths/mapping_path.hpp"
 #include "assembly_graph/core/graph.hpp"
@@ -54,6 +55,33 @@ public:
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, &mapper, nullptr, threads_count);
+    }
+
+    // Same as above, but the mappings are recorded into (on the first pass) or
+    // replayed from (on the following ones) the cache instead of mapping every read
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingCache &cache, size_t threads_count = 0) {
+        VERIFY(streams.size() == cache.chunk_num());
+        ProcessLibrary(streams, lib_index, &mapper, &cache, threads_count);
+        cache.MarkRecorded();
+    }
+
+    // Replays the mappings already recorded into the cache, so no mapper is needed
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const MappingCache &cache, size_t threads_count = 0) {
+        VERIFY(cache.recorded() && streams.size() == cache.chunk_num());
+        ProcessLibrary(streams, lib_index, nullptr, &cache, threads_count);
+    }
+
+private:
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT *mapper,
+                        const MappingCache *cache, size_t threads_count) {
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
@@ -68,6 +96,10 @@ public:
             size_t size = 0;
             ReadType r;
             auto& stream = streams[i];
+            std::unique_ptr<SequenceMapperT> chunk_mapper;
+            if (cache)
+                chunk_mapper = cache->ChunkMapper(i, mapper);
+            const SequenceMapperT &stream_mapper = (chunk_mapper ? *chunk_mapper : *mapper);
             while (!stream.eof()) {
                 if (size == BUFFER_SIZE) {
                     #pragma omp critical
@@ -83,7 +115,7 @@ public:
                 }
                 stream >> r;
                 ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
+                NotifyProcessRead(r, stream_mapper, lib_index, i);
             }
             #pragma omp atomic
             counter += size;
@@ -96,7 +128,6 @@ public:
         NotifyStopProcessLibrary(lib_index);
     }
 
-private:
     template<class ReadType>
     void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
 
@@ -131,7 +131,7 @@ bool LoopTraverser::TraverseLoop(EdgeId start, EdgeId end, const std::set<Vertex
         VertexId first_vertex = g_.EdgeStart(end_path.Front());
 
         if (first_vertex != last_vertex) {
-            auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g_, shortest_path_limit_,
+            auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra<omnigraph::DenseDijkstraStorage<Graph>>(g_, shortest_path_limit_,
                                                                                     DIJKSTRA_LIMIT,
                                                                                     true /* collect traceback */);
             dijkstra.Run(last_vertex);
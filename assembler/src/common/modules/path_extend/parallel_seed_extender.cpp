@@ -0,0 +1,152 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "parallel_seed_extender.hpp"
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+namespace path_extend {
+
+struct ParallelSeedExtender::Worker {
+    Worker(const Graph &g, UsedUniqueStorage &shared_storage, const ExtendersFactory &factory)
+            : cover_map(g, 0),
+              used_storage(&shared_storage),
+              extender(g, cover_map, used_storage, factory(cover_map, used_storage)),
+              seeds(0), edges(0), time(0.) {}
+
+    //Unsubscribes speculative paths from the private coverage map and drops the state
+    //accumulated by the extenders, so that the next seed is grown from scratch
+    void Reset() {
+        for (auto it = speculated.begin(); it != speculated.end(); ++it)
+            it.get().Clear();
+        speculated.clear();
+        extender.Reset();
+    }
+
+    GraphCoverageMap cover_map;
+    UsedUniqueStorage used_storage;
+    CompositeExtender extender;
+    PathContainer speculated;
+
+    size_t seeds;
+    size_t edges;
+    double time;
+};
+
+ParallelSeedExtender::ParallelSeedExtender(const Graph &g, CompositeExtender &main_extender,
+                                           const ExtendersFactory &factory,
+                                           size_t nthreads, size_t batch_size)
+        : g_(g), main_extender_(main_extender),
+          batch_size_(std::max<size_t>(batch_size, 1)),
+          committed_(0), regrown_(0) {
+    VERIFY(nthreads > 0);
+    INFO("Creating extenders for " << nthreads << " extension threads");
+    for (size_t i = 0; i < nthreads; ++i)
+        workers_.push_back(std::make_unique<Worker>(g_, main_extender_.used_storage(), factory));
+}
+
+ParallelSeedExtender::~ParallelSeedExtender() = default;
+
+void ParallelSeedExtender::Speculate(Worker &worker, const BidirectionalPath &seed, Speculation &spec) const {
+    utils::perf_counter timer;
+    worker.used_storage.clear();
+
+    //Coverage of committed paths only grows, so a seed covered now is covered at commit
+    spec.skipped = !worker.extender.UseSeed(seed) || main_extender_.cover_map().IsCovered(seed);
+    if (!spec.skipped) {
+        const auto &path = worker.extender.GrowSeed(seed, worker.speculated);
+        worker.edges += path.Size() - std::min(path.Size(), seed.Size());
+        for (EdgeId e : worker.used_storage.local_used()) {
+            if (!worker.used_storage.IsUsed(e, seed.GetId()))
+                spec.acquired.push_back(e);
+        }
+        for (size_t i = 0; i < worker.speculated.size(); ++i)
+            spec.paths.AddPair(BidirectionalPath::clone(worker.speculated.Get(i)),
+                               BidirectionalPath::clone(worker.speculated.GetConjugate(i)));
+    }
+    worker.Reset();
+
+    worker.seeds += 1;
+    worker.time += timer.time();
+}
+
+bool ParallelSeedExtender::HasConflicts(const Speculation &spec) const {
+    const auto &used_storage = main_extender_.used_storage();
+    for (EdgeId e : spec.acquired) {
+        if (used_storage.IsUsed(e))
+            return true;
+    }
+    return false;
+}
+
+void ParallelSeedExtender::Commit(const BidirectionalPath &seed, const Speculation &spec, PathContainer& result) {
+    if (!main_extender_.UseSeed(seed) || main_extender_.cover_map().IsCovered(seed))
+        return;
+
+    if (spec.skipped || HasConflicts(spec)) {
+        DEBUG("Conflict detected, re-growing seed " << seed.GetId());
+        main_extender_.GrowSeed(seed, result);
+        regrown_ += 1;
+        return;
+    }
+
+    for (size_t i = 0; i < spec.paths.size(); ++i) {
+        auto ppair = result.AddPair(BidirectionalPath::clone(spec.paths.Get(i)),
+                                    BidirectionalPath::clone(spec.paths.GetConjugate(i)));
+        //Only the path grown from the seed is tracked, same as in CompositeExtender::GrowSeed
+        if (i != 0)
+            continue;
+
+        main_extender_.cover_map().Subscribe(ppair);
+        for (EdgeId e : spec.acquired)
+            main_extender_.used_storage().insert(e, ppair.first.GetId());
+    }
+    committed_ += 1;
+}
+
+void ParallelSeedExtender::GrowAll(PathContainer& paths, PathContainer& result) {
+    result.clear();
+    utils::perf_counter timer;
+
+    size_t nthreads = workers_.size();
+    size_t report_step = paths.size() / 10 + 1;
+    size_t next_report = report_step;
+    std::vector<Speculation> specs;
+    for (size_t start = 0; start < paths.size(); start += batch_size_) {
+        size_t end = std::min(paths.size(), start + batch_size_);
+        specs.clear();
+        specs.resize(end - start);
+
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+        for (size_t i = start; i < end; ++i)
+            Speculate(*workers_[omp_get_thread_num()], paths.Get(i), specs[i - start]);
+
+        for (size_t i = start; i < end; ++i)
+            Commit(paths.Get(i), specs[i - start], result);
+
+        if (paths.size() > 10 && end >= next_report) {
+            INFO("Processed " << end << " paths from " << paths.size() << " (" << end * 100 / paths.size() << "%)");
+            next_report = (end / report_step + 1) * report_step;
+        }
+    }
+
+    result.FilterEmptyPaths();
+    ReportStats(timer.time());
+}
+
+void ParallelSeedExtender::ReportStats(double total_time) const {
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        const Worker &worker = *workers_[i];
+        double time = std::max(worker.time, 1e-6);
+        INFO("Extension thread #" << i << ": " << worker.seeds << " seeds, " << worker.edges << " edges added in "
+             << utils::human_readable_time(worker.time) << " (" << size_t(double(worker.seeds) / time) << " seeds/s)");
+    }
+    INFO("Parallel extension finished in " << utils::human_readable_time(total_time) << ": "
+         << committed_ << " speculative paths committed, " << regrown_ << " seeds re-grown due to conflicts");
+}
+
+}
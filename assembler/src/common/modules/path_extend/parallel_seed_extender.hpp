@@ -0,0 +1,64 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "path_extender.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace path_extend {
+
+/* Grows seeds concurrently on several threads.
+ * Seeds are processed in batches. Within a batch every seed is grown speculatively by a
+ * thread-local CompositeExtender against a snapshot of the shared state taken at the batch start:
+ * a private coverage map and an overlay over the shared UsedUniqueStorage. Worker extenders are
+ * reset after every seed, so a speculative path depends only on its seed and that snapshot.
+ * Afterwards speculative paths are committed sequentially in seed order. A path that acquired a
+ * unique edge taken by a path committed earlier in the same batch is discarded and the seed is
+ * re-grown by the main extender. Thus for a fixed batch size the result does not depend on the
+ * number of threads or on scheduling. It may differ from sequential extension, since a
+ * speculative path does not see the paths committed earlier in its batch. */
+class ParallelSeedExtender {
+public:
+    typedef std::vector<std::shared_ptr<PathExtender>> Extenders;
+    typedef std::function<Extenders(const GraphCoverageMap &, UsedUniqueStorage &)> ExtendersFactory;
+
+    ParallelSeedExtender(const Graph &g, CompositeExtender &main_extender,
+                         const ExtendersFactory &factory,
+                         size_t nthreads, size_t batch_size);
+    ~ParallelSeedExtender();
+
+    void GrowAll(PathContainer& paths, PathContainer& result);
+
+private:
+    struct Worker;
+    struct Speculation {
+        bool skipped = false;
+        //Speculative paths, the first one is grown from the seed
+        PathContainer paths;
+        std::vector<EdgeId> acquired;
+    };
+
+    void Speculate(Worker &worker, const BidirectionalPath &seed, Speculation &spec) const;
+    void Commit(const BidirectionalPath &seed, const Speculation &spec, PathContainer& result);
+    bool HasConflicts(const Speculation &spec) const;
+    void ReportStats(double total_time) const;
+
+    const Graph &g_;
+    CompositeExtender &main_extender_;
+    size_t batch_size_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    size_t committed_;
+    size_t regrown_;
+
+    DECL_LOGGER("ParallelSeedExtender")
+};
+
+}
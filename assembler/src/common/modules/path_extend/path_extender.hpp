@@ -407,6 +407,13 @@ public:
         DEBUG("add cycle");
         p.first.PrintDEBUG();
     }
+
+    //Forgets the cycles found while growing previous paths
+    void Clear() {
+        for (auto it = path_storage_.begin(); it != path_storage_.end(); ++it)
+            it.get().Clear();
+        path_storage_.clear();
+    }
 };
 
 class PathExtender {
@@ -416,6 +423,8 @@ public:
 
     virtual ~PathExtender() = default;
     virtual bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage = nullptr) = 0;
+    //Drops the state accumulated while growing previous paths
+    virtual void Reset() { }
 
 protected:
     const Graph &g_;
@@ -442,6 +451,19 @@ public:
         while (MakeGrowStep(path, paths_storage)) { }
     }
 
+    //Marks unique edges of the seed as used, returns false if the seed should be skipped
+    bool UseSeed(const BidirectionalPath &seed);
+    //Creates a path from the seed in result and grows it in both directions
+    BidirectionalPath& GrowSeed(const BidirectionalPath &seed, PathContainer& result);
+
+    void Reset() {
+        for (auto &ext : extenders_)
+            ext->Reset();
+    }
+
+    GraphCoverageMap &cover_map() { return cover_map_; }
+    UsedUniqueStorage &used_storage() { return used_storage_; }
+
 private:
     const Graph &g_;
     GraphCoverageMap &cover_map_;
@@ -494,6 +516,9 @@ public:
 
     bool TryToResolveTwoLoops(BidirectionalPath& path);
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) override;
+    void Reset() override {
+        is_detector_.Clear();
+    }
 
 private:
     bool ResolveShortLoop(BidirectionalPath& p) {
@@ -29,49 +29,52 @@ bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* pat
     return false;
 }
 
+bool CompositeExtender::UseSeed(const BidirectionalPath &seed) {
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    if (!used_storage_.UniqueCheckEnabled())
+        return true;
+
+    auto path_id = seed.GetId();
+    for (size_t ind = 0; ind < seed.Size(); ind++) {
+        EdgeId eid = seed.At(ind);
+        if (used_storage_.IsUsedAndUnique(eid, path_id)) {
+            DEBUG("Used edge " << g_.int_id(eid));
+            DEBUG("skipping already used seed");
+            return false;
+        }
+        used_storage_.insert(eid, path_id);
+    }
+    return true;
+}
+
+BidirectionalPath& CompositeExtender::GrowSeed(const BidirectionalPath &seed, PathContainer& result) {
+    BidirectionalPath &path = CreatePath(result, cover_map_, seed);
+
+    size_t count_trying = 0;
+    size_t current_path_len = 0;
+    do {
+        current_path_len = path.Length();
+        count_trying++;
+        GrowPath(path, &result);
+        GrowPath(*path.GetConjPath(), &result);
+    } while (count_trying < 10 && (path.Length() != current_path_len));
+    DEBUG("result path " << path.GetId());
+    path.PrintDEBUG();
+    return path;
+}
+
 void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result) {
     for (size_t i = 0; i < paths.size(); ++i) {
         VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
             INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
-            }
-        }
+        if (!UseSeed(paths.Get(i)))
+            continue;
 
-        if (!cover_map_.IsCovered(paths.Get(i))) {
-            BidirectionalPath &path = CreatePath(result, cover_map_,
-                                                 paths.Get(i));
-
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
-        }
+        if (!cover_map_.IsCovered(paths.Get(i)))
+            GrowSeed(paths.Get(i), result);
     }
 }
 
@@ -160,6 +160,13 @@ void load(pe_config::ParamSetT::OverlapRemovalOptionsT& ors,
     load(ors.cut_all, pt, "cut_all"      , complete);
 }
 
+void load(pe_config::ParamSetT::ParallelExtensionT& pe,
+          boost::property_tree::ptree const& pt, bool complete) {
+    using config_common::load;
+    load(pe.enabled, pt, "enabled", complete);
+    load(pe.batch_size, pt, "batch_size", complete);
+}
+
 void load(pe_config::ParamSetT::SimpleCoverageResolver& scr,
           boost::property_tree::ptree const& pt, bool complete)
 {
@@ -177,6 +184,7 @@ void load(pe_config::ParamSetT& p, boost::property_tree::ptree const& pt, bool c
     load(p.normalize_weight, pt,  "normalize_weight", complete);
     load(p.overlap_removal, pt, "overlap_removal", complete);
     load(p.multi_path_extend, pt, "multi_path_extend", complete);
+    load(p.parallel_extension, pt, "parallel_extension", complete);
     load(p.extension_options, pt, "extension_options", complete);
     load(p.mate_pair_options, pt, "mate_pair_options", complete);
     load(p.scaffolder_options, pt, "scaffolder", complete);
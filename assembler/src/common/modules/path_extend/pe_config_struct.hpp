@@ -69,6 +69,11 @@ struct pe_config {
 
         bool multi_path_extend;
 
+        struct ParallelExtensionT {
+            bool enabled;
+            size_t batch_size;
+        } parallel_extension;
+
         struct OverlapRemovalOptionsT {
             bool enabled;
             bool end_start_only;
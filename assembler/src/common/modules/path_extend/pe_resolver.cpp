@@ -8,6 +8,7 @@
 #include "overlap_remover.hpp"
 #include "path_deduplicator.hpp"
 #include "path_extender.hpp"
+#include "parallel_seed_extender.hpp"
 
 namespace path_extend {
 
@@ -53,6 +54,12 @@ PathContainer PathExtendResolver::ExtendSeeds(PathContainer &seeds, CompositeExt
     return paths;
 }
 
+PathContainer PathExtendResolver::ExtendSeeds(PathContainer &seeds, ParallelSeedExtender &parallel_extender) const {
+    PathContainer paths;
+    parallel_extender.GrowAll(seeds, paths);
+    return paths;
+}
+
 //Paths should be deduplicated first!
 void PathExtendResolver::RemoveOverlaps(PathContainer &paths, GraphCoverageMap &coverage_map,
                                         size_t min_edge_len, size_t max_path_diff,
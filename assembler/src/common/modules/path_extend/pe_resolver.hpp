@@ -13,6 +13,7 @@
 namespace path_extend {
 
 class CompositeExtender;
+class ParallelSeedExtender;
 class GraphCoverageMap;
 
 void Deduplicate(const debruijn_graph::Graph &g, PathContainer &paths, GraphCoverageMap &coverage_map,
@@ -28,6 +29,7 @@ public:
     
     PathContainer MakeSimpleSeeds() const;
     PathContainer ExtendSeeds(PathContainer &seeds, CompositeExtender &composite_extender) const;
+    PathContainer ExtendSeeds(PathContainer &seeds, ParallelSeedExtender &parallel_extender) const;
 
     //Paths should be deduplicated first!
     void RemoveOverlaps(PathContainer &paths, GraphCoverageMap &coverage_map,
@@ -66,9 +66,13 @@ public:
 
     GraphCoverageMap(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
+    GraphCoverageMap(const Graph& g, size_t expected_edges) : g_(g) {
+        edge_coverage_.reserve(expected_edges);
+    }
+
+    explicit GraphCoverageMap(const Graph& g)
+            : GraphCoverageMap(g, g.e_size()) {
         //FIXME heavy constructor
-        edge_coverage_.reserve(g_.e_size());
     }
 
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
@@ -14,11 +14,14 @@
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/loop_traverser.hpp"
 #include "modules/path_extend/path_extender.hpp"
+#include "modules/path_extend/parallel_seed_extender.hpp"
 #include "modules/path_extend/scaffolder2015/extension_chooser2015.hpp"
 #include "modules/path_extend/scaffolder2015/scaffold_graph_visualizer.hpp"
 #include "modules/path_extend/scaffolder2015/scaffold_graph_constructor.hpp"
 #include "modules/path_extend/scaffolder2015/path_polisher.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 #include <unordered_set>
 
 namespace path_extend {
@@ -319,7 +322,7 @@ void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::FillMPUniqueEdgeStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -334,8 +337,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -407,17 +408,24 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
-}
+void PathExtendLauncher::PrepareExtenderStorages() {
+    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
+    bool plasmid = config::PipelineHelper::IsPlasmidPipeline(params_.mode);
+    if (!plasmid && (support_.SingleReadsMapped() || support_.HasLongReads()))
+        FillLongReadsCoverageMaps();
+
+    if (params_.pset.sm == scaffolding_mode::sm_old)
+        return;
 
+    if (!plasmid && support_.HasLongReads())
+        FillPBUniqueEdgeStorages();
+
+    if (support_.HasMPReads())
+        FillMPUniqueEdgeStorages();
+}
 
 Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
-                                                 UsedUniqueStorage &used_unique_storage) {
-    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
-    if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) &&  (support_.SingleReadsMapped() || support_.HasLongReads()))
-        FillLongReadsCoverageMaps();
+                                                 UsedUniqueStorage &used_unique_storage) const {
     ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
                                  unique_data_, used_unique_storage, support_);
     Extenders extenders = generator.MakeBasicExtenders();
@@ -429,7 +437,7 @@ Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_m
         if (params_.pset.sm == scaffolding_mode::sm_old) {
             INFO("Will not use new long read scaffolding algorithm in this mode");
         } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
+            utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
         }
     }
 
@@ -437,17 +445,40 @@ Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_m
         if (params_.pset.sm == scaffolding_mode::sm_old) {
             INFO("Will not use mate-pairs is this mode");
         } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
+            utils::push_back_all(extenders, generator.MakeMPExtenders());
         }
     }
 
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
 
-    INFO("Total number of extenders is " << extenders.size());
+    DEBUG("Total number of extenders is " << extenders.size());
     return extenders;
 }
 
+PathContainer PathExtendLauncher::ExtendSeeds(PathContainer &seeds, const PathExtendResolver &resolver,
+                                              GraphCoverageMap &cover_map) const {
+    UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
+    Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
+    INFO("Total number of extenders is " << extenders.size());
+    CompositeExtender composite_extender(graph_, cover_map,
+                                         used_unique_storage,
+                                         extenders);
+
+    const auto &parallel_params = params_.pset.parallel_extension;
+    size_t nthreads = omp_get_max_threads();
+    if (!parallel_params.enabled || nthreads == 1)
+        return resolver.ExtendSeeds(seeds, composite_extender);
+
+    INFO("Seeds will be extended in parallel using " << nthreads << " threads");
+    ParallelSeedExtender parallel_extender(graph_, composite_extender,
+                                           [this](const GraphCoverageMap &local_cover_map, UsedUniqueStorage &storage) {
+                                               return ConstructExtenders(local_cover_map, storage);
+                                           },
+                                           nthreads, parallel_params.batch_size);
+    return resolver.ExtendSeeds(seeds, parallel_extender);
+}
+
 void PathExtendLauncher::PolishPaths(const PathContainer &paths, PathContainer &result,
                                      const GraphCoverageMap& /* cover_map */) const {
     //Fixes distances for paths gaps and tries to fill them in
@@ -626,14 +657,9 @@ void PathExtendLauncher::Launch() {
     if (params_.pe_cfg.debug_output)
         MakeConjugateEdgePairsDump(graph_);
 
+    PrepareExtenderStorages();
     GraphCoverageMap cover_map(graph_);
-    UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
-    Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
-    CompositeExtender composite_extender(graph_, cover_map,
-                                         used_unique_storage,
-                                         extenders);
-
-    auto paths = resolver.ExtendSeeds(seeds, composite_extender);
+    auto paths = ExtendSeeds(seeds, resolver, cover_map);
     DebugOutputPaths(paths, "raw_paths");
 
     RemoveOverlapsAndArtifacts(paths, cover_map, resolver);
@@ -70,13 +70,16 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    void PrepareExtenderStorages();
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage) const;
 
-    void AddScaffUniqueStorage(size_t uniqe_edge_len);
+    PathContainer ExtendSeeds(PathContainer &seeds, const PathExtendResolver &resolver,
+                              GraphCoverageMap &cover_map) const;
+
+    void FillMPUniqueEdgeStorages();
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
     void FilterPaths();
 
@@ -234,29 +234,7 @@ class AlternativesAnalyzer {
         return math::ge(identity, min_identity_);
     }
 
-
-public:
-    AlternativesAnalyzer(const Graph& g, double max_coverage, size_t max_length,
-                         double max_relative_coverage, size_t max_delta,
-                         double max_relative_delta, size_t max_edge_cnt,
-                         size_t dijkstra_vertex_limit, double min_identity) :
-                         g_(g),
-                         max_coverage_(max_coverage),
-                         max_length_(max_length),
-                         max_relative_coverage_(max_relative_coverage),
-                         max_delta_(max_delta),
-                         max_relative_delta_(max_relative_delta),
-                         max_edge_cnt_(max_edge_cnt),
-                         dijkstra_vertex_limit_(dijkstra_vertex_limit),
-                         min_identity_(min_identity) {
-        DEBUG("Created alternatives analyzer max_length=" << max_length
-        << " max_coverage=" << max_coverage
-        << " max_relative_coverage=" << max_relative_coverage
-        << " max_delta=" << max_delta
-        << " max_relative_delta=" << max_relative_delta);
-    }
-
-    std::vector<EdgeId> operator()(EdgeId e) const {
+    std::vector<EdgeId> Analyze(EdgeId e, std::vector<VertexId> *neighbourhood) const {
         if (g_.length(e) > max_length_ || math::gr(g_.coverage(e), max_coverage_)) {
             return EmptyPath();
         }
@@ -277,6 +255,8 @@ public:
         PathProcessor<Graph> processor(g_, start, max_path_len, dijkstra_vertex_limit_);
         processor.Process(end, (g_.length(e) > delta) ? g_.length(e) - delta : 0,
                           max_path_len, path_chooser, max_edge_cnt_);
+        if (neighbourhood)
+            utils::push_back_all(*neighbourhood, processor.ReachedVertices());
 
         const std::vector<EdgeId> &path = path_chooser.most_covered_path();
         if (!path.empty()) {
@@ -301,6 +281,39 @@ public:
         }
     }
 
+public:
+    AlternativesAnalyzer(const Graph& g, double max_coverage, size_t max_length,
+                         double max_relative_coverage, size_t max_delta,
+                         double max_relative_delta, size_t max_edge_cnt,
+                         size_t dijkstra_vertex_limit, double min_identity) :
+                         g_(g),
+                         max_coverage_(max_coverage),
+                         max_length_(max_length),
+                         max_relative_coverage_(max_relative_coverage),
+                         max_delta_(max_delta),
+                         max_relative_delta_(max_relative_delta),
+                         max_edge_cnt_(max_edge_cnt),
+                         dijkstra_vertex_limit_(dijkstra_vertex_limit),
+                         min_identity_(min_identity) {
+        DEBUG("Created alternatives analyzer max_length=" << max_length
+        << " max_coverage=" << max_coverage
+        << " max_relative_coverage=" << max_relative_coverage
+        << " max_delta=" << max_delta
+        << " max_relative_delta=" << max_relative_delta);
+    }
+
+    std::vector<EdgeId> operator()(EdgeId e) const {
+        return Analyze(e, nullptr);
+    }
+
+    /**
+     * @param neighbourhood vertices, changes around which might affect the result
+     */
+    std::vector<EdgeId> operator()(EdgeId e, std::vector<VertexId> &neighbourhood) const {
+        neighbourhood = {g_.EdgeStart(e), g_.EdgeEnd(e)};
+        return Analyze(e, &neighbourhood);
+    }
+
     double max_coverage() const {
         return max_coverage_;
     }
@@ -370,6 +383,23 @@ protected:
         return false;
     }
 
+    void PrepareBatch(size_t size) override {
+        alternatives_.assign(size, {});
+    }
+
+    void Check(EdgeId e, size_t idx, std::vector<VertexId> &neighbourhood) override {
+        neighbourhood = {this->g().EdgeStart(e), this->g().EdgeEnd(e)};
+        if (HasAlternatives(this->g(), e))
+            alternatives_[idx] = alternatives_analyzer_(e, neighbourhood);
+    }
+
+    bool Commit(EdgeId e, size_t idx) override {
+        if (alternatives_[idx].empty())
+            return false;
+        gluer_(e, alternatives_[idx]);
+        return true;
+    }
+
 public:
 
     typedef std::function<bool(EdgeId edge, const std::vector<EdgeId> &path)> BulgeCallbackF;
@@ -383,7 +413,8 @@ public:
                  BulgeCandidateFinder(g, alternatives_analyzer, chunk_cnt),
                  /*canonical_only*/true,
                  CoverageComparator<Graph>(g),
-                 track_changes),
+                 track_changes,
+                 DEFAULT_PROCESSING_BATCH_SIZE),
             alternatives_analyzer_(alternatives_analyzer),
             gluer_(g, opt_callback, removal_handler) {
     }
@@ -391,6 +422,7 @@ public:
 private:
     AlternativesAnalyzer<Graph> alternatives_analyzer_;
     BulgeGluer<Graph> gluer_;
+    std::vector<std::vector<EdgeId>> alternatives_;
 private:
     DECL_LOGGER("BulgeRemover")
 };
@@ -609,37 +609,7 @@ class RelativeCovComponentFinder {
         }
     }
 
-public:
-    RelativeCovComponentFinder(Graph& g,
-            const FlankingCoverage<Graph>& flanking_cov,
-            double min_coverage_gap,
-            size_t length_bound,
-            size_t tip_allowing_length_bound,
-            size_t longest_connecting_path_bound,
-            double max_coverage,
-            size_t vertex_count_limit,
-            const std::string& vis_dir)
-            : g_(g),
-              rel_helper_(g, flanking_cov, min_coverage_gap),
-              length_bound_(length_bound),
-              tip_allowing_length_bound_(tip_allowing_length_bound),
-              longest_connecting_path_bound_(longest_connecting_path_bound),
-              max_coverage_(max_coverage),
-              vertex_count_limit_(vertex_count_limit),
-              vis_dir_(vis_dir),
-              fail_cnt_(0),
-              succ_cnt_(0) {
-        VERIFY(math::gr(min_coverage_gap, 1.));
-        VERIFY(tip_allowing_length_bound >= length_bound);
-        TRACE("Coverage gap " << min_coverage_gap);
-        if (!vis_dir_.empty()) {
-            fs::make_dirs(vis_dir_);
-            fs::make_dirs(vis_dir_ + "/success/");
-            fs::make_dirs(vis_dir_ + "/fail/");
-        }
-    }
-
-    boost::optional<Component<Graph>> operator()(EdgeId e) const {
+    boost::optional<Component<Graph>> Find(EdgeId e, std::vector<VertexId> *neighbourhood) const {
         TRACE("Processing edge " << g_.str(e));
 
         //here we use that the graph is conjugate!
@@ -664,7 +634,15 @@ public:
             InnerComponentSearcher<Graph> component_searcher(
                     g_, rel_helper_, checker, e);
 
-            if (component_searcher.FindComponent()) {
+            bool found = component_searcher.FindComponent();
+            if (neighbourhood) {
+                for (EdgeId component_e : component_searcher.component().edges()) {
+                    neighbourhood->push_back(g_.EdgeStart(component_e));
+                    neighbourhood->push_back(g_.EdgeEnd(component_e));
+                }
+            }
+
+            if (found) {
                 TRACE("Deleting component");
                 return boost::optional<Component<Graph>>(component_searcher.component());
             } else {
@@ -680,6 +658,48 @@ public:
         return boost::none;
     }
 
+public:
+    RelativeCovComponentFinder(Graph& g,
+            const FlankingCoverage<Graph>& flanking_cov,
+            double min_coverage_gap,
+            size_t length_bound,
+            size_t tip_allowing_length_bound,
+            size_t longest_connecting_path_bound,
+            double max_coverage,
+            size_t vertex_count_limit,
+            const std::string& vis_dir)
+            : g_(g),
+              rel_helper_(g, flanking_cov, min_coverage_gap),
+              length_bound_(length_bound),
+              tip_allowing_length_bound_(tip_allowing_length_bound),
+              longest_connecting_path_bound_(longest_connecting_path_bound),
+              max_coverage_(max_coverage),
+              vertex_count_limit_(vertex_count_limit),
+              vis_dir_(vis_dir),
+              fail_cnt_(0),
+              succ_cnt_(0) {
+        VERIFY(math::gr(min_coverage_gap, 1.));
+        VERIFY(tip_allowing_length_bound >= length_bound);
+        TRACE("Coverage gap " << min_coverage_gap);
+        if (!vis_dir_.empty()) {
+            fs::make_dirs(vis_dir_);
+            fs::make_dirs(vis_dir_ + "/success/");
+            fs::make_dirs(vis_dir_ + "/fail/");
+        }
+    }
+
+    boost::optional<Component<Graph>> operator()(EdgeId e) const {
+        return Find(e, nullptr);
+    }
+
+    /**
+     * @param neighbourhood vertices, changes around which might affect the result
+     */
+    boost::optional<Component<Graph>> operator()(EdgeId e, std::vector<VertexId> &neighbourhood) const {
+        neighbourhood = {g_.EdgeStart(e), g_.EdgeEnd(e)};
+        return Find(e, &neighbourhood);
+    }
+
 private:
     DECL_LOGGER("RelativeCovComponentFinder")
 };
@@ -696,6 +716,7 @@ class RelativeCoverageComponentRemover : public PersistentProcessingAlgorithm<Gr
 
     component_remover::RelativeCovComponentFinder<Graph> finder_;
     ComponentRemover<Graph> component_remover_;
+    std::vector<std::set<EdgeId>> components_;
 
 public:
     RelativeCoverageComponentRemover(
@@ -710,7 +731,8 @@ public:
             HandlerF handler_function = nullptr, size_t vertex_count_limit = 10,
             std::string vis_dir = "")
             : base(g, nullptr, /*canonical only*/ false,
-                    CoverageComparator<Graph>(g), /*track changes*/ false),
+                    CoverageComparator<Graph>(g), /*track changes*/ false,
+                    DEFAULT_PROCESSING_BATCH_SIZE),
               finder_(g, flanking_cov,
                       min_coverage_gap, length_bound,
                       tip_allowing_length_bound, longest_connecting_path_bound,
@@ -736,6 +758,27 @@ protected:
         return true;
     }
 
+    void PrepareBatch(size_t size) override {
+        components_.assign(size, {});
+    }
+
+    void Check(EdgeId e, size_t idx, std::vector<VertexId> &neighbourhood) override {
+        auto opt_component = finder_(e, neighbourhood);
+        if (opt_component)
+            components_[idx] = opt_component->edges();
+    }
+
+    bool Commit(EdgeId e, size_t idx) override {
+        if (components_[idx].empty()) {
+            DEBUG("Failed to detect component starting with edge " << this->g().str(e));
+            return false;
+        }
+        DEBUG("Detected component edge cnt: " << components_[idx].size());
+        component_remover_.DeleteComponent(components_[idx]);
+        DEBUG("Relatively low coverage component removed");
+        return true;
+    }
+
 private:
     DECL_LOGGER("RelativeCoverageComponentRemover");
 };
@@ -586,6 +586,10 @@ public:
 
     PairedIndexHandler(PairedIndex<G, Traits, Container>& p): GraphActionHandler<G>(p.graph(), "PairedIndexHandler"), paired_index_(p) {}
 
+    bool IsDeferrable() const override {
+        return true;
+    }
+
     virtual void HandleDelete(EdgeId e) override {
         if (e == paired_index_.graph().conjugate(e)) {
             DEBUG("removing self-conj");
@@ -221,6 +221,7 @@ void load(debruijn_config::construction& con,
     load(con.read_cov_threshold, pt, "read_cov_threshold", complete);
 
     con.read_buffer_size *= 1024 * 1024;
+    load(con.kmer_runs_format, pt, "kmer_runs_format", false);
     load(con.early_tc, pt, "early_tip_clipper", complete);
 }
 
@@ -827,6 +828,7 @@ void load_cfg(debruijn_config &cfg, boost::property_tree::ptree const &pt,
 
     load(cfg.ss, pt, "strand_specificity", complete);
     load(cfg.calculate_coverage_for_each_lib, pt, "calculate_coverage_for_each_lib", complete);
+    load(cfg.cache_read_mappings, pt, "cache_read_mappings", false);
 
 
     if (pt.count("plasmid")) {
@@ -305,10 +305,12 @@ struct debruijn_config {
         bool keep_perfect_loops;
         unsigned read_cov_threshold;
         size_t read_buffer_size;
+        std::string kmer_runs_format;
         construction() :
                 keep_perfect_loops(true),
                 read_cov_threshold(0),
-                read_buffer_size(0) {}
+                read_buffer_size(0),
+                kmer_runs_format("delta") {}
     };
 
     simplification simp;
@@ -543,13 +545,15 @@ struct debruijn_config {
     size_t flanking_range;
 
     bool calculate_coverage_for_each_lib;
+    bool cache_read_mappings;
     strand_specificity ss;
     time_tracing tt;
 
     bool need_mapping;
 
     debruijn_config() :
-            use_single_reads(false) {
+            use_single_reads(false),
+            cache_read_mappings(true) {
 
     }
 };
@@ -0,0 +1,299 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+// Packing of nucleotide strings into 2-bit codes (A = 0, C = 1, G = 2, T = 3)
+// laid out the way Sequence and RtSeq keep them: nucleotide i goes to bits
+// 2 * (i % 32) of word i / 32. The kernels are vectorized with SSE4.2 or AVX2
+// whichever the CPU supports, the choice is made at runtime, so the binaries
+// stay portable.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define NUCL_PACK_X86 1
+#endif
+
+namespace nucl_pack {
+
+struct Kernels {
+    const char *name;
+    // Packs n ACGTacgt symbols (their reverse complement if rc) into
+    // (n + 31) / 32 words, the unused bits of the last word are zeroed.
+    // Returns false if there are other symbols, out is garbage then.
+    bool (*pack)(const char *s, size_t n, uint64_t *out, bool rc);
+    // True if all n symbols are ACGTacgt0123 (see is_nucl)
+    bool (*valid)(const char *s, size_t n);
+};
+
+namespace impl {
+
+// ACGTacgt -> 0123, garbage for the other symbols
+inline uint64_t Code(char c) {
+    return ((uint8_t(c) >> 1) ^ (uint8_t(c) >> 2)) & 3;
+}
+
+inline bool IsLetter(char c) {
+    char up = char(c & 0xDF);
+    return up == 'A' || up == 'C' || up == 'G' || up == 'T';
+}
+
+inline bool IsNucl(char c) {
+    return uint8_t(c) < 4 || IsLetter(c);
+}
+
+// Copies the symbols of the incomplete last word (the first ones if rc) to
+// buf padded so that the padding is packed into zeros
+inline const char *TailBlock(const char *s, size_t n, bool rc, char *buf) {
+    size_t rest = n & 31;
+    if (rc) {
+        memset(buf, 'T', 32 - rest);
+        memcpy(buf + 32 - rest, s, rest);
+    } else {
+        memcpy(buf, s + n - rest, rest);
+        memset(buf + rest, 'A', 32 - rest);
+    }
+    return buf;
+}
+
+inline const char *Block(const char *s, size_t n, size_t w, bool rc) {
+    return rc ? s + n - 32 * (w + 1) : s + 32 * w;
+}
+
+inline uint64_t PackBlockScalar(const char *p, bool rc, bool &ok) {
+    uint64_t data = 0;
+    for (size_t i = 0; i < 32; ++i) {
+        char c = rc ? p[31 - i] : p[i];
+        ok &= IsLetter(c);
+        data |= (rc ? 3 ^ Code(c) : Code(c)) << (2 * i);
+    }
+    return data;
+}
+
+inline bool PackScalar(const char *s, size_t n, uint64_t *out, bool rc) {
+    bool ok = true;
+    for (size_t w = 0; w < (n >> 5); ++w)
+        out[w] = PackBlockScalar(Block(s, n, w, rc), rc, ok);
+
+    if (n & 31) {
+        char buf[32];
+        out[n >> 5] = PackBlockScalar(TailBlock(s, n, rc, buf), rc, ok);
+    }
+
+    return ok;
+}
+
+inline bool ValidScalar(const char *s, size_t n) {
+    bool ok = true;
+    for (size_t i = 0; i < n; ++i)
+        ok &= IsNucl(s[i]);
+    return ok;
+}
+
+#ifdef NUCL_PACK_X86
+
+// 16 codes -> 32 bits
+__attribute__((target("sse4.2")))
+inline uint32_t Pack16(__m128i codes) {
+    // c0 + 4 * c1 in each 16-bit word, then c01 + 16 * c23 in each 32-bit one
+    __m128i pairs = _mm_maddubs_epi16(codes, _mm_set1_epi16(0x0401));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00100001));
+    __m128i bytes = _mm_shuffle_epi8(quads, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+                                                          -1, -1, -1, -1, -1, -1, -1, -1));
+    return uint32_t(_mm_cvtsi128_si32(bytes));
+}
+
+__attribute__((target("sse4.2")))
+inline __m128i Letters16(__m128i v) {
+    __m128i up = _mm_and_si128(v, _mm_set1_epi8(char(0xDF)));
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(up, _mm_set1_epi8('A')),
+                                     _mm_cmpeq_epi8(up, _mm_set1_epi8('C'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(up, _mm_set1_epi8('G')),
+                                     _mm_cmpeq_epi8(up, _mm_set1_epi8('T'))));
+}
+
+__attribute__((target("sse4.2")))
+inline __m128i Nucls16(__m128i v) {
+    __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(3)), v);
+    return _mm_or_si128(digits, Letters16(v));
+}
+
+__attribute__((target("sse4.2")))
+inline __m128i Codes16(__m128i v, bool rc) {
+    __m128i codes = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(v, 1), _mm_srli_epi16(v, 2)),
+                                  _mm_set1_epi8(3));
+    if (!rc)
+        return codes;
+
+    codes = _mm_xor_si128(codes, _mm_set1_epi8(3));
+    return _mm_shuffle_epi8(codes, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                                 7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+__attribute__((target("sse4.2")))
+inline uint64_t PackBlockSSE42(const char *p, bool rc, __m128i &ok) {
+    __m128i lo = _mm_loadu_si128((const __m128i*) p);
+    __m128i hi = _mm_loadu_si128((const __m128i*) (p + 16));
+    ok = _mm_and_si128(ok, _mm_and_si128(Letters16(lo), Letters16(hi)));
+    if (rc)
+        std::swap(lo, hi);
+    return Pack16(Codes16(lo, rc)) | uint64_t(Pack16(Codes16(hi, rc))) << 32;
+}
+
+__attribute__((target("sse4.2")))
+inline bool PackSSE42(const char *s, size_t n, uint64_t *out, bool rc) {
+    __m128i ok = _mm_set1_epi8(-1);
+    for (size_t w = 0; w < (n >> 5); ++w)
+        out[w] = PackBlockSSE42(Block(s, n, w, rc), rc, ok);
+
+    if (n & 31) {
+        char buf[32];
+        out[n >> 5] = PackBlockSSE42(TailBlock(s, n, rc, buf), rc, ok);
+    }
+
+    return _mm_movemask_epi8(ok) == 0xFFFF;
+}
+
+__attribute__((target("sse4.2")))
+inline bool ValidSSE42(const char *s, size_t n) {
+    __m128i ok = _mm_set1_epi8(-1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        ok = _mm_and_si128(ok, Nucls16(_mm_loadu_si128((const __m128i*) (s + i))));
+
+    if (i < n) {
+        char buf[16];
+        memcpy(buf, s + i, n - i);
+        memset(buf + n - i, 'A', 16 - (n - i));
+        ok = _mm_and_si128(ok, Nucls16(_mm_loadu_si128((const __m128i*) buf)));
+    }
+
+    return _mm_movemask_epi8(ok) == 0xFFFF;
+}
+
+// 32 codes -> 64 bits
+__attribute__((target("avx2")))
+inline uint64_t Pack32(__m256i codes) {
+    __m256i pairs = _mm256_maddubs_epi16(codes, _mm256_set1_epi16(0x0401));
+    __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00100001));
+    __m256i bytes = _mm256_shuffle_epi8(quads, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+                                                                -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                0, 4, 8, 12, -1, -1, -1, -1,
+                                                                -1, -1, -1, -1, -1, -1, -1, -1));
+    return uint32_t(_mm256_extract_epi32(bytes, 0)) | uint64_t(uint32_t(_mm256_extract_epi32(bytes, 4))) << 32;
+}
+
+__attribute__((target("avx2")))
+inline __m256i Letters32(__m256i v) {
+    __m256i up = _mm256_and_si256(v, _mm256_set1_epi8(char(0xDF)));
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(up, _mm256_set1_epi8('A')),
+                                           _mm256_cmpeq_epi8(up, _mm256_set1_epi8('C'))),
+                           _mm256_or_si256(_mm256_cmpeq_epi8(up, _mm256_set1_epi8('G')),
+                                           _mm256_cmpeq_epi8(up, _mm256_set1_epi8('T'))));
+}
+
+__attribute__((target("avx2")))
+inline __m256i Nucls32(__m256i v) {
+    __m256i digits = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(3)), v);
+    return _mm256_or_si256(digits, Letters32(v));
+}
+
+__attribute__((target("avx2")))
+inline uint64_t PackBlockAVX2(const char *p, bool rc, __m256i &ok) {
+    const __m256i three = _mm256_set1_epi8(3);
+    __m256i v = _mm256_loadu_si256((const __m256i*) p);
+    ok = _mm256_and_si256(ok, Letters32(v));
+    __m256i codes = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(v, 1), _mm256_srli_epi16(v, 2)),
+                                     three);
+    if (rc) {
+        // Reverse the bytes within the lanes, then swap the lanes
+        codes = _mm256_shuffle_epi8(_mm256_xor_si256(codes, three),
+                                    _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                     15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+        codes = _mm256_permute4x64_epi64(codes, 0x4E);
+    }
+    return Pack32(codes);
+}
+
+__attribute__((target("avx2")))
+inline bool PackAVX2(const char *s, size_t n, uint64_t *out, bool rc) {
+    __m256i ok = _mm256_set1_epi8(-1);
+    for (size_t w = 0; w < (n >> 5); ++w)
+        out[w] = PackBlockAVX2(Block(s, n, w, rc), rc, ok);
+
+    if (n & 31) {
+        char buf[32];
+        out[n >> 5] = PackBlockAVX2(TailBlock(s, n, rc, buf), rc, ok);
+    }
+
+    return _mm256_movemask_epi8(ok) == -1;
+}
+
+__attribute__((target("avx2")))
+inline bool ValidAVX2(const char *s, size_t n) {
+    __m256i ok = _mm256_set1_epi8(-1);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        ok = _mm256_and_si256(ok, Nucls32(_mm256_loadu_si256((const __m256i*) (s + i))));
+
+    if (i < n) {
+        char buf[32];
+        memcpy(buf, s + i, n - i);
+        memset(buf + n - i, 'A', 32 - (n - i));
+        ok = _mm256_and_si256(ok, Nucls32(_mm256_loadu_si256((const __m256i*) buf)));
+    }
+
+    return _mm256_movemask_epi8(ok) == -1;
+}
+
+#endif
+
+}
+
+// All the kernels the CPU supports, the best one goes first
+inline std::vector<Kernels> AvailableKernels() {
+    std::vector<Kernels> res;
+#ifdef NUCL_PACK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        res.push_back({"avx2", impl::PackAVX2, impl::ValidAVX2});
+    if (__builtin_cpu_supports("sse4.2"))
+        res.push_back({"sse4.2", impl::PackSSE42, impl::ValidSSE42});
+#endif
+    res.push_back({"scalar", impl::PackScalar, impl::ValidScalar});
+    return res;
+}
+
+inline const Kernels &BestKernels() {
+    static const Kernels best = AvailableKernels().front();
+    return best;
+}
+
+inline bool Pack(const char *s, size_t n, uint64_t *out, bool rc = false) {
+    return BestKernels().pack(s, n, out, rc);
+}
+
+inline bool Valid(const char *s, size_t n) {
+    return BestKernels().valid(s, n);
+}
+
+// Symbols of string-like objects kept in contiguous memory, nullptr for the rest
+inline const char *Chars(const char *s) { return s; }
+inline const char *Chars(char *s) { return s; }
+inline const char *Chars(const std::string &s) { return s.data(); }
+template<class S>
+const char *Chars(const S &) { return nullptr; }
+
+}
+
+#undef NUCL_PACK_X86
@@ -20,12 +20,14 @@
 #include <array>
 #include <algorithm>
 #include "nucl.hpp"
+#include "nucl_pack.hpp"
 #include "math/log.hpp"
 #include "seq_common.hpp"
 #include "seq.hpp"
 #include "simple_seq.hpp"
 
 #include <cstring>
+#include <type_traits>
 #include <iostream>
 
 #define XXH_INLINE_ALL
@@ -299,6 +301,12 @@ public:
         // we fill everything with zeros (As) by default.
         std::fill(data_.begin(), data_.end(), 0);
 
+        // letter strings in contiguous memory are packed by the vectorized kernels
+        const char *chars = nucl_pack::Chars(s);
+        if (!digit_str && chars && std::is_same<T, uint64_t>::value &&
+            nucl_pack::Pack(chars + offset, size_, reinterpret_cast<uint64_t*>(data_.data())))
+            return;
+
         // data -- one temporary variable corresponding to the i-th array element
         // and some counters
         T data = 0;
@@ -14,6 +14,7 @@
 
 #include "seq.hpp"
 #include "rtseq.hpp"
+#include "nucl_pack.hpp"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/Support/TrailingObjects.h>
@@ -78,6 +79,11 @@ class Sequence {
         // Which symbols does our string contain : 0123 or ACGT?
         bool digit_str = is_dignucl(s[0]);
 
+        // Letter strings in contiguous memory are packed by the vectorized kernels
+        const char *chars = nucl_pack::Chars(s);
+        if (!digit_str && chars && nucl_pack::Pack(chars, size_, bytes, rc))
+            return;
+
         // data -- one temporary variable corresponding to the i-th array element
         // and some counters
         ST data = 0;
@@ -287,8 +293,41 @@ public:
     }
 
 public:
+    /**
+     * Packed nucleotide buffer shared by several sequences. Sequences
+     * deserialized from memory into it are views, so a batch of them
+     * costs a single allocation.
+     */
+    class SharedStorage {
+        friend class Sequence;
+
+        llvm::IntrusiveRefCntPtr<ManagedNuclBuffer> data_;
+        size_t used_, capacity_;
+
+    public:
+        explicit SharedStorage(size_t words = 0)
+                : data_(ManagedNuclBuffer::create(words * STN)), used_(0), capacity_(words) {}
+
+        // Capacity (in storage words) needed for serialized data of the given size in bytes
+        static size_t WordsFor(size_t bytes) {
+            return bytes / sizeof(ST);
+        }
+    };
+
     inline bool BinRead(std::istream &file);
     inline bool BinWrite(std::ostream &file) const;
+    /**
+     * Reads sequence serialized by BinWrite from memory into storage.
+     *
+     * @return Pointer past the serialized sequence.
+     */
+    inline const uint8_t *BinRead(const uint8_t *data, SharedStorage &storage);
+    /**
+     * Reads sequence serialized by BinWrite from memory into its own buffer.
+     *
+     * @return Pointer past the serialized sequence.
+     */
+    inline const uint8_t *BinRead(const uint8_t *data);
 };
 
 inline std::ostream &operator<<(std::ostream &os, const Sequence &s);
@@ -427,6 +466,39 @@ bool Sequence::BinRead(std::istream &file) {
     return !file.fail();
 }
 
+const uint8_t *Sequence::BinRead(const uint8_t *data, SharedStorage &storage) {
+    size_t size;
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+
+    size_t words = DataSize(size);
+    VERIFY(storage.used_ + words <= storage.capacity_);
+    VERIFY((storage.used_ + words) * STN < (size_t(1) << 31));
+    memcpy(storage.data_->data() + storage.used_, data, words * sizeof(ST));
+
+    size_ = size;
+    from_ = storage.used_ * STN;
+    rtl_ = false;
+    data_ = storage.data_;
+    storage.used_ += words;
+
+    return data + words * sizeof(ST);
+}
+
+const uint8_t *Sequence::BinRead(const uint8_t *data) {
+    size_t size;
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+
+    size_t words = DataSize(size);
+    size_ = size;
+    from_ = 0;
+    rtl_ = false;
+    data_ = llvm::IntrusiveRefCntPtr<ManagedNuclBuffer>(ManagedNuclBuffer::create(size_));
+    memcpy(data_->data(), data, words * sizeof(ST));
+
+    return data + words * sizeof(ST);
+}
 
 bool Sequence::BinWrite(std::ostream &file) const {
     if (from_ != 0 || rtl_) {
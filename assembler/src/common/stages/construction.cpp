@@ -241,7 +241,9 @@ public:
 
         kmers::KMerDiskCounter<RtSeq>
                 counter(storage().workdir,
-                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size));
+                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size,
+                                 utils::StoringTypeFilter<storing_type>(),
+                                 kmers::RawKMerFormatByName(storage().params.kmer_runs_format)));
         auto kmers = counter.Count(10 * nthreads, nthreads);
         storage().kmers.reset(new kmers::KMerDiskStorage<RtSeq>(std::move(kmers)));
     }
@@ -341,7 +341,9 @@ public:
                                 info_container_.chunk_cnt(),
                                 removal_handler_,
                                 /*canonical_only*/true,
-                                CoverageComparator<Graph>(g_));
+                                CoverageComparator<Graph>(g_),
+                                /*track_changes*/true,
+                                DEFAULT_PROCESSING_BATCH_SIZE);
             cov_cleaner.Run();
         }
 
@@ -427,6 +429,8 @@ void RawSimplification::run(GraphPack &gp, const char*) {
     visualization::graph_labeler::DefaultLabeler<Graph> labeler(gp.get<Graph>(), gp.get<EdgesPositionHandler<Graph>>());
     stats::detail_info_printer printer(gp, labeler, cfg::get().output_dir);
 
+    // Kmer mapper and edge positions are not queried until the printer flushes them
+    EventJournalScope<Graph> journal(gp.get_mutable<Graph>());
     GraphSimplifier simplifier(gp, CreateInfoContainer(gp),
                                preliminary_ ? *cfg::get().preliminary_simp : cfg::get().simp,
                                nullptr/*removal_handler_f*/,
@@ -466,6 +470,7 @@ void Simplification::run(GraphPack &gp, const char*) {
 
     SimplifInfoContainer info_container = CreateInfoContainer(gp);
 
+    EventJournalScope<Graph> journal(gp.get_mutable<Graph>());
     GraphSimplifier simplifier(gp, info_container,
                                preliminary_ ? *cfg::get().preliminary_simp : cfg::get().simp,
                                nullptr/*removal_handler_f*/,
@@ -484,7 +489,10 @@ void SimplificationCleanup::run(GraphPack &gp, const char*) {
                                nullptr/*removal_handler_f*/,
                                printer);
 
-    simplifier.PostSimplification();
+    {
+        omnigraph::EventJournalScope<Graph> journal(gp.get_mutable<Graph>());
+        simplifier.PostSimplification();
+    }
 
     DEBUG("Graph simplification finished");
 
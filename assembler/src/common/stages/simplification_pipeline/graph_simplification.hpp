@@ -53,6 +53,7 @@ private:
     size_t max_length_bound_;
     double max_coverage_bound_;
     int requested_iterations_;
+    bool local_;
 
     std::string ReadNext() {
         if (!tokenized_input_.empty()) {
@@ -172,6 +173,7 @@ private:
             RelaxMin(min_coverage_bound, cov_bound);
             return CoverageUpperBound<Graph>(g_, cov_bound);
         } else if (next_token_ == "nbr") {
+            local_ = false;
             return NotBulgeECCondition<Graph>(g_);
         } else if (next_token_ == "rcec_cb") {
             ReadNext();
@@ -220,7 +222,8 @@ public:
               //iter_run_progress_((double) (curr_iteration + 1) / (double) iteration_cnt),
               max_length_bound_(0),
               max_coverage_bound_(0.),
-              requested_iterations_(1) {
+              requested_iterations_(1),
+              local_(true) {
         DEBUG("Creating parser for string " << input);
         std::vector<std::string> tmp_tokenized_input;
         boost::split(tmp_tokenized_input, input_, boost::is_any_of(" ,;"), boost::token_compress_on);
@@ -263,6 +266,11 @@ public:
         return requested_iterations_;
     }
 
+    // true if the parsed condition depends only on the edge and the edges incident to its ends
+    bool local() const {
+        return local_;
+    }
+
 private:
     DECL_LOGGER("ConditionParser");
 };
@@ -307,6 +315,7 @@ class LowCoverageEdgeRemovingAlgorithm : public PersistentProcessingAlgorithm<Gr
                                                                               typename Graph::EdgeId,
                                                                               omnigraph::CoverageComparator<Graph>> {
     typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
     typedef PersistentProcessingAlgorithm<Graph, EdgeId, omnigraph::CoverageComparator<Graph>> base;
 
     const SimplifInfoContainer simplif_info_;
@@ -315,6 +324,7 @@ class LowCoverageEdgeRemovingAlgorithm : public PersistentProcessingAlgorithm<Gr
 
     func::TypedPredicate<EdgeId> remove_condition_;
     func::TypedPredicate<EdgeId> proceed_condition_;
+    std::vector<uint8_t> checked_;
 
 protected:
 
@@ -343,6 +353,23 @@ protected:
         return false;
     }
 
+    void PrepareBatch(size_t size) override {
+        checked_.assign(size, false);
+    }
+
+    void Check(EdgeId e, size_t idx, std::vector<VertexId> &neighbourhood) override {
+        neighbourhood = {this->g().EdgeStart(e), this->g().EdgeEnd(e)};
+        checked_[idx] = remove_condition_(e);
+    }
+
+    bool Commit(EdgeId e, size_t idx) override {
+        if (!checked_[idx])
+            return false;
+        TRACE("Check passed, removing");
+        edge_remover_.DeleteEdge(e);
+        return true;
+    }
+
 public:
     LowCoverageEdgeRemovingAlgorithm(Graph &g,
                                      const std::string &condition_str,
@@ -365,6 +392,8 @@ public:
                 std::make_shared<omnigraph::ParallelInterestingElementFinder<Graph>>(
                         AddAlternativesPresenceCondition(g, parser()),
                         simplif_info.chunk_cnt());
+        if (parser.local())
+            this->batch_size_ = omnigraph::DEFAULT_PROCESSING_BATCH_SIZE;
     }
 
 private:
@@ -402,7 +431,10 @@ AlgoPtr<Graph> SelfConjugateEdgeRemoverInstance(Graph &g, const std::string &con
                                                                   condition,
                                                                   info.chunk_cnt(),
                                                                   removal_handler,
-                                                                  /*canonical_only*/true);
+                                                                  /*canonical_only*/true,
+                                                                  adt::identity(),
+                                                                  /*track changes*/true,
+                                                                  parser.local() ? omnigraph::DEFAULT_PROCESSING_BATCH_SIZE : 0);
 }
 
 template<class Graph>
@@ -520,7 +552,10 @@ AlgoPtr<Graph> IsolatedEdgeRemoverInstance(Graph &g,
                                                                   condition,
                                                                   info.chunk_cnt(),
                                                                   removal_handler,
-                                                                  /*canonical_only*/true);
+                                                                  /*canonical_only*/true,
+                                                                  adt::identity(),
+                                                                  /*track changes*/true,
+                                                                  omnigraph::DEFAULT_PROCESSING_BATCH_SIZE);
 }
 
 template<class Graph>
@@ -535,7 +570,8 @@ AlgoPtr<Graph> RelativeECRemoverInstance(Graph &g,
             AddRelativeCoverageECCondition(g, rcec_config.rcec_ratio,
                                            AddAlternativesPresenceCondition(g, func::TypedPredicate<typename Graph::EdgeId>
                                                    (LengthUpperBound<Graph>(g, rcec_config.max_ec_length)))),
-            info.chunk_cnt(), removal_handler, /*canonical_only*/true);
+            info.chunk_cnt(), removal_handler, /*canonical_only*/true,
+            adt::identity(), /*track changes*/true, omnigraph::DEFAULT_PROCESSING_BATCH_SIZE);
 }
 
 template<class Graph>
@@ -555,14 +591,16 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
                                   const EdgeConditionT<Graph> &condition,
                                   const SimplifInfoContainer &info,
                                   EdgeRemovalHandlerF<Graph> removal_handler = nullptr,
-                                  bool track_changes = true) {
+                                  bool track_changes = true,
+                                  size_t batch_size = 0) {
     return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
                                                                         AddTipCondition(g, condition),
                                                                         info.chunk_cnt(),
                                                                         removal_handler,
                                                                         /*canonical_only*/true,
                                                                         LengthComparator<Graph>(g),
-                                                                        track_changes);
+                                                                        track_changes,
+                                                                        batch_size);
 }
 
 template<class Graph>
@@ -575,7 +613,8 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
 
     ConditionParser<Graph> parser(g, tc_config.condition, info);
     auto condition = parser();
-    auto algo = TipClipperInstance(g, condition, info, removal_handler);
+    auto algo = TipClipperInstance(g, condition, info, removal_handler, /*track changes*/true,
+                                   parser.local() ? omnigraph::DEFAULT_PROCESSING_BATCH_SIZE : 0);
     CHECK_FATAL_ERROR(parser.requested_iterations() != 0, "To disable tip clipper pass empty string");
     if (parser.requested_iterations() == 1)
         return algo;
@@ -596,7 +635,8 @@ AlgoPtr<Graph> DeadEndInstance(Graph &g,
     auto condition = parser();
     return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
             AddDeadEndCondition(g, condition), info.chunk_cnt(), removal_handler, /*canonical_only*/true,
-            LengthComparator<Graph>(g), /*track changes*/true);
+            LengthComparator<Graph>(g), /*track changes*/true,
+            parser.local() ? omnigraph::DEFAULT_PROCESSING_BATCH_SIZE : 0);
 }
 
 template<class Graph>
@@ -689,7 +729,9 @@ AlgoPtr<Graph> LowCoverageEdgeRemoverInstance(Graph &g,
                         info.chunk_cnt(),
                         (EdgeRemovalHandlerF<Graph>)nullptr,
                         /*canonical_only*/true,
-                        CoverageComparator<Graph>(g));
+                        CoverageComparator<Graph>(g),
+                        /*track changes*/true,
+                        omnigraph::DEFAULT_PROCESSING_BATCH_SIZE);
 }
 
 template<class Graph>
@@ -12,7 +12,9 @@ AlgoPtr<Graph> LowComplexityTipClipperInstance(Graph &g, EdgeRemovalHandlerF<Gra
     return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
                                                                              func::And(omnigraph::LengthUpperBound<Graph>(g, 200),
                                                                                        ATCondition<Graph>(g, 0.8, true)),
-                                                                             chunk_cnt, removal_handler, true);
+                                                                             chunk_cnt, removal_handler, true,
+                                                                             adt::identity(), true,
+                                                                             omnigraph::DEFAULT_PROCESSING_BATCH_SIZE);
 }
 
 template<class Graph>
@@ -20,7 +22,9 @@ AlgoPtr<Graph> LowComplexityShortEdgeRemoverInstance(Graph &g, EdgeRemovalHandle
     return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
                                                                              func::And(omnigraph::LengthUpperBound<Graph>(g, 1),
                                                                                        ATCondition<Graph>(g, 0.8, false)),
-                                                                             chunk_cnt, removal_handler, true);
+                                                                             chunk_cnt, removal_handler, true,
+                                                                             adt::identity(), true,
+                                                                             omnigraph::DEFAULT_PROCESSING_BATCH_SIZE);
 }
 
 
@@ -22,6 +22,7 @@ public:
     void FillExtensionsFromStream(ReadStream &stream, Index &index) const {
         unsigned k = index.k();
 
+        std::vector<typename Index::KeyWithHash> kwhs;
         while (!stream.eof()) {
             typename ReadStream::read_type r;
             stream >> r;
@@ -30,12 +31,19 @@ public:
             if (seq.size() < k + 1)
                 continue;
 
+            // Look all the k-mers of the read up at once, kwhs[i] starts at position i
+            kwhs.clear();
             typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<RtSeq>(k));
+            kwhs.push_back(kwh);
             for (size_t j = k; j < seq.size(); ++j) {
-                char nnucl = seq[j], pnucl = kwh[0];
-                index.AddOutgoing(kwh, nnucl);
-                kwh <<= nnucl;
-                index.AddIncoming(kwh, pnucl);
+                kwh <<= seq[j];
+                kwhs.push_back(kwh);
+            }
+            index.ResolveBatch(kwhs.data(), kwhs.size());
+
+            for (size_t i = 0; i + 1 < kwhs.size(); ++i) {
+                index.AddOutgoing(kwhs[i], seq[i + k]);
+                index.AddIncoming(kwhs[i + 1], seq[i]);
             }
         }
     }
@@ -45,16 +53,30 @@ public:
     void FillExtensionsFromIndex(It begin, It end,
                                  Index &index) const {
         unsigned KPlusOne = index.k() + 1;
-        for (; begin != end; ++begin) {
-            RtSeq kpomer(KPlusOne, begin->first); // FIXME: temporary until boophm refactoring
-
-            char pnucl = kpomer[0], nnucl = kpomer[KPlusOne - 1];
-            TRACE("processing k+1-mer " << kpomer);
-            index.AddOutgoing(index.ConstructKWH(RtSeq(KPlusOne - 1, kpomer)),
-                              nnucl);
-            // FIXME: This is extremely ugly. Needs to add start / end methods to extract first / last N symbols...
-            index.AddIncoming(index.ConstructKWH(RtSeq(KPlusOne - 1, kpomer << 0)),
-                              pnucl);
+
+        // k+1-mers are processed in batches, so the lookups of their k-mers could be batched as well
+        const size_t batch_size = 128;
+        std::vector<typename Index::KeyWithHash> kwhs;
+        std::vector<char> nucls;
+        while (begin != end) {
+            kwhs.clear();
+            nucls.clear();
+            for (; begin != end && nucls.size() < 2 * batch_size; ++begin) {
+                RtSeq kpomer(KPlusOne, begin->first); // FIXME: temporary until boophm refactoring
+                TRACE("processing k+1-mer " << kpomer);
+
+                kwhs.push_back(index.ConstructKWH(RtSeq(KPlusOne - 1, kpomer)));
+                nucls.push_back(kpomer[KPlusOne - 1]);
+                // FIXME: This is extremely ugly. Needs to add start / end methods to extract first / last N symbols...
+                kwhs.push_back(index.ConstructKWH(RtSeq(KPlusOne - 1, kpomer << 0)));
+                nucls.push_back(kpomer[0]);
+            }
+            index.ResolveBatch(kwhs.data(), kwhs.size());
+
+            for (size_t i = 0; i < kwhs.size(); i += 2) {
+                index.AddOutgoing(kwhs[i], nucls[i]);
+                index.AddIncoming(kwhs[i + 1], nucls[i + 1]);
+            }
         }
     }
 
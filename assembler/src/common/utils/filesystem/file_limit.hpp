@@ -11,6 +11,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#include "utils/logger/logger.hpp"
 #include "utils/verify.hpp"
 
 namespace utils {
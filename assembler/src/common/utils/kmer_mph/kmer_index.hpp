@@ -11,6 +11,7 @@
 
 #include <boomphf/BooPHF.h>
 
+#include <algorithm>
 #include <vector>
 #include <cmath>
 
@@ -51,6 +52,9 @@ private:
   typedef boomphf::mphf<hash_function128> KMerDataIndex;
 
 public:
+  // Number of k-mers hashed and prefetched together by batch_seq_idx()
+  static constexpr size_t LOOKUP_BATCH = 16;
+
   KMerIndex(): num_segments_(0), size_(0) {}
 
   KMerIndex(const KMerIndex&) = delete;
@@ -89,6 +93,30 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Looks up n k-mers given by key(i), passing the index of each one to res(i, idx).
+  // K-mers are hashed in small batches and the MPHF bits of the whole batch are
+  // prefetched before the first lookup, so the cache misses of different k-mers overlap.
+  template<class KeyF, class ResF>
+  void batch_seq_idx(size_t n, KeyF key, ResF res) const {
+    size_t buckets[LOOKUP_BATCH];
+    boomphf::hash_pair_t hashes[LOOKUP_BATCH];
+
+    for (size_t start = 0; start < n; start += LOOKUP_BATCH) {
+      size_t cnt = std::min(LOOKUP_BATCH, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        const KMerSeq &s = key(start + i);
+        buckets[i] = seq_bucket(s);
+        hashes[i] = index_[buckets[i]].hash(s);
+        index_[buckets[i]].prefetch(hashes[i]);
+      }
+
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t idx = index_[buckets[i]].lookup_hash(hashes[i]);
+        res(start + i, idx == -1ULL ? idx : segment_starts_[buckets[i]] + idx);
+      }
+    }
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
@@ -245,6 +245,11 @@ public:
     auto raw_kmers = splitter_->Split(num_buckets, num_threads);
     VERIFY(raw_kmers.size() == num_buckets);
     TIME_TRACE_END;
+    if (size_t raw_kmers_written = splitter_->raw_kmers()) {
+      INFO("Splitting wrote " << raw_kmers_written << " k-mers in sorted runs, " << splitter_->raw_bytes() << " bytes ("
+           << RawKMerFormatName(splitter_->raw_format()) << " format, "
+           << (double) splitter_->raw_bytes() / (double) raw_kmers_written << " bytes per k-mer)");
+    }
 
     INFO("Starting k-mer counting.");
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
@@ -257,7 +262,7 @@ public:
           raw_kmers[i].reset();
         }
     }
-    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
+    INFO("K-mer counting done. There are " << kmers << " kmers in total, " << kmers * kmer_size() << " bytes written.");
     if (!kmers) {
       FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
       exit(-1);
@@ -279,11 +284,14 @@ private:
   fs::TmpDir work_dir_;
 
   size_t MergeKMers(const std::string &ifname, const std::string &ofname) {
-    MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
-
     std::string IdxFileName = ifname + ".idx";
     if (FILE *f = fopen(IdxFileName.c_str(), "rb")) {
       fclose(f);
+      if (splitter_->raw_format() != RawKMerFormat::Plain)
+        return MergeEncodedKMers(ifname, ofname,
+                                 std::integral_constant<bool, std::is_unsigned<typename Seq::DataType>::value>());
+
+      MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
       MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
 
       // INFO("Total runs: " << index.size());
@@ -298,70 +306,102 @@ private:
         beg = end;
       }
 
-      // Construct tree on top entries of runs
-      adt::loser_tree<decltype(beg),
-              adt::array_less<typename Seq::DataType>> tree(ranges);
+      return MergeRuns(ranges, ofname);
+    } else {
+      MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
 
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        if (!g)
-          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-        fclose(g);
-        return 0;
-      }
+      // Sort the stuff
+      libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
+
+      // FIXME: Use something like parallel version of unique_copy but with explicit
+      // resizing.
+      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
 
-      // Write it down!
-      adt::KMerVector<Seq> buf(this->k(), 1024*1024);
-      size_t total = 0;
-      while (!tree.empty()) {
-          buf.clear();
-          buf.push_back(tree.pop());
-          size_t cnt = 1;
+      MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
+      os.resize(it - ins.begin());
+      std::copy(ins.begin(), it, os.begin());
 
-          while (cnt < buf.capacity()) {
-            while (!tree.empty() &&
-                   adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
-              tree.replay();
+      return it - ins.begin();
+    }
+  }
 
-            if (tree.empty())
-              break;
+  // Runs are streamed right from the mapped file, decoding one block of every run at a time
+  size_t MergeEncodedKMers(const std::string &ifname, const std::string &ofname, std::true_type) {
+    typedef KMerRunIterator<typename Seq::DataType> RunIterator;
+
+    MMappedRecordReader<uint8_t> ins(ifname, /* unlink */ true, -1ULL);
+    MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
+    VERIFY(index.size() % 2 == 0);
+
+    std::vector<adt::iterator_range<RunIterator>> ranges;
+    size_t offset = 0;
+    for (size_t i = 0; i < index.size(); i += 2) {
+      size_t bytes = index[i + 1];
+      ranges.push_back(adt::make_range(RunIterator(ins.data() + offset, bytes, Seq::GetDataSize(this->k())),
+                                       RunIterator()));
+      offset += bytes;
+    }
+    VERIFY(offset == ins.size());
 
-            buf.push_back(tree.top());
-            tree.replay();
-            cnt += 1;
-          }
+    return MergeRuns(ranges, ofname);
+  }
 
-          // Handle the last value
+  size_t MergeEncodedKMers(const std::string &, const std::string &, std::false_type) {
+    VERIFY_MSG(false, "k-mer runs could be encoded for unsigned words only");
+    return 0;
+  }
+
+  template<class It>
+  size_t MergeRuns(const std::vector<adt::iterator_range<It>> &ranges, const std::string &ofname) {
+    // Construct tree on top entries of runs
+    adt::loser_tree<It, adt::array_less<typename Seq::DataType>> tree(ranges);
+
+    if (tree.empty()) {
+      FILE *g = fopen(ofname.c_str(), "ab");
+      if (!g)
+        FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
+      fclose(g);
+      return 0;
+    }
+
+    // Write it down!
+    adt::KMerVector<Seq> buf(this->k(), 1024*1024);
+    size_t total = 0;
+    while (!tree.empty()) {
+        buf.clear();
+        buf.push_back(tree.pop());
+        size_t cnt = 1;
+
+        while (cnt < buf.capacity()) {
           while (!tree.empty() &&
                  adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
             tree.replay();
 
-          total += buf.size();
+          if (tree.empty())
+            break;
 
-          FILE *g = fopen(ofname.c_str(), "ab");
-          if (!g)
-            FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-          size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          if (res != buf.size())
-            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-          fclose(g);
-      }
+          buf.push_back(tree.top());
+          tree.replay();
+          cnt += 1;
+        }
 
-      return total;
-    } else {
-      // Sort the stuff
-      libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
+        // Handle the last value
+        while (!tree.empty() &&
+               adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
+          tree.replay();
 
-      // FIXME: Use something like parallel version of unique_copy but with explicit
-      // resizing.
-      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
-
-      MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
-      os.resize(it - ins.begin());
-      std::copy(ins.begin(), it, os.begin());
+        total += buf.size();
 
-      return it - ins.begin();
+        FILE *g = fopen(ofname.c_str(), "ab");
+        if (!g)
+          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
+        size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
+        if (res != buf.size())
+          FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        fclose(g);
     }
+
+    return total;
   }
 };
 
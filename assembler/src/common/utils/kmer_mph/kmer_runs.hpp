@@ -0,0 +1,290 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "adt/array_vector.hpp"
+#include "utils/verify.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+#include <zlib.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace kmers {
+
+// On-disk format of sorted k-mer runs produced by splitters
+enum class RawKMerFormat {
+    Plain,      // fixed-width records
+    Delta,      // prefix / delta encoded records
+    Compressed  // delta encoded records, blocks compressed with zlib
+};
+
+inline RawKMerFormat RawKMerFormatByName(const std::string &name) {
+    if (name == "plain")
+        return RawKMerFormat::Plain;
+    if (name == "delta")
+        return RawKMerFormat::Delta;
+    if (name == "compressed")
+        return RawKMerFormat::Compressed;
+    VERIFY_MSG(false, "Unknown k-mer runs format: " << name);
+    return RawKMerFormat::Plain;
+}
+
+inline const char *RawKMerFormatName(RawKMerFormat format) {
+    switch (format) {
+        case RawKMerFormat::Plain:
+            return "plain";
+        case RawKMerFormat::Delta:
+            return "delta";
+        case RawKMerFormat::Compressed:
+            return "compressed";
+    }
+    return "unknown";
+}
+
+// Encoded runs are split into blocks of at most BLOCK_RECORDS k-mers, each of them
+// decodable on its own:
+//   uint32 count, uint32 encoded size, uint32 stored size (less than encoded if compressed)
+//   payload: significant bytes of each k-mer word, first k-mer with all its words,
+//   then for every next k-mer: index of the first word differing from the previous
+//   k-mer (only if there are several words), varint delta of this word and the
+//   significant bytes of all words after it.
+// Runs are sorted and deduplicated, so the first differing word always grows.
+template<class T>
+class KMerRunCodec {
+    static_assert(std::is_unsigned<T>::value, "k-mer runs could be encoded for unsigned words only");
+
+    struct BlockHeader {
+        uint32_t count;
+        uint32_t encoded_size;
+        uint32_t stored_size;
+    };
+
+public:
+    static constexpr size_t BLOCK_RECORDS = 4096;
+
+    explicit KMerRunCodec(size_t elcnt)
+            : elcnt_(elcnt) {
+        VERIFY(elcnt_ > 0 && elcnt_ < 256);
+    }
+
+    // Appends encoded run of cnt k-mers to out
+    void Encode(const T *data, size_t cnt, bool compress, std::vector<uint8_t> &out) const {
+        std::vector<uint8_t> block, zblock;
+        for (size_t start = 0; start < cnt; start += BLOCK_RECORDS) {
+            size_t n = std::min(BLOCK_RECORDS, cnt - start);
+            EncodeBlock(data + start * elcnt_, n, block);
+
+            const std::vector<uint8_t> *stored = &block;
+            if (compress) {
+                uLongf zsize = compressBound(block.size());
+                zblock.resize(zsize);
+                if (compress2(zblock.data(), &zsize, block.data(), block.size(), 1) == Z_OK && zsize < block.size()) {
+                    zblock.resize(zsize);
+                    stored = &zblock;
+                }
+            }
+
+            BlockHeader header = { uint32_t(n), uint32_t(block.size()), uint32_t(stored->size()) };
+            const uint8_t *h = reinterpret_cast<const uint8_t*>(&header);
+            out.insert(out.end(), h, h + sizeof(header));
+            out.insert(out.end(), stored->begin(), stored->end());
+        }
+    }
+
+    // Decodes the block starting at data into out, returns the pointer past the block
+    const uint8_t *DecodeBlock(const uint8_t *data, std::vector<T> &out, std::vector<uint8_t> &tmp) const {
+        BlockHeader header;
+        memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        const uint8_t *block = data;
+        if (header.stored_size < header.encoded_size) {
+            tmp.resize(header.encoded_size);
+            uLongf size = header.encoded_size;
+            int res = uncompress(tmp.data(), &size, data, header.stored_size);
+            VERIFY_MSG(res == Z_OK && size == header.encoded_size, "Corrupted k-mer run block");
+            block = tmp.data();
+        }
+
+        out.resize(header.count * elcnt_);
+        const uint8_t *widths = block;
+        const uint8_t *p = block + elcnt_;
+        T *rec = out.data();
+        for (size_t w = 0; w < elcnt_; ++w)
+            rec[w] = GetFixed(p, widths[w]);
+        for (size_t i = 1; i < header.count; ++i) {
+            const T *prev = rec;
+            rec += elcnt_;
+            size_t d = (elcnt_ > 1 ? *p++ : 0);
+            std::copy(prev, prev + d, rec);
+            rec[d] = T(prev[d] + GetVarint(p));
+            for (size_t w = d + 1; w < elcnt_; ++w)
+                rec[w] = GetFixed(p, widths[w]);
+        }
+        VERIFY(p == block + header.encoded_size);
+
+        return data + header.stored_size;
+    }
+
+private:
+    size_t elcnt_;
+
+    void EncodeBlock(const T *data, size_t cnt, std::vector<uint8_t> &out) const {
+        out.clear();
+        // Only the significant bytes of each word are stored, e.g. the last word
+        // of a k-mer is usually filled partially
+        std::vector<uint8_t> widths(elcnt_, 0);
+        for (size_t w = 0; w < elcnt_; ++w) {
+            T mask = 0;
+            for (size_t i = 0; i < cnt; ++i)
+                mask |= data[i * elcnt_ + w];
+            while (mask) {
+                widths[w] += 1;
+                mask = T(mask >> 8);
+            }
+        }
+        out.insert(out.end(), widths.begin(), widths.end());
+
+        for (size_t w = 0; w < elcnt_; ++w)
+            PutFixed(out, data[w], widths[w]);
+        for (size_t i = 1; i < cnt; ++i) {
+            const T *prev = data + (i - 1) * elcnt_, *rec = prev + elcnt_;
+            size_t d = 0;
+            while (d < elcnt_ && rec[d] == prev[d])
+                ++d;
+            VERIFY_MSG(d < elcnt_ && rec[d] > prev[d], "k-mer run is not sorted or contains duplicates");
+
+            if (elcnt_ > 1)
+                out.push_back(uint8_t(d));
+            PutVarint(out, T(rec[d] - prev[d]));
+            for (size_t w = d + 1; w < elcnt_; ++w)
+                PutFixed(out, rec[w], widths[w]);
+        }
+    }
+
+    static void PutFixed(std::vector<uint8_t> &out, T val, uint8_t width) {
+        for (uint8_t b = 0; b < width; ++b) {
+            out.push_back(uint8_t(val & 0xFF));
+            val = T(val >> 8);
+        }
+    }
+
+    static T GetFixed(const uint8_t *&p, uint8_t width) {
+        T val = 0;
+        for (uint8_t b = 0; b < width; ++b)
+            val |= T(T(*p++) << (8 * b));
+        return val;
+    }
+
+    static void PutVarint(std::vector<uint8_t> &out, T val) {
+        while (val >= 0x80) {
+            out.push_back(uint8_t(val | 0x80));
+            val = T(val >> 7);
+        }
+        out.push_back(uint8_t(val));
+    }
+
+    static T GetVarint(const uint8_t *&p) {
+        T val = 0;
+        for (unsigned shift = 0; ; shift += 7) {
+            uint8_t b = *p++;
+            val |= T(T(b & 0x7F) << shift);
+            if (!(b & 0x80))
+                break;
+        }
+        return val;
+    }
+};
+
+// Input iterator over the k-mers of a single encoded run, decoding it block by block.
+// Dereferencing gives the same references as iterators over plain runs do, so both
+// could be merged by adt::loser_tree. Default-constructed iterator is the end one.
+template<class T>
+class KMerRunIterator :
+        public boost::iterator_facade<KMerRunIterator<T>,
+                                      typename adt::array_vector<T>::value_type,
+                                      std::input_iterator_tag,
+                                      typename adt::array_vector<T>::reference> {
+    typedef typename adt::array_vector<T>::iterator block_iterator;
+
+    struct State {
+        State(const uint8_t *data, const uint8_t *end, size_t elcnt)
+                : codec(elcnt), data(data), end(end), elcnt(elcnt), pos(0) {
+            NextBlock();
+        }
+
+        void NextBlock() {
+            block.clear();
+            pos = 0;
+            if (data != end)
+                data = codec.DecodeBlock(data, block, tmp);
+        }
+
+        KMerRunCodec<T> codec;
+        const uint8_t *data;
+        const uint8_t *end;
+        size_t elcnt;
+        std::vector<T> block;
+        std::vector<uint8_t> tmp;
+        size_t pos;
+    };
+
+public:
+    KMerRunIterator() = default;
+
+    KMerRunIterator(const uint8_t *data, size_t size, size_t elcnt)
+            : state_(std::make_shared<State>(data, data + size, elcnt)) {}
+
+private:
+    friend class boost::iterator_core_access;
+
+    bool at_end() const {
+        return !state_ || state_->pos * state_->elcnt == state_->block.size();
+    }
+
+    void increment() {
+        if (++state_->pos * state_->elcnt == state_->block.size())
+            state_->NextBlock();
+    }
+
+    bool equal(const KMerRunIterator &other) const {
+        return at_end() && other.at_end();
+    }
+
+    typename adt::array_vector<T>::reference dereference() const {
+        return *block_iterator(state_->block.data() + state_->pos * state_->elcnt, state_->elcnt);
+    }
+
+    // Shared, as loser_tree advances copies of the iterator
+    std::shared_ptr<State> state_;
+};
+
+// Only runs of unsigned words could be encoded, other ones are always kept plain
+template<class T>
+bool KMerRunsEncodable() {
+    return std::is_unsigned<T>::value;
+}
+
+template<class T>
+std::enable_if_t<std::is_unsigned<T>::value>
+EncodeKMerRun(const T *data, size_t cnt, size_t elcnt, bool compress, std::vector<uint8_t> &out) {
+    KMerRunCodec<T>(elcnt).Encode(data, cnt, compress, out);
+}
+
+template<class T>
+std::enable_if_t<!std::is_unsigned<T>::value>
+EncodeKMerRun(const T *, size_t, size_t, bool, std::vector<uint8_t> &) {
+    VERIFY_MSG(false, "k-mer runs could be encoded for unsigned words only");
+}
+
+}
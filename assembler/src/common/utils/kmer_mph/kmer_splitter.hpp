@@ -7,6 +7,7 @@
 #pragma once
 
 #include "kmer_buckets.hpp"
+#include "kmer_runs.hpp"
 
 #include "adt/kmer_vector.hpp"
 #include "utils/filesystem/file_limit.hpp"
@@ -17,6 +18,7 @@
 #include <libcxx/sort.hpp>
 #include <string>
 #include <cstdio>
+#include <thread>
 
 namespace kmers {
 
@@ -26,11 +28,14 @@ public:
     typedef typename kmer::KMerSegmentPolicy<Seq> KMerBuckets;
     typedef std::vector<fs::DependentTmpFile> RawKMers;
 
-    KMerSplitter(const std::string &work_dir, unsigned K)
-            : KMerSplitter(fs::tmp::make_temp_dir(work_dir, "kmer_splitter"), K) {}
+    // Runs of k-mers which words could not be encoded are always stored plain
+    KMerSplitter(const std::string &work_dir, unsigned K, RawKMerFormat raw_format = RawKMerFormat::Delta)
+            : KMerSplitter(fs::tmp::make_temp_dir(work_dir, "kmer_splitter"), K, raw_format) {}
 
-    KMerSplitter(fs::TmpDir work_dir, unsigned K)
-            : work_dir_(work_dir), K_(K) {}
+    KMerSplitter(fs::TmpDir work_dir, unsigned K, RawKMerFormat raw_format = RawKMerFormat::Delta)
+            : work_dir_(work_dir), K_(K),
+              raw_format_(KMerRunsEncodable<typename Seq::DataType>() ? raw_format : RawKMerFormat::Plain),
+              raw_kmers_(0), raw_bytes_(0) {}
 
     virtual ~KMerSplitter() {}
 
@@ -43,24 +48,47 @@ public:
     unsigned K() const { return K_; }
     KMerBuckets bucket_policy() const { return bucket_; }
 
+    // Format of the runs in files returned by Split(). Plain files might contain a
+    // single unsorted run, then there is no .idx file.
+    RawKMerFormat raw_format() const { return raw_format_; }
+
+    // Number of k-mers and bytes written to the runs
+    size_t raw_kmers() const { return raw_kmers_; }
+    size_t raw_bytes() const { return raw_bytes_; }
+
 protected:
     fs::TmpDir work_dir_;
     unsigned K_;
     KMerBuckets bucket_;
+    RawKMerFormat raw_format_;
+    size_t raw_kmers_;
+    size_t raw_bytes_;
 
     DECL_LOGGER("K-mer Splitting");
 };
 
+// K-mers are collected by producer threads into per-thread buffers. Once some
+// buffer is full, the whole generation of buffers is handed over to the
+// background flusher, which sorts it and appends the runs to the files kept open
+// during the split, while producers proceed with the fresh generation.
 template<class Seq>
 class KMerSortingSplitter : public KMerSplitter<Seq> {
 public:
     using typename KMerSplitter<Seq>::RawKMers;
 
-    KMerSortingSplitter(const std::string &work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+    KMerSortingSplitter(const std::string &work_dir, unsigned K, RawKMerFormat raw_format = RawKMerFormat::Delta)
+            : KMerSplitter<Seq>(work_dir, K, raw_format), cell_size_(0), num_files_(0), nthreads_(1) {}
+
+    KMerSortingSplitter(fs::TmpDir work_dir, unsigned K, RawKMerFormat raw_format = RawKMerFormat::Delta)
+            : KMerSplitter<Seq>(work_dir, K, raw_format), cell_size_(0), num_files_(0), nthreads_(1) {}
+
+    // Splitters are only moved before splitting, when nothing is being flushed
+    KMerSortingSplitter(KMerSortingSplitter &&) = default;
 
-    KMerSortingSplitter(fs::TmpDir work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+    ~KMerSortingSplitter() override {
+        WaitFlush();
+        CloseFiles();
+    }
 
 protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
@@ -72,6 +100,7 @@ protected:
 
     RawKMers PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
+        nthreads_ = nthreads;
         this->bucket_.reset(num_files);
 
         // Determine the set of output files
@@ -80,29 +109,38 @@ protected:
         for (unsigned i = 0; i < num_files_; ++i)
             out.emplace_back(tmp_prefix->CreateDep(std::to_string(i)));
 
-        size_t file_limit = num_files_ + 2*nthreads;
+        // Runs and their indices are kept open during the whole split
+        size_t file_limit = 2*num_files_ + 2*nthreads;
         size_t res = utils::limit_file(file_limit);
         if (res < file_limit) {
             WARN("Failed to setup necessary limit for number of open files. The process might crash later on.");
             WARN("Do 'ulimit -n " << file_limit << "' in the console to overcome the limit");
         }
 
+        CloseFiles();
+        for (const auto &file : out) {
+            run_files_.push_back(OpenFile(file->file()));
+            idx_files_.push_back(OpenFile(file->file() + ".idx"));
+        }
+
         if (reads_buffer_size == 0) {
             reads_buffer_size = 536870912ull;
             size_t mem_limit =  (size_t)((double)(utils::get_free_memory()) / (nthreads * 3));
             INFO("Memory available for splitting buffers: " << (double)mem_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
             reads_buffer_size = std::min(reads_buffer_size, mem_limit);
         }
-        cell_size_ = reads_buffer_size / (num_files_ * this->kmer_size());
+        // Two generations of buffers (filled and flushed) share the memory
+        cell_size_ = reads_buffer_size / (2 * num_files_ * this->kmer_size());
         // Set sane minimum cell size
         if (cell_size_ < 16384)
             cell_size_ = 16384;
 
         INFO("Using cell size of " << cell_size_);
         kmer_buffers_.resize(nthreads);
+        flush_buffers_.resize(nthreads);
         for (unsigned i = 0; i < nthreads; ++i) {
-            KMerBuffer &entry = kmer_buffers_[i];
-            entry.resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
+            kmer_buffers_[i].resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
+            flush_buffers_[i].resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
         }
 
         return out;
@@ -117,61 +155,105 @@ protected:
         return entry[idx].size() > cell_size_;
     }
 
+    // Hands the filled buffers over to the flusher, returns as soon as the
+    // previous generation is written
     void DumpBuffers(const RawKMers &ostreams) {
         VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
 
-#   pragma omp parallel for
-        for (size_t k = 0; k < num_files_; ++k) {
-            // Below k is thread id!
+        WaitFlush();
+        std::swap(kmer_buffers_, flush_buffers_);
+        flusher_ = std::thread([this] { FlushBuffers(); });
+    }
+
+    // Waits for all the runs to be written, the files are complete afterwards
+    void ClearBuffers() {
+        WaitFlush();
+        CloseFiles();
+
+        for (auto *buffers : { &kmer_buffers_, &flush_buffers_ })
+            for (auto & entry : *buffers)
+                for (auto & eentry : entry) {
+                    eentry.clear();
+                    eentry.shrink_to_fit();
+                }
+    }
+
+private:
+    std::vector<KMerBuffer> flush_buffers_;
+    std::thread flusher_;
+    std::vector<FILE*> run_files_, idx_files_;
+    unsigned nthreads_;
+
+    static FILE *OpenFile(const std::string &fname) {
+        FILE *f = fopen(fname.c_str(), "ab");
+        if (!f)
+            FATAL_ERROR("Cannot open temporary file " << fname << " for writing");
+        return f;
+    }
+
+    static void WriteFile(FILE *f, const void *data, size_t size, size_t cnt) {
+        size_t res = fwrite(data, size, cnt, f);
+        if (res != cnt)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+    }
+
+    void CloseFiles() {
+        for (auto *files : { &run_files_, &idx_files_ }) {
+            for (FILE *f : *files)
+                if (fclose(f))
+                    FATAL_ERROR("I/O error! Cannot close temporary file. Reason: " << strerror(errno) << ". Error code: " << errno);
+            files->clear();
+        }
+    }
 
+    void WaitFlush() {
+        if (flusher_.joinable())
+            flusher_.join();
+    }
+
+    void FlushBuffers() {
+        size_t raw_kmers = 0, raw_bytes = 0;
+
+        // Every file is written by a single iteration, so no locking is necessary
+#   pragma omp parallel for num_threads(nthreads_) schedule(dynamic) reduction(+ : raw_kmers, raw_bytes)
+        for (size_t k = 0; k < num_files_; ++k) {
             size_t sz = 0;
-            for (size_t i = 0; i < kmer_buffers_.size(); ++i)
-                sz += kmer_buffers_[i][k].size();
+            for (size_t i = 0; i < flush_buffers_.size(); ++i)
+                sz += flush_buffers_[i][k].size();
 
             adt::KMerVector<Seq> SortBuffer(this->K_, sz);
-            for (auto & entry : kmer_buffers_) {
-                const auto &buffer = entry[k];
+            for (auto & entry : flush_buffers_) {
+                auto &buffer = entry[k];
                 for (size_t j = 0; j < buffer.size(); ++j)
                     SortBuffer.push_back(buffer[j]);
+                buffer.clear();
             }
             libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
             auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
-
-#     pragma omp critical
-            {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
+            size_t cnt =  it - SortBuffer.begin();
+
+            const void *data = SortBuffer.data();
+            size_t bytes = cnt * SortBuffer.el_data_size();
+            std::vector<uint8_t> encoded;
+            if (this->raw_format_ != RawKMerFormat::Plain) {
+                EncodeKMerRun(SortBuffer.data(), cnt, SortBuffer.el_size(),
+                              this->raw_format_ == RawKMerFormat::Compressed, encoded);
+                data = encoded.data();
+                bytes = encoded.size();
             }
-        }
 
-        for (auto & entry : kmer_buffers_)
-            for (auto & eentry : entry)
-                eentry.clear();
-    }
+            // Write k-mers, then the index: the number of k-mers in the run,
+            // followed by its size for encoded runs
+            WriteFile(run_files_[k], data, 1, bytes);
+            size_t entry[2] = { cnt, bytes };
+            WriteFile(idx_files_[k], entry, sizeof(size_t), this->raw_format_ == RawKMerFormat::Plain ? 1 : 2);
 
-    void ClearBuffers() {
-        for (auto & entry : kmer_buffers_)
-            for (auto & eentry : entry) {
-                eentry.clear();
-                eentry.shrink_to_fit();
-            }
+            raw_kmers += cnt;
+            raw_bytes += bytes;
+        }
+
+        this->raw_kmers_ += raw_kmers;
+        this->raw_bytes_ += raw_bytes;
     }
 };
 
@@ -60,8 +60,9 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
 
  public:
   DeBruijnKMerSplitter(fs::TmpDir work_dir,
-                       unsigned K, KmerFilter kmer_filter, size_t read_buffer_size = 0)
-      : RtSeqKMerSplitter(work_dir, K), kmer_filter_(kmer_filter), read_buffer_size_(read_buffer_size) {
+                       unsigned K, KmerFilter kmer_filter, size_t read_buffer_size = 0,
+                       kmers::RawKMerFormat raw_format = kmers::RawKMerFormat::Delta)
+      : RtSeqKMerSplitter(work_dir, K, raw_format), kmer_filter_(kmer_filter), read_buffer_size_(read_buffer_size) {
   }
  protected:
   DECL_LOGGER("DeBruijnKMerSplitter");
@@ -81,8 +82,9 @@ class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
                            unsigned K,
                            io::ReadStreamList<Read>& streams,
                            size_t read_buffer_size = 0,
-                           KmerFilter filter = KmerFilter())
-      : DeBruijnKMerSplitter<KmerFilter>(work_dir, K, filter, read_buffer_size),
+                           KmerFilter filter = KmerFilter(),
+                           kmers::RawKMerFormat raw_format = kmers::RawKMerFormat::Delta)
+      : DeBruijnKMerSplitter<KmerFilter>(work_dir, K, filter, read_buffer_size, raw_format),
       streams_(streams) {}
 
   RawKMers Split(size_t num_files, unsigned nthreads) override;
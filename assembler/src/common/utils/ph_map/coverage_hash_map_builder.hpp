@@ -8,6 +8,7 @@
 #include "perfect_hash_map_builder.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include <cstdlib>
+#include <vector>
 
 namespace utils {
 
@@ -17,6 +18,7 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
         typedef typename Index::KeyType Kmer;
         unsigned k = index.k();
 
+        std::vector<typename Index::KeyWithHash> kwhs;
         while (!stream.eof()) {
             typename ReadStream::ReadT r;
             stream >> r;
@@ -25,10 +27,18 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
             if (seq.size() < k)
                 continue;
 
+            // Look all the k-mers of the read up at once
+            kwhs.clear();
             typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<Kmer>(k) >> 'A');
             for (size_t j = k - 1; j < seq.size(); ++j) {
                 kwh <<= seq[j];
-                if (!kwh.is_minimal() || !index.valid(kwh))
+                if (kwh.is_minimal())
+                    kwhs.push_back(kwh);
+            }
+            index.ResolveBatch(kwhs.data(), kwhs.size());
+
+            for (const auto &kwh : kwhs) {
+                if (!index.valid(kwh))
                     continue;
 
 #                   pragma omp atomic
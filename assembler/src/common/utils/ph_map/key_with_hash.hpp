@@ -47,6 +47,12 @@ public:
         return idx_;
     }
 
+    // Sets the index computed elsewhere, e.g. by a batched lookup
+    void SetIdx(IdxType idx, bool /*is_minimal*/) {
+        idx_ = idx;
+        ready_ = true;
+    }
+
     SimpleKeyWithHash(const SimpleKeyWithHash &that) noexcept = default;
     SimpleKeyWithHash &operator=(const SimpleKeyWithHash &that) noexcept {
         if (this == &that)
@@ -147,6 +153,13 @@ private:
         return idx_;
     }
 
+    // Sets the index of the minimal of the key and its complement computed elsewhere
+    void SetIdx(IdxType idx, bool is_minimal) {
+        idx_ = idx;
+        is_minimal_ = is_minimal;
+        ready_ = true;
+    }
+
     bool is_minimal() const {
         if(!ready_) {
             return key_.IsMinimal();
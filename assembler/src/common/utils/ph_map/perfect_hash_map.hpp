@@ -16,6 +16,8 @@
 #include "utils/kmer_mph/kmer_index.hpp"
 #include "utils/verify.hpp"
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cstdlib>
 #include <cstdint>
@@ -103,6 +105,27 @@ public:
         return KeyBase::valid(kwh.idx());
     }
 
+    // Computes the indices of n keys at once (see KMerIndex::batch_seq_idx) and
+    // prefetches the values of the valid ones. Use it when many keys are
+    // looked up together, e.g. all k-mers of a read
+    void ResolveBatch(KeyWithHash *kwhs, size_t n) const {
+        constexpr size_t batch = KMerIndexT::LOOKUP_BATCH;
+        std::array<bool, batch> minimal;
+        for (size_t start = 0; start < n; start += batch) {
+            KeyWithHash *chunk = kwhs + start;
+            index_ptr_->batch_seq_idx(std::min(batch, n - start),
+                                      [&](size_t i) {
+                                          minimal[i] = chunk[i].is_minimal();
+                                          return minimal[i] ? chunk[i].key() : !chunk[i].key();
+                                      },
+                                      [&](size_t i, size_t idx) {
+                                          chunk[i].SetIdx(idx, minimal[i]);
+                                          if (KeyBase::valid(idx))
+                                              __builtin_prefetch(&data_[idx]);
+                                      });
+        }
+    }
+
     const V get_value(const KeyWithHash &kwh) const {
         return StoringType::get_value(data_, kwh);
     }
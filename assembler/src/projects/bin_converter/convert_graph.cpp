@@ -0,0 +1,86 @@
+//***************************************************************************
+//* Copyright (c) 2019 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "version.hpp"
+
+#include "assembly_graph/core/graph.hpp"
+#include "io/binary/graph.hpp"
+
+#include "utils/logger/log_writers.hpp"
+#include "utils/filesystem/path_helper.hpp"
+
+#include <clipp/clipp.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+namespace convert_graph {
+struct Args {
+    unsigned k = 0;
+    bool force = false;
+    std::vector<std::string> basenames;
+};
+}
+
+void process_cmdline(int argc, char **argv, convert_graph::Args &args) {
+    using namespace clipp;
+    bool print_help = false;
+
+    auto cli = (
+        (required("-k") & integer("value", args.k)) % "k-mer length of the graph",
+        (option("-f", "--force").set(args.force)) % "Convert even if the packed graph exists",
+        (option("-h", "--help").set(print_help)) % "Show help",
+        values("basename", args.basenames) % "Basenames of the saves, e.g. saves/K55/graph_pack"
+    );
+
+    auto help_message = make_man_page(cli, argv[0])
+        .prepend_section("DESCRIPTION",
+                         "Convert graphs saved vertex by vertex (.grseq) to the packed format (.grpk).");
+
+    auto result = parse(argc, argv, cli);
+    if (!result || print_help || args.basenames.empty()) {
+        std::cout << help_message;
+        if (print_help) {
+            exit(0);
+        } else {
+            exit(1);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    convert_graph::Args args;
+    process_cmdline(argc, argv, args);
+
+    create_console_logger();
+
+    START_BANNER("SPAdes graph saves converter");
+
+    using Graph = debruijn_graph::DeBruijnGraph;
+    using io::binary::PackedGraphIO;
+    for (const auto &basename : args.basenames) {
+        if (!args.force && fs::check_existence(PackedGraphIO<Graph>::FileName(basename))) {
+            INFO("Skipping " << basename << ", packed graph exists");
+            continue;
+        }
+
+        Graph g(args.k);
+        INFO("Loading " << basename << ".grseq");
+        io::binary::GraphIO<Graph>().LoadUnpacked(basename, g);
+        INFO("Saving " << PackedGraphIO<Graph>::FileName(basename));
+        PackedGraphIO<Graph>().Save(basename, g);
+    }
+
+    return 0;
+}
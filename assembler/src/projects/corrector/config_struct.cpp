@@ -51,6 +51,7 @@ struct MappingTraits<corrector::corrector_config> {
         io.mapOptional("work_dir", cfg.work_dir, std::string("."));
         io.mapOptional("output_dir", cfg.output_dir, std::string("."));
         io.mapOptional("max_nthreads", cfg.max_nthreads, 1u);
+        io.mapOptional("max_memory", cfg.max_memory, 2u);
         io.mapRequired("strategy", cfg.strat);
         io.mapOptional("bwa", cfg.bwa, std::string("."));
         io.mapOptional("log_filename", cfg.log_filename, std::string("."));
@@ -23,6 +23,7 @@ struct corrector_config {
     std::string work_dir;
     std::string output_dir;
     unsigned max_nthreads;
+    unsigned max_memory;
     Strategy strat;
     std::string bwa;
     std::string log_filename;
@@ -37,7 +37,7 @@ void ContigProcessor::ReadContig() {
     charts_.resize(contig_.length());
 }
 
-void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm) {
+void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp, IndexedBamStream &sm) {
     unordered_map<size_t, position_description> all_positions;
     if (tmp.contig_id() < 0) {
         return;
@@ -249,17 +249,61 @@ bool ContigProcessor::CountPositions(const PairedSamRead &read, unordered_map<si
     return (t1 && t2);
 }
 
+// Mates are not adjacent in coordinate-sorted alignments, so pair them up by read name.
+// Reads without a mate in this range (the mate is unmapped or aligned to another contig)
+// and non-main alignments are counted as single reads.
+void ContigProcessor::UpdateInterestingPairs(IndexedBamStream &sm) {
+    auto update_single = [this](const SingleSamRead &read) {
+        unordered_map<size_t, position_description> ps;
+        CountPositions(read, ps);
+        ipp_.UpdateInterestingRead(ps);
+    };
+
+    // Unpaired reads are kept in the order of alignment
+    vector<SingleSamRead> reads;
+    vector<bool> paired;
+    unordered_map<string, size_t> unpaired;
+    while (!sm.eof()) {
+        SingleSamRead tmp;
+        sm >> tmp;
+        if (!tmp.is_main_alignment()) {
+            update_single(tmp);
+            continue;
+        }
+        auto it = unpaired.find(tmp.name());
+        if (it == unpaired.end()) {
+            unpaired.emplace(tmp.name(), reads.size());
+            reads.push_back(tmp);
+            paired.push_back(false);
+            continue;
+        }
+
+        SingleSamRead &mate = reads[it->second];
+        PairedSamRead pair = mate.is_first_in_pair() ? PairedSamRead(mate, tmp) : PairedSamRead(tmp, mate);
+        paired[it->second] = true;
+        unpaired.erase(it);
+        unordered_map<size_t, position_description> ps;
+        CountPositions(pair, ps);
+        ipp_.UpdateInterestingRead(ps);
+    }
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+        if (!paired[i])
+            update_single(reads[i]);
+    }
+}
+
 size_t ContigProcessor::ProcessMultipleSamFiles() {
     error_counts_.resize(kMaxErrorNum);
-    for (const auto &sf : sam_files_) {
-        MappedSamStream sm(sf.first);
+    for (const auto &bs : bam_streams_) {
+        IndexedBamStream &sm = *bs.first;
+        CHECK_FATAL_ERROR(sm.fetch(contig_name_), "No contig " + contig_name_ + " in BAM file header");
         while (!sm.eof()) {
             SingleSamRead tmp;
             sm >> tmp;
 
             UpdateOneRead(tmp, sm);
         }
-        sm.close();
     }
     size_t total_coverage = 0;
     for (const auto &pos: charts_)
@@ -275,22 +319,20 @@ size_t ContigProcessor::ProcessMultipleSamFiles() {
                << " setting interesting positions heuristics to " << interesting_weight_cutoff);
     }
     ipp_.FillInterestingPositions(charts_);
-    for (const auto &sf : sam_files_) {
-        MappedSamStream sm(sf.first);
+    for (const auto &bs : bam_streams_) {
+        IndexedBamStream &sm = *bs.first;
+        CHECK_FATAL_ERROR(sm.fetch(contig_name_), "No contig " + contig_name_ + " in BAM file header");
+        if (bs.second == io::LibraryType::PairedEnd) {
+            UpdateInterestingPairs(sm);
+            continue;
+        }
         while (!sm.eof()) {
             unordered_map<size_t, position_description> ps;
-            if (sf.second == io::LibraryType::PairedEnd ) {
-                PairedSamRead tmp;
-                sm >> tmp;
-                CountPositions(tmp, ps);
-            } else {
-                SingleSamRead tmp;
-                sm >> tmp;
-                CountPositions(tmp, ps);
-            }
+            SingleSamRead tmp;
+            sm >> tmp;
+            CountPositions(tmp, ps);
             ipp_.UpdateInterestingRead(ps);
         }
-        sm.close();
     }
     ipp_.UpdateInterestingPositions();
     unordered_map<size_t, position_description> interesting_positions = ipp_.get_weights();
@@ -14,6 +14,7 @@
 #include <io/sam/read.hpp>
 #include "pipeline/library_fwd.hpp"
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -23,8 +24,9 @@ namespace corrector {
 using namespace sam_reader;
 
 typedef std::vector<std::pair<std::string, io::LibraryType> > sam_files_type;
+typedef std::vector<std::pair<std::unique_ptr<IndexedBamStream>, io::LibraryType> > bam_streams_type;
 class ContigProcessor {
-    sam_files_type sam_files_;
+    bam_streams_type &bam_streams_;
     std::string contig_file_;
     std::string contig_name_;
     std::string output_contig_file_;
@@ -38,8 +40,8 @@ class ContigProcessor {
 protected:
     DECL_LOGGER("ContigProcessor")
 public:
-    ContigProcessor(const sam_files_type &sam_files, const std::string &contig_file)
-            : sam_files_(sam_files), contig_file_(contig_file) {
+    ContigProcessor(bam_streams_type &bam_streams, const std::string &contig_file)
+            : bam_streams_(bam_streams), contig_file_(contig_file) {
         ReadContig();
         ipp_.set_contig(contig_);
 //At least three reads to believe in inexact repeats heuristics.
@@ -52,7 +54,8 @@ private:
     bool CountPositions(const SingleSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
     bool CountPositions(const PairedSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
 
-    void UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm);
+    void UpdateOneRead(const SingleSamRead &tmp, IndexedBamStream &sm);
+    void UpdateInterestingPairs(IndexedBamStream &sm);
     //returns: number of changed nucleotides;
 
     size_t UpdateOneBase(size_t i, std::stringstream &ss, const std::unordered_map<size_t, position_description> &interesting_positions) const ;
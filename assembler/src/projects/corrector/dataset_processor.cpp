@@ -15,8 +15,6 @@
 #include "io/reads/osequencestream.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
-#include <boost/algorithm/string.hpp>
-
 #include <iostream>
 #include <unistd.h>
 
@@ -44,83 +42,26 @@ void DatasetProcessor::SplitGenome(const string &genome_splitted_dir) {
         }
         string full_path = fs::append_path(genome_splitted_dir, contig_name + ".fasta");
         string out_full_path = fs::append_path(genome_splitted_dir, contig_name + ".ref.fasta");
-        string sam_filename = fs::append_path(genome_splitted_dir, contig_name + ".pair.sam");
-        all_contigs_[contig_name] = {full_path, out_full_path, contig_seq.length(), sam_files_type(), sam_filename, cur_id};
+        all_contigs_[contig_name] = {full_path, out_full_path, contig_seq.length(), cur_id};
         cur_id ++;
-        buffered_reads_[contig_name].clear();
         io::OFastaReadStream oss(full_path);
         oss << io::SingleRead(contig_name, contig_seq);
         DEBUG("full_path " + full_path)
     }
 }
 
-//contigs - set of aligned contig names
-void DatasetProcessor::GetAlignedContigs(const string &read, set<string> &contigs) const {
-    vector<string> arr;
-    boost::split(arr, read, boost::is_any_of("\t"));
-    if (arr.size() > 5) {
-        if (arr[2] != "*" && stoi(arr[4]) > 0) {
-// here can be multuple aligned parsing if neeeded;
-            contigs.insert(arr[2]);
-        }
-    }
-
-}
-
-void DatasetProcessor::SplitLibrary(const string &all_reads_filename, const size_t lib_count, bool is_paired = false) {
-    int reads_cnt = is_paired ? 2 : 1;
-    ifstream fs(all_reads_filename);
-    while (!fs.eof()) {
-        set<string> contigs;
-        std::vector<std::string> reads(reads_cnt);
-        getline(fs, reads[0]);
-        if (reads[0][0] == '@')
-            continue;
-
-        if (is_paired) {
-            getline(fs, reads[1]);
-        }
-
-        for (int i = 0; i < reads_cnt; ++i) {
-            GetAlignedContigs(reads[i], contigs);
-        }
-
-        for (auto &contig : contigs) {
-            CHECK_FATAL_ERROR(all_contigs_.find(contig) != all_contigs_.end(),
-                              "wrong contig name in SAM file header: " + contig);
-
-            for (int i = 0; i < reads_cnt; ++i) {
-                BufferedOutputRead(reads[i], contig, lib_count);
-            }
-        }
-    }
-    FlushAll(lib_count);
-}
-
-void DatasetProcessor::FlushAll(const size_t lib_count) {
-    for (const auto &ac : all_contigs_) {
-        if (buffered_reads_[ac.first].size() > 0) {
-            ofstream stream(ac.second.sam_filenames[lib_count].first.c_str(), std::ios_base::app | std::ios_base::out);
-            for (const string &read : buffered_reads_[ac.first]) {
-                stream << read;
-                stream << '\n';
-            }
-            buffered_reads_[ac.first].clear();
-        }
-    }
+// Instead of splitting alignments into per-contig files, sort them by coordinate once,
+// so the alignments to each contig could be fetched as a single range
+std::string DatasetProcessor::SortAlignments(const string &sam_filename, const size_t lib_count) {
+    string prefix = fs::append_path(GetLibDir(lib_count), "sorted");
+    INFO("Sorting alignments from " << sam_filename);
+    // samtools estimates the memory it uses very roughly, so leave it only half of the limit
+    size_t sort_memory = (size_t(corr_cfg::get().max_memory) << 30) / 2;
+    string bam_filename = sam_reader::SortAndIndexSam(sam_filename, prefix, sort_memory);
+    fs::remove_if_exists(sam_filename);
+    return bam_filename;
 }
 
-void DatasetProcessor::BufferedOutputRead(const string &read, const string &contig_name, const size_t lib_count) {
-    buffered_reads_[contig_name].push_back(read);
-    buffered_count_++;
-    if (buffered_count_ % kBuffSize == 0) {
-        if (buffered_count_ % (10 * kBuffSize) == 0)
-            INFO("processed " << buffered_count_ << "reads, flushing");
-        FlushAll(lib_count);
-    }
-}
-
-
 int DatasetProcessor::RunBwaIndex() {
     string bwa_string = fs::screen_whitespaces(fs::screen_whitespaces(corr_cfg::get().bwa));
     string genome_screened = fs::screen_whitespaces(genome_file_);
@@ -159,17 +100,6 @@ std::string DatasetProcessor::RunBwaMem(const std::vector<std::string> &reads, c
     return tmp_sam_filename;
 }
 
-void DatasetProcessor::PrepareContigDirs(const size_t lib_count) {
-    string out_dir = GetLibDir(lib_count);
-    for (auto &ac : all_contigs_) {
-        auto contig_name = ac.first;
-        string out_name = fs::append_path(out_dir, contig_name + ".sam");
-        ac.second.sam_filenames.push_back(make_pair(out_name, unsplitted_sam_files_[lib_count].second));
-        BufferedOutputRead("@SQ\tSN:" + contig_name + "\tLN:" + to_string(all_contigs_[contig_name].contig_length), contig_name, lib_count);
-    }
-    FlushAll(lib_count);
-}
-
 void DatasetProcessor::ProcessDataset() {
     size_t lib_num = 0;
     INFO("Splitting assembly...");
@@ -197,9 +127,7 @@ void DatasetProcessor::ProcessDataset() {
         string samf = RunBwaMem(reads, lib_num, param);
         if (samf != "") {
             INFO("Adding samfile " << samf);
-            unsplitted_sam_files_.push_back(make_pair(samf, lib_type));
-            PrepareContigDirs(lib_num);
-            SplitLibrary(samf, lib_num,lib_type !=  io::LibraryType::SingleReads);
+            sorted_bam_files_.push_back(make_pair(SortAlignments(samf, lib_num), lib_type));
             lib_num++;
         } else {
             FATAL_ERROR("Failed to align " + type + " reads " << reads_files_str);
@@ -232,10 +160,18 @@ void DatasetProcessor::ProcessDataset() {
     size_t cont_num = ordered_contigs.size();
     sort(ordered_contigs.begin(), ordered_contigs.end(), std::greater<pair<size_t, string> >());
     auto all_contigs_ptr = &all_contigs_;
-# pragma omp parallel for shared(all_contigs_ptr, ordered_contigs) num_threads(nthreads_) schedule(dynamic,1)
+    // Every thread reads the sorted alignments through its own streams
+    std::vector<bam_streams_type> thread_streams(nthreads_);
+    for (auto &streams : thread_streams) {
+        for (const auto &bf : sorted_bam_files_) {
+            streams.emplace_back(std::make_unique<IndexedBamStream>(bf.first), bf.second);
+            CHECK_FATAL_ERROR(streams.back().first->is_open(), "Failed to open sorted alignments " + bf.first);
+        }
+    }
+# pragma omp parallel for shared(all_contigs_ptr, ordered_contigs, thread_streams) num_threads(nthreads_) schedule(dynamic,1)
     for (size_t i = 0; i < cont_num; i++) {
         bool long_enough = (*all_contigs_ptr)[ordered_contigs[i].second].contig_length > kMinContigLengthForInfo;
-        ContigProcessor pc((*all_contigs_ptr)[ordered_contigs[i].second].sam_filenames, (*all_contigs_ptr)[ordered_contigs[i].second].input_contig_filename);
+        ContigProcessor pc(thread_streams[omp_get_thread_num()], (*all_contigs_ptr)[ordered_contigs[i].second].input_contig_filename);
         size_t changes = pc.ProcessMultipleSamFiles();
         if (long_enough) {
 #pragma omp critical
@@ -61,6 +61,7 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   load(cfg.expand_nthreads, pt, "expand_nthreads");
   load(cfg.expand_write_each_iteration, pt, "expand_write_each_iteration");
   load(cfg.expand_write_kmers_result, pt, "expand_write_kmers_result");
+  load(cfg.expand_cache_reads, pt, "expand_cache_reads", false);
 
   load(cfg.correct_do, pt, "correct_do");
   load(cfg.correct_nthreads, pt, "correct_nthreads");
@@ -69,6 +69,7 @@ struct hammer_config {
   unsigned expand_nthreads;
   bool expand_write_each_iteration;
   bool expand_write_kmers_result;
+  bool expand_cache_reads = true;
 
   bool correct_do;
   bool correct_discard_bad;
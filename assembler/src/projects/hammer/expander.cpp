@@ -13,15 +13,76 @@
 #include "valid_kmer_generator.hpp"
 
 #include "io/reads/read.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
 #include <vector>
 #include <cstring>
 
+void ExpansionReadCache::push_back(unsigned thread_id, const std::vector<uint8_t> &nucls) {
+  Chunk &chunk = chunks_[thread_id];
+  if (chunk.overflowed)
+    return;
+
+  uint64_t pos = chunk.offsets.back();
+  size_t words = (pos + nucls.size() + 31) / 32;
+  // Vectors might double their capacity on growth
+  if (2 * (words + chunk.offsets.size() + 1) * sizeof(uint64_t) > chunk_budget_) {
+    chunk.overflowed = true;
+    chunk.data.clear();
+    chunk.data.shrink_to_fit();
+    chunk.offsets.assign(1, 0);
+    chunk.offsets.shrink_to_fit();
+    return;
+  }
+
+  chunk.data.resize(words, 0);
+  for (uint8_t c : nucls) {
+    chunk.data[pos / 32] |= uint64_t(c) << (2 * (pos % 32));
+    pos += 1;
+  }
+  chunk.offsets.push_back(pos);
+}
+
+void ExpansionReadCache::get(unsigned chunk, size_t idx, std::vector<uint8_t> &nucls) const {
+  const Chunk &c = chunks_[chunk];
+  uint64_t start = c.offsets[idx], end = c.offsets[idx + 1];
+  nucls.resize(end - start);
+  for (uint64_t pos = start; pos < end; ++pos)
+    nucls[pos - start] = uint8_t((c.data[pos / 32] >> (2 * (pos % 32))) & 3);
+}
+
+bool ExpansionReadCache::overflowed() const {
+  for (const auto &chunk : chunks_) {
+    if (chunk.overflowed)
+      return true;
+  }
+  return false;
+}
+
+size_t ExpansionReadCache::size() const {
+  size_t res = 0;
+  for (unsigned chunk = 0; chunk < chunks(); ++chunk)
+    res += size(chunk);
+  return res;
+}
+
+size_t ExpansionReadCache::nucls() const {
+  size_t res = 0;
+  for (const auto &chunk : chunks_)
+    res += chunk.offsets.back();
+  return res;
+}
+
 bool Expander::operator()(std::unique_ptr<Read> r) {
+  return (*this)(*r);
+}
+
+bool Expander::operator()(const Read &r) {
   uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
   // FIXME: Get rid of this
-  Read cr = *r;
+  Read cr = r;
   size_t sz = cr.trimNsAndBadQuality(trim_quality);
 
   if (sz < hammer::K)
@@ -30,20 +91,72 @@ bool Expander::operator()(std::unique_ptr<Read> r) {
   std::vector<unsigned> covered_by_solid(sz, false);
   std::vector<size_t> kmer_indices(sz, -1ull);
 
+  size_t valid_kmers = 0;
   ValidKMerGenerator<hammer::K> gen(cr);
   while (gen.HasMore()) {
     hammer::KMer kmer = gen.kmer();
     size_t idx = data_.checking_seq_idx(kmer);
-    if (idx != -1ULL) {
-      size_t read_pos = gen.pos() - 1;
+    if (idx != -1ULL)
+      kmer_indices[gen.pos() - 1] = idx;
+    valid_kmers += 1;
+    gen.Next();
+  }
 
-      kmer_indices[read_pos] = idx;
-      if (data_[idx].good()) {
-        for (size_t j = read_pos; j < read_pos + hammer::K; ++j)
-          covered_by_solid[j] = true;
+  if (Expand(kmer_indices, covered_by_solid) || !pending_)
+    return false;
+
+  // Reads with some positions outside of valid k-mers (e.g. Ns) can never be covered
+  if (valid_kmers != sz - hammer::K + 1)
+    return false;
+
+  const std::string &seq = cr.getSequenceString();
+  std::vector<uint8_t> nucls(sz);
+  for (size_t j = 0; j < sz; ++j)
+    nucls[j] = dignucl(seq[j]);
+  pending_->push_back(omp_get_thread_num(), nucls);
+
+  return false;
+}
+
+void Expander::Run(const ExpansionReadCache &cache, unsigned nthreads) {
+# pragma omp parallel num_threads(nthreads)
+  {
+    std::vector<uint8_t> nucls;
+    std::vector<size_t> kmer_indices;
+    std::vector<unsigned> covered_by_solid;
+
+    for (unsigned chunk = 0; chunk < cache.chunks(); ++chunk) {
+#     pragma omp for schedule(guided)
+      for (size_t i = 0; i < cache.size(chunk); ++i) {
+        cache.get(chunk, i, nucls);
+        size_t sz = nucls.size();
+        kmer_indices.assign(sz, -1ull);
+        covered_by_solid.resize(sz);
+
+        hammer::KMer kmer(nucls, 0);
+        for (size_t j = 0; ; ++j) {
+          kmer_indices[j] = data_.checking_seq_idx(kmer);
+          if (j + hammer::K == sz)
+            break;
+          kmer = kmer << char(nucls[j + hammer::K]);
+        }
+
+        if (!Expand(kmer_indices, covered_by_solid) && pending_)
+          pending_->push_back(omp_get_thread_num(), nucls);
       }
     }
-    gen.Next();
+  }
+}
+
+bool Expander::Expand(const std::vector<size_t> &kmer_indices, std::vector<unsigned> &covered_by_solid) {
+  size_t sz = kmer_indices.size();
+  std::fill(covered_by_solid.begin(), covered_by_solid.end(), false);
+  for (size_t read_pos = 0; read_pos < sz; ++read_pos) {
+    size_t idx = kmer_indices[read_pos];
+    if (idx != -1ull && data_[idx].good()) {
+      for (size_t j = read_pos; j < read_pos + hammer::K; ++j)
+        covered_by_solid[j] = true;
+    }
   }
 
   for (size_t j = 0; j < sz; ++j)
@@ -65,6 +178,6 @@ bool Expander::operator()(std::unique_ptr<Read> r) {
       kmer_data.unlock();
     }
   }
-    
-  return false;
+
+  return true;
 }
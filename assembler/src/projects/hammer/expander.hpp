@@ -11,20 +11,63 @@
 class KMerData;
 class Read;
 
+#include <cstdint>
 #include <cstring>
 #include <memory>
+#include <vector>
+
+// Trimmed reads which are not yet covered by solid k-mers, but might become covered
+// during later expansion iterations. Nucleotides are stored 2-bit packed, one chunk
+// per thread, so chunks are filled without synchronization. Every chunk gets an
+// equal share of the memory budget; once some read does not fit, the cache is
+// overflowed and could not be used instead of the input.
+class ExpansionReadCache {
+  struct Chunk {
+    std::vector<uint64_t> data;
+    // Start of each read in nucleotides, plus the end of the last one
+    std::vector<uint64_t> offsets = { 0 };
+    bool overflowed = false;
+  };
+  std::vector<Chunk> chunks_;
+  size_t chunk_budget_;
+
+ public:
+  ExpansionReadCache(unsigned nthreads, size_t max_memory)
+      : chunks_(nthreads), chunk_budget_(max_memory / nthreads) {}
+
+  // Appends the read of nucleotides encoded as 0123, unless it does not fit into the budget
+  void push_back(unsigned thread_id, const std::vector<uint8_t> &nucls);
+
+  bool overflowed() const;
+
+  unsigned chunks() const { return unsigned(chunks_.size()); }
+  size_t size(unsigned chunk) const { return chunks_[chunk].offsets.size() - 1; }
+  size_t size() const;
+  size_t nucls() const;
+
+  // Unpacks the idx-th read of the chunk as 0123
+  void get(unsigned chunk, size_t idx, std::vector<uint8_t> &nucls) const;
+};
 
 class Expander {
   KMerData &data_;
+  ExpansionReadCache *pending_;
   size_t changed_;
-  
+
+  bool Expand(const std::vector<size_t> &kmer_indices, std::vector<unsigned> &covered_by_solid);
+
  public:
-  Expander(KMerData &data) 
-      : data_(data), changed_(0) {}
+  // Reads which may become covered later are saved into pending, if given
+  Expander(KMerData &data, ExpansionReadCache *pending = nullptr)
+      : data_(data), pending_(pending), changed_(0) {}
 
   size_t changed() const { return changed_; }
 
   bool operator()(std::unique_ptr<Read> r);
+  bool operator()(const Read &r);
+
+  // Runs over the reads left pending after the previous iteration instead of the input
+  void Run(const ExpansionReadCache &cache, unsigned nthreads);
 };
 
 #endif
@@ -14,6 +14,8 @@
 #include "config_struct_hammer.hpp"
 #include "globals.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -40,34 +42,57 @@ struct SubKMerComparator {
 };
 
 template<class Op>
-std::pair<size_t, size_t> SubKMerSplitter::split(Op &&op) {
+std::pair<size_t, size_t> SubKMerSplitter::split(Op &&op, unsigned nthreads) {
+  // Small input blocks are gathered until the batch has this many k-mers
+  const size_t batch_size = 1 << 20;
   std::vector<SubKMer> data; std::vector<size_t> blocks;
+  std::vector<size_t> starts, chunks;
 
   MMappedReader bifs(bifname_, /* unlink */ true);
   MMappedReader kifs(kifname_, /* unlink */ true);
   size_t icnt = 0, ocnt = 0;
   while (bifs.good()) {
-    deserialize(blocks, data, bifs, kifs);
+    data.clear(); blocks.clear();
+    starts.assign(1, 0);
+    while (bifs.good() && data.size() < batch_size) {
+      deserialize(blocks, data, bifs, kifs);
+      starts.push_back(data.size());
+      icnt += 1;
+    }
 
     using PairSort = parallel_radix_sort::PairSort<SubKMer, size_t, SubKMer, EncoderKMer>;
-    // PairSort::InitAndSort(data.data(), blocks.data(), data.size());
-    PairSort::InitAndSort(data.data(), blocks.data(), data.size(), data.size() > 1000*16 ? -1 : 1);
-
-    for (auto start = data.begin(), end = data.end(); start != end;) {
-      auto chunk_end = std::upper_bound(start + 1, data.end(), *start, SubKMerComparator());
-      op(blocks.begin() + (start - data.begin()), chunk_end - start);
-      start = chunk_end;
-      ocnt += 1;
+    size_t ninput = starts.size() - 1;
+    if (ninput == 1) {
+      PairSort::InitAndSort(data.data(), blocks.data(), data.size(), data.size() > 1000*16 ? -1 : 1);
+    } else {
+#     pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+      for (size_t i = 0; i < ninput; ++i)
+        PairSort::InitAndSort(data.data() + starts[i], blocks.data() + starts[i], starts[i + 1] - starts[i], 1);
+    }
+
+    chunks.clear();
+    for (size_t i = 0; i < ninput; ++i) {
+      for (auto start = data.begin() + starts[i], end = data.begin() + starts[i + 1]; start != end;) {
+        auto chunk_end = std::upper_bound(start + 1, end, *start, SubKMerComparator());
+        chunks.push_back(start - data.begin());
+        start = chunk_end;
+      }
     }
-    icnt += 1;
+    chunks.push_back(data.size());
+
+    size_t nchunks = chunks.size() - 1;
+#   pragma omp parallel for schedule(dynamic, 16) num_threads(nthreads)
+    for (size_t i = 0; i < nchunks; ++i)
+      op(blocks.begin() + chunks[i], chunks[i + 1] - chunks[i]);
+
+    ocnt += nchunks;
   }
 
   return std::make_pair(icnt, ocnt);
 }
 
 #if 1
-static bool canMerge(const dsu::ConcurrentDSU &uf, size_t x, size_t y) {
-  size_t szx = uf.set_size(x), szy = uf.set_size(y);
+static bool canMerge(size_t szx, size_t szy) {
   const size_t hardthr = 2500;
 
   // Global threshold - no cluster larger than hard threshold
@@ -83,8 +108,8 @@ static bool canMerge(const dsu::ConcurrentDSU &uf, size_t x, size_t y) {
   return true;
 }
 #else
-static bool canMerge(const ConcurrentDSU &uf, size_t x, size_t y) {
-  return (uf.set_size(x) + uf.set_size(y)) < 10000;
+static bool canMerge(size_t szx, size_t szy) {
+  return (szx + szy) < 10000;
 }
 #endif
 
@@ -100,10 +125,10 @@ static void processBlockQuadratic(dsu::ConcurrentDSU  &uf,
     for (size_t j = i + 1; j < block_size; j++) {
       size_t y = block[j];
       hammer::KMer kmery = data.kmer(y);
+      // Size check and link are done atomically, blocks are processed concurrently
       if (!uf.same(x, y) &&
-          canMerge(uf, x, y) &&
           hamdistKMer(kmerx, kmery, tau) <= tau) {
-        uf.unite(x, y);
+        uf.unite_if(x, y, canMerge);
       }
     }
   }
@@ -113,6 +138,7 @@ void KMerHamClusterer::cluster(const std::string &prefix,
                                const KMerData &data,
                                dsu::ConcurrentDSU &uf) {
   // First pass - split & sort the k-mers
+  unsigned nthreads = cfg::get().general_max_nthreads;
   std::string fname = prefix + ".first", bfname = fname + ".blocks", kfname = fname + ".kmers";
   std::ofstream bfs(bfname, std::ios::out | std::ios::binary);
   std::ofstream kfs(kfname, std::ios::out | std::ios::binary);
@@ -149,15 +175,18 @@ void KMerHamClusterer::cluster(const std::string &prefix,
           // Merge small blocks.
           processBlockQuadratic(uf, start, sz, data, tau_);
         } else {
-          big_blocks1 += 1;
           // Otherwise - dump for next iteration.
-          for (unsigned i = 0; i < tau_ + 1; ++i) {
-            serialize(bfs, kfs,
-                      data, &start, sz,
-                      SubKMerStridedSerializer(i, tau_ + 1));
+#         pragma omp critical(hamcluster_dump)
+          {
+            big_blocks1 += 1;
+            for (unsigned i = 0; i < tau_ + 1; ++i) {
+              serialize(bfs, kfs,
+                        data, &start, sz,
+                        SubKMerStridedSerializer(i, tau_ + 1));
+            }
           }
         }
-    });
+    }, nthreads);
     INFO("Splitting done."
          " Processed " << stat.first << " blocks."
          " Produced " << stat.second << " blocks.");
@@ -180,6 +209,7 @@ void KMerHamClusterer::cluster(const std::string &prefix,
     std::pair<size_t, size_t> stat =
       Splitter.split([&] (const std::vector<size_t>::iterator &start, size_t sz) {
         if (sz > 50) {
+#         pragma omp atomic
           big_blocks2 += 1;
 #if 0
           for (size_t i = 0; i < block.size(); ++i) {
@@ -189,8 +219,9 @@ void KMerHamClusterer::cluster(const std::string &prefix,
 #endif
         }
         processBlockQuadratic(uf, start, sz, data, tau_);
+#       pragma omp atomic
         nblocks += 1;
-    });
+    }, nthreads);
     INFO("Splitting done."
             " Processed " << stat.first << " blocks."
             " Produced " << stat.second << " blocks.");
@@ -117,24 +117,26 @@ class SubKMerSplitter {
     os.write((char*)&*start, sz * sizeof(*start));
   }
 
+  // Appends the next block to blocks and kmers
   template<class Reader>
   void deserialize(std::vector<size_t> &blocks,
                    std::vector<SubKMer> &kmers,
                    Reader &bis, Reader &kis) {
-    kmers.clear(); blocks.clear();
-
-    size_t sz;
+    size_t sz, start = blocks.size();
     bis.read((char*)&sz, sizeof(sz));
-    blocks.resize(sz);
-    bis.read((char*)blocks.data(), sz * sizeof(blocks[0]));
+    blocks.resize(start + sz);
+    bis.read((char*)(blocks.data() + start), sz * sizeof(blocks[0]));
 
-    kmers.resize(sz);
-    for (size_t i = 0, e = sz; i != e; ++i)
+    kmers.resize(start + sz);
+    for (size_t i = start, e = start + sz; i != e; ++i)
       binary_read(kis, kmers[i]);
   }
 
+  // Calls op for every block of k-mers sharing the sub-k-mer. Input blocks are read in
+  // batches of bounded size, and the resulting blocks are processed concurrently, so op
+  // must be thread-safe.
   template<class Op>
-  std::pair<size_t, size_t> split(Op &&op);
+  std::pair<size_t, size_t> split(Op &&op, unsigned nthreads = 1);
 };
 
 class KMerHamClusterer {
@@ -62,9 +62,13 @@ class BufferFiller {
       : splitter_(splitter) {}
 
   bool operator()(std::unique_ptr<Read> r) {
+    return (*this)(*r);
+  }
+
+  bool operator()(const Read &r) {
     int trim_quality = cfg::get().input_trim_quality;
 
-    Read cr = *r;
+    Read cr = r;
     size_t sz = cr.trimNsAndBadQuality(trim_quality);
   
     if (sz < hammer::K)
@@ -91,16 +95,18 @@ HammerFilteringKMerSplitter::RawKMers HammerFilteringKMerSplitter::Split(size_t
 
   auto out = PrepareBuffers(num_files, nthreads, reads_buffer_size);
 
-  size_t n = 15, processed = 0;
+  size_t n = 15, read = 0, processed = 0;
   BufferFiller filler(*this);
   for (const auto &reads : cfg::get().dataset.reads()) {
     INFO("Processing " << reads);
     ireadstream irs(reads, cfg::get().input_qvoffset);
-    while (!irs.eof()) {
+    // Reads left unprocessed once some buffer is full are processed after the dump
+    std::vector<Read> pending;
+    while (!irs.eof() || !pending.empty()) {
       hammer::ReadProcessor rp(nthreads);
-      rp.Run(irs, filler);
+      rp.RunBatched(irs, filler, pending);
       DumpBuffers(out);
-      VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+      read += rp.read();
       processed += rp.processed();
 
       if (processed >> n) {
@@ -108,6 +114,7 @@ HammerFilteringKMerSplitter::RawKMers HammerFilteringKMerSplitter::Split(size_t
         n += 1;
       }
     }
+    VERIFY_MSG(read == processed, "Queue unbalanced");
   }
   INFO("Total " << processed << " reads processed");
 
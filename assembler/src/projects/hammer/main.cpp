@@ -195,14 +195,31 @@ int main(int argc, char * argv[]) {
       if (cfg::get().expand_do || do_everything) {
         unsigned expand_nthreads = std::min(cfg::get().general_max_nthreads, cfg::get().expand_nthreads);
         INFO("Starting solid k-mers expansion in " << expand_nthreads << " threads.");
+        // Reads not covered by solid k-mers yet. Only these can produce new solid k-mers,
+        // so after the first iteration the input is not parsed again.
+        std::unique_ptr<ExpansionReadCache> cache;
         for (unsigned expand_iter_no = 0; expand_iter_no < cfg::get().expand_max_iterations; ++expand_iter_no) {
-          Expander expander(*Globals::kmer_data);
-          const io::DataSet<> &dataset = cfg::get().dataset;
-          for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
-            ireadstream irs(*I, cfg::get().input_qvoffset);
-            hammer::ReadProcessor rp(expand_nthreads);
-            rp.Run(irs, expander);
-            VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+          std::unique_ptr<ExpansionReadCache> pending;
+          if (cfg::get().expand_cache_reads)
+            pending.reset(new ExpansionReadCache(expand_nthreads, utils::get_free_memory() / 2));
+          Expander expander(*Globals::kmer_data, pending.get());
+          if (cache) {
+            expander.Run(*cache, expand_nthreads);
+          } else {
+            const io::DataSet<> &dataset = cfg::get().dataset;
+            for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
+              ireadstream irs(*I, cfg::get().input_qvoffset);
+              hammer::ReadProcessor rp(expand_nthreads);
+              rp.RunBatched(irs, expander);
+              VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+            }
+          }
+          cache = std::move(pending);
+          if (cache && cache->overflowed()) {
+            INFO("Reads not covered by solid k-mers do not fit into memory, the input will be read again");
+            cache.reset();
+          } else if (cache) {
+            INFO("Reads not covered by solid k-mers: " << cache->size() << " (" << cache->nucls() << " bp)");
           }
 
           if (cfg::get().expand_write_each_iteration) {
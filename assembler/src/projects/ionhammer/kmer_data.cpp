@@ -95,37 +95,38 @@ HammerKMerSplitter::RawKMers HammerKMerSplitter::Split(size_t num_files, unsigne
   return out;
 }
 
-static inline void Merge(KMerStat &lhs, const KMerStat &rhs) {
-  if (lhs.count == 0) lhs.kmer = rhs.kmer;
-
-  lhs.count += rhs.count;
-  lhs.qual += rhs.qual;
-}
-
-static void PushKMer(KMerData &data, HKMer kmer, double qual) {
-  KMerStat &kmc = data[kmer];
-  kmc.lock();
-  Merge(kmc, KMerStat(1, kmer, (float)qual));
-  kmc.unlock();
+static void PushKMer(KMerData &data, KMerStatAccumulator &acc, HKMer kmer, double qual) {
+  acc.push(data.seq_idx(kmer), kmer, (float)qual);
 }
 
-static void PushKMerRC(KMerData &data, HKMer kmer, double qual) {
-  PushKMer(data, !kmer, qual);
+static void PushKMerRC(KMerData &data, KMerStatAccumulator &acc, HKMer kmer, double qual) {
+  PushKMer(data, acc, !kmer, qual);
 }
 
 class KMerDataFiller {
   KMerData &Data;
+  std::vector<std::unique_ptr<KMerStatAccumulator>> Accumulators;
   mutable std::default_random_engine RandomEngine;
   mutable std::uniform_real_distribution<double> UniformRandGenerator;
   mutable std::mutex Lock;
   double SampleRate;
 
  public:
-  KMerDataFiller(KMerData &data, double sampleRate = 1.0)
+  KMerDataFiller(KMerData &data, unsigned nthreads, double sampleRate = 1.0)
       : Data(data),
+        Accumulators(nthreads),
         RandomEngine(42),
         UniformRandGenerator(0, 1),
-        SampleRate(sampleRate) {}
+        SampleRate(sampleRate) {
+    for (auto &acc : Accumulators)
+      acc.reset(new KMerStatAccumulator(data));
+  }
+
+  // Adds the statistics still held by the per-thread accumulators
+  void Flush() {
+    for (auto &acc : Accumulators)
+      acc->flush();
+  }
 
   double NextUniform() const {
     std::lock_guard<std::mutex> guard(Lock);
@@ -145,6 +146,8 @@ class KMerDataFiller {
       return false;
     }
 
+    KMerStatAccumulator &acc = *Accumulators[omp_get_thread_num()];
+
     while (gen.HasMore()) {
       const HKMer kmer = gen.kmer();
       const double p = gen.correct_probability();
@@ -156,9 +159,9 @@ class KMerDataFiller {
 
       prior *= decay;
       {
-        PushKMer(Data, kmer, log(1 - correct));
+        PushKMer(Data, acc, kmer, log(1 - correct));
 
-        PushKMerRC(Data, kmer, log(1 - correct));
+        PushKMerRC(Data, acc, kmer, log(1 - correct));
       }
     }
     // Do not stop
@@ -180,8 +183,9 @@ void KMerDataCounter::FillKMerData(KMerData &data) {
        ++it) {
     INFO("Processing " << *it);
     io::FileReadStream irs(*it, io::PhredOffset);
-    KMerDataFiller filler(data, cfg::get().sample_rate);
+    KMerDataFiller filler(data, cfg::get().max_nthreads, cfg::get().sample_rate);
     hammer::ReadProcessor(cfg::get().max_nthreads).Run(irs, filler);
+    filler.Flush();
   }
 
   INFO("Collection done, postprocessing.");
@@ -27,17 +27,40 @@ struct KMerStat {
   float qual;
   float posterior_genomic_ll = -10000;
   bool dist_one_subcluster = false;
-  uint8_t lock_;
 
   KMerStat(int count = 0, HKMer kmer = HKMer(), float qual = 0.0)
-      : count(count), kmer(kmer), qual(qual), lock_(0) {}
+      : count(count), kmer(kmer), qual(qual) {}
+
+  // Lock-free accumulation, could be called concurrently for the same k-mer.
+  // The k-mer itself is set by the first update.
+  void add(const HKMer &k, int cnt, float q) {
+    if (__atomic_fetch_add(&count, cnt, __ATOMIC_RELAXED) == 0) kmer = k;
+
+    float old, desired;
+    __atomic_load(&qual, &old, __ATOMIC_RELAXED);
+    do {
+      desired = old + q;
+    } while (!__atomic_compare_exchange(&qual, &old, &desired, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  }
+
+  // Atomically raises the posterior to ll, returns the previous value
+  float raise_posterior(float ll) {
+    float old;
+    __atomic_load(&posterior_genomic_ll, &old, __ATOMIC_RELAXED);
+    while (old < ll &&
+           !__atomic_compare_exchange(&posterior_genomic_ll, &old, &ll, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return old;
+  }
 
-  void lock() {
-    while (__sync_val_compare_and_swap(&lock_, 0, 1) == 1) sched_yield();
+  void mark_dist_one_subcluster() {
+    __atomic_store_n(&dist_one_subcluster, true, __ATOMIC_RELAXED);
   }
-  void unlock() {
-    lock_ = 0;
-    __sync_synchronize();
+
+  bool is_dist_one_subcluster() const {
+    return __atomic_load_n(&dist_one_subcluster, __ATOMIC_RELAXED);
   }
 
   bool good() const {
@@ -45,9 +68,10 @@ struct KMerStat {
   }
 
   static double goodThreshold() { return cfg::get().good_threshold; }
+  static double skipThreshold() { return cfg::get().skip_threshold; }
 
   bool skip() const {
-    return posterior_genomic_ll > cfg::get().skip_threshold &&  !dist_one_subcluster;  // log(0.9)
+    return posterior_genomic_ll > skipThreshold() &&  !dist_one_subcluster;  // log(0.9)
   }
 
 };
@@ -124,6 +148,48 @@ class KMerData {
   friend class KMerDataCounter;
 };
 
+// Per-thread combining cache in front of KMerData. Updates of the recently
+// seen k-mers are summed up locally and added to the shared statistics only on
+// eviction, so hot (e.g. homopolymer) k-mers are not contended by all threads.
+class KMerStatAccumulator {
+  static constexpr size_t SIZE = 1024;
+
+  struct Entry {
+    size_t idx = -1ULL;
+    int count = 0;
+    float qual = 0;
+    hammer::HKMer kmer;
+  };
+
+  KMerData& data_;
+  std::vector<Entry> entries_;
+
+  void flush(Entry& e) {
+    if (e.count) data_[e.idx].add(e.kmer, e.count, e.qual);
+    e.count = 0;
+    e.qual = 0;
+  }
+
+ public:
+  KMerStatAccumulator(KMerData& data) : data_(data), entries_(SIZE) {}
+
+  void push(size_t idx, const hammer::HKMer& kmer, float qual) {
+    Entry& e = entries_[idx & (SIZE - 1)];
+    if (e.idx != idx) {
+      flush(e);
+      e.idx = idx;
+      e.kmer = kmer;
+    }
+    e.count += 1;
+    e.qual += qual;
+  }
+
+  // Must be called before the statistics are used
+  void flush() {
+    for (auto& e : entries_) flush(e);
+  }
+};
+
 struct CountCmp {
   const KMerData& kmer_data_;
 
@@ -247,16 +247,19 @@ void TGenomicHKMersEstimator::ProceedCluster(std::vector<size_t>& cluster) {
 
   for (size_t i = 0; i < posteriorQualities.size(); ++i) {
     const auto idx = centerCandidates[i];
-    data_[idx].lock();
-    const bool wasGood = data_[idx].good();
-    data_[idx].posterior_genomic_ll = (float)std::max(posteriorQualities[i], (double)data_[idx].posterior_genomic_ll);
-    data_[idx].dist_one_subcluster |= distOneGoodCenters[i];
-    data_[idx].unlock();
-    if (!wasGood && data_[idx].good()) {
+    const float prevQuality = data_[idx].raise_posterior((float)posteriorQualities[i]);
+    const bool wasGood = prevQuality > KMerStat::goodThreshold();
+    if (distOneGoodCenters[i]) {
+      data_[idx].mark_dist_one_subcluster();
+    }
+    // Transitions are decided from the value replaced by this thread, so that
+    // each of them is counted once when the same k-mer is raised concurrently
+    if (!wasGood && posteriorQualities[i] > KMerStat::goodThreshold()) {
 #pragma omp atomic
       GoodKmers++;
     }
-    if (!wasGood && data_[idx].skip()) {
+    if (!wasGood && posteriorQualities[i] > KMerStat::skipThreshold() &&
+        !data_[idx].is_dist_one_subcluster()) {
 #pragma omp atomic
       SkipKmers++;
     }
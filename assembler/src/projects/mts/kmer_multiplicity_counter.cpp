@@ -7,135 +7,198 @@
 #include <memory>
 #include <algorithm>
 #include <libcxx/sort.hpp>
-#include <boost/optional/optional.hpp>
 #include "getopt_pp/getopt_pp.h"
 #include "kmc_api/kmc_file.h"
-//#include "omp.h"
+#include "adt/loser_tree.hpp"
 #include "io/kmers/mmapped_reader.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/stl_utils.hpp"
 #include "utils/ph_map/perfect_hash_map_builder.hpp"
 #include "utils/ph_map/storing_traits.hpp"
 #include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "logger.hpp"
 
 using std::string;
 using std::vector;
 
-const string KMER_PARSED_EXTENSION = ".bin";
-const string KMER_SORTED_EXTENSION = ".sorted";
-
 class KmerMultiplicityCounter {
+    typedef adt::array_vector<seq_element_type> RecordVector;
+    typedef MMappedRecordArrayReader<seq_element_type> RunReader;
+    typedef RunReader::iterator RunIterator;
+    typedef uint16_t Mpl;
+
     size_t k_ ;
     std::string file_prefix_;
 
-    //TODO: get rid of intermediate .bin file
-    string ParseKmc(const string& filename) {
+    // Records are k-mer data words followed by the count
+    size_t RecordSize() const {
+        return RtSeq::GetDataSize(k_) + 1;
+    }
+
+    // Writes the records of the buffer sorted by k-mer into a new run
+    fs::TmpFile SortedRun(fs::TmpDir workdir, std::vector<seq_element_type>& buf) const {
+        RecordVector records(buf.data(), buf.size() / RecordSize(), RecordSize());
+        libcxx::sort(records.begin(), records.end(), adt::array_less<seq_element_type>());
+
+        auto run = fs::tmp::make_temp_file("run", workdir);
+        std::ofstream out(*run, std::ios::binary);
+        out.write((const char*) buf.data(), buf.size() * sizeof(seq_element_type));
+        return run;
+    }
+
+    // Lists KMC database into the runs of records sorted by k-mer. KMC lists
+    // k-mers bin by bin, so the records are sorted in chunks of at most
+    // max_records each to keep the memory bounded.
+    std::vector<fs::TmpFile> SortedKmcRuns(fs::TmpDir workdir, const string& filename,
+                                           size_t max_records) const {
         CKMCFile kmcFile;
-        kmcFile.OpenForListing(filename);
+        CHECK_FATAL_ERROR(kmcFile.OpenForListing(filename), "Cannot open KMC database " << filename);
         CKmerAPI kmer((unsigned int) k_);
         uint32 count;
-        std::string parsed_filename = filename + KMER_PARSED_EXTENSION;
-        std::ofstream output(parsed_filename, std::ios::binary);
+
+        size_t record_size = RecordSize();
+        std::vector<fs::TmpFile> runs;
+        std::vector<seq_element_type> buf;
+        buf.reserve(max_records * record_size);
+        std::vector<char> symbols(k_);
         while (kmcFile.ReadNextKmer(kmer, count)) {
-            RtSeq seq(k_, kmer.to_string());
-            seq.BinWrite(output);
-            seq_element_type tmp = count;
-            output.write((char*) &(tmp), sizeof(seq_element_type));
+            for (size_t i = 0; i < k_; ++i)
+                symbols[i] = (char) kmer.get_num_symbol((unsigned int) i);
+            RtSeq seq(k_, symbols);
+            buf.insert(buf.end(), seq.data(), seq.data() + seq.data_size());
+            buf.push_back(count);
+            if (buf.size() == max_records * record_size) {
+                runs.push_back(SortedRun(workdir, buf));
+                buf.clear();
+            }
         }
-        output.close();
-        return parsed_filename;
+        kmcFile.Close();
+
+        if (!buf.empty() || runs.empty())
+            runs.push_back(SortedRun(workdir, buf));
+        return runs;
     }
 
-    string SortKmersCountFile(const string& filename) {
-        MMappedRecordArrayReader<seq_element_type> ins(filename, RtSeq::GetDataSize(k_) + 1, false);
-        libcxx::sort(ins.begin(), ins.end(), adt::array_less<seq_element_type>());
-        std::string sorted_filename = filename + KMER_SORTED_EXTENSION;
-        std::ofstream out(sorted_filename);
-        out.write((char*) ins.data(), ins.data_size());
-        out.close();
-        remove(filename.c_str());
-        return sorted_filename;
+    // First word of k-mer data, runs are split into ranges by it
+    static seq_element_type Prefix(RunIterator::reference record) {
+        return record.data()[0];
     }
 
-    bool ReadKmerWithCount(std::ifstream& infile, std::pair<RtSeq, uint32>& res) {
-        RtSeq seq(res.first.size());
-        if (!seq.BinRead(infile)) {
-            return false;
+    // Merges the k-mers of all the runs having prefixes in [lo, hi) using the
+    // loser tree. Every sample is split into one or more runs, and a k-mer
+    // occurs at most once per sample.
+    void MergeRange(std::vector<adt::iterator_range<RunIterator>> ranges,
+                    const std::vector<size_t>& run_samples, size_t n,
+                    size_t all_min, size_t min_mult,
+                    std::ostream& output_kmer, std::ostream& mpl_file) const {
+        size_t data_size = RtSeq::GetDataSize(k_);
+        adt::loser_tree<RunIterator, adt::array_less<seq_element_type>> tree(ranges);
+
+        std::vector<seq_element_type> kmer(data_size);
+        std::vector<Mpl> cnt_vector(n);
+        while (!tree.empty()) {
+            const seq_element_type *top = tree.top().data();
+            std::copy(top, top + data_size, kmer.begin());
+            std::fill(cnt_vector.begin(), cnt_vector.end(), 0);
+
+            size_t cnt_min = 0, total_cnt = 0;
+            do {
+                seq_element_type cnt = tree.top().data()[data_size];
+                cnt_vector[run_samples[tree.top_run()]] = Mpl(cnt);
+                total_cnt += cnt;
+                cnt_min += 1;
+                tree.replay();
+            } while (!tree.empty() &&
+                     std::equal(kmer.begin(), kmer.end(), tree.top().data()));
+
+            if (cnt_min >= all_min && (cnt_min > 1 || total_cnt > min_mult)) {
+                output_kmer.write((const char*) kmer.data(), data_size * sizeof(seq_element_type));
+                mpl_file.write((const char*) cnt_vector.data(), n * sizeof(Mpl));
+            }
         }
-        seq_element_type tmp;
-        infile.read((char*) &tmp, sizeof(seq_element_type));
-        res = {seq, (uint32) tmp};
-        return true;
     }
 
-    fs::TmpFile FilterCombinedKmers(fs::TmpDir workdir, const std::vector<string>& files,
-                                    size_t all_min, size_t min_mult) {
-        size_t n = files.size();
-        vector<std::unique_ptr<ifstream>> infiles;
-        infiles.reserve(n);
-        for (auto fn : files) {
-            INFO("Processing " << fn);
-            auto parsed = ParseKmc(fn);
-            auto sorted = SortKmersCountFile(parsed);
-            infiles.emplace_back(new std::ifstream(sorted));
+    // Sorted runs are split into ranges by k-mer prefix, the ranges are merged
+    // in parallel and the results are concatenated in order
+    fs::TmpFile MergeRuns(fs::TmpDir workdir, const std::vector<std::vector<fs::TmpFile>>& sample_runs,
+                          size_t all_min, size_t min_mult, size_t nthreads) const {
+        std::vector<std::unique_ptr<RunReader>> readers;
+        std::vector<size_t> run_samples;
+        for (size_t i = 0; i < sample_runs.size(); ++i) {
+            for (const auto& run : sample_runs[i]) {
+                readers.emplace_back(new RunReader(*run, RecordSize(), /* unlink */ false));
+                run_samples.push_back(i);
+            }
         }
-        vector<std::pair<RtSeq, uint32>> top_kmer(n, {RtSeq(k_), 0});
-        vector<bool> alive(n, false);
 
-        for (size_t i = 0; i < n; i++) {
-            alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
+        // Data words keep 32 nucleotides at most
+        size_t prefix_bits = 2 * std::min<size_t>(k_, 4 * sizeof(seq_element_type));
+        seq_element_type max_prefix = (prefix_bits == 8 * sizeof(seq_element_type) ?
+                                       seq_element_type(-1) : (seq_element_type(1) << prefix_bits) - 1);
+        size_t range_cnt = std::max<size_t>(16 * nthreads, 1);
+
+        std::vector<fs::TmpFile> kmer_parts(range_cnt), mpl_parts(range_cnt);
+        for (size_t i = 0; i < range_cnt; ++i) {
+            kmer_parts[i] = fs::tmp::make_temp_file("kmer", workdir);
+            mpl_parts[i] = fs::tmp::make_temp_file("mpl", workdir);
         }
 
-        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
+        auto range_start = [&](size_t i) {
+            return seq_element_type(max_prefix / range_cnt * i);
+        };
 
-        typedef uint16_t Mpl;
+#       pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+        for (size_t i = 0; i < range_cnt; ++i) {
+            std::vector<adt::iterator_range<RunIterator>> ranges;
+            for (auto& reader : readers) {
+                auto less_than = [](seq_element_type bound) {
+                    return [bound](RunIterator::reference record) { return Prefix(record) < bound; };
+                };
+                RunIterator lo = std::partition_point(reader->begin(), reader->end(), less_than(range_start(i)));
+                RunIterator hi = (i + 1 == range_cnt ? reader->end() :
+                                  std::partition_point(lo, reader->end(), less_than(range_start(i + 1))));
+                ranges.push_back(adt::make_range(lo, hi));
+            }
+
+            std::ofstream output_kmer(*kmer_parts[i], std::ios::binary);
+            std::ofstream mpl_file(*mpl_parts[i], std::ios::binary);
+            MergeRange(ranges, run_samples, sample_runs.size(), all_min, min_mult, output_kmer, mpl_file);
+        }
+
+        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
         std::ofstream output_kmer(*kmer_file, std::ios::binary);
         std::ofstream mpl_file(file_prefix_ + ".bpr", std::ios_base::binary);
+        for (size_t i = 0; i < range_cnt; ++i) {
+            std::ifstream kmer_part(*kmer_parts[i], std::ios::binary), mpl_part(*mpl_parts[i], std::ios::binary);
+            if (kmer_part.peek() == std::ifstream::traits_type::eof())
+                continue;
+            output_kmer << kmer_part.rdbuf();
+            mpl_file << mpl_part.rdbuf();
+        }
 
-        RtSeq::less3 kmer_less;
-        while (true) {
-            boost::optional<RtSeq> min_kmer;
-            size_t cnt_min = 0, num_samples = 0;
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i]) {
-                    RtSeq& cur_kmer = top_kmer[i].first;
-                    if (!min_kmer || kmer_less(cur_kmer, *min_kmer)) {
-                        min_kmer = cur_kmer;
-                        cnt_min = 0;
-                    }
-                    if (cur_kmer == *min_kmer) {
-                        ++cnt_min;
-                    }
-                }
-            }
-            if (!min_kmer) {
-                break;
-            }
-            if (cnt_min >= all_min) {
-                std::vector<uint32> cnt_vector(n, 0);
-                size_t total_cnt = 0;
-                for (size_t i = 0; i < n; ++i) {
-                    if (alive[i] && top_kmer[i].first == *min_kmer) {
-                        auto cnt = top_kmer[i].second;
-                        cnt_vector[i] = cnt;
-                        total_cnt += cnt;
-                    }
-                }
-                if (cnt_min > 1 || total_cnt > min_mult) {
-                    min_kmer.get().BinWrite(output_kmer);
-                    for (size_t mpl : cnt_vector) {
-                        mpl_file.write(reinterpret_cast<char *>(&mpl), sizeof(Mpl));
-                    }
-                }
-            }
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i] && top_kmer[i].first == *min_kmer) {
-                    alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
-                }
+        return kmer_file;
+    }
+
+    fs::TmpFile FilterCombinedKmers(fs::TmpDir workdir, const std::vector<string>& files,
+                                    size_t all_min, size_t min_mult, size_t max_memory, size_t nthreads) {
+        // Every thread keeps a single chunk of records in memory
+        size_t record_bytes = RecordSize() * sizeof(seq_element_type);
+        size_t max_records = std::max<size_t>(max_memory / std::max<size_t>(nthreads, 1) / record_bytes, 1 << 20);
+        INFO("Sorting k-mers in chunks of " << max_records << " records");
+
+        std::vector<std::vector<fs::TmpFile>> runs(files.size());
+#       pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+        for (size_t i = 0; i < files.size(); ++i) {
+#           pragma omp critical
+            {
+                INFO("Processing " << files[i]);
             }
+            runs[i] = SortedKmcRuns(workdir, files[i], max_records);
         }
-        return kmer_file;
+
+        INFO("Merging k-mers of " << files.size() << " samples");
+        return MergeRuns(workdir, runs, all_min, min_mult, nthreads);
     }
 
     void BuildKmerIndex(fs::TmpDir workdir, fs::TmpFile kmer_file, size_t sample_cnt, size_t nthreads) {
@@ -186,9 +249,10 @@ public:
     }
 
     void CombineMultiplicities(const vector<string>& input_files, size_t min_samples,
-                               size_t min_mult, const string& tmpdir, size_t nthreads = 1) {
+                               size_t min_mult, const string& tmpdir, size_t max_memory,
+                               size_t nthreads = 1) {
         auto workdir = fs::tmp::make_temp_dir(tmpdir, "kmidx");
-        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult);
+        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult, max_memory, nthreads);
         BuildKmerIndex(workdir, kmer_file, input_files.size(), nthreads);
     }
 private:
@@ -204,6 +268,7 @@ void PrintUsageInfo() {
     std::cout << "-t - number of threads (default: 1)" << std::endl;
     std::cout << "-s - minimal number of samples to contain kmer" << std::endl;
     std::cout << "-m - minimal multiplicity of single-sample kmers" << std::endl;
+    std::cout << "-M - memory limit for sorting kmers in Gb (default: 4)" << std::endl;
     std::cout << "files_dir must contain two files (.kmc_pre and .kmc_suf) with kmer multiplicities for each sample from 1 to n" << std::endl;
 }
 
@@ -211,7 +276,7 @@ int main(int argc, char *argv[]) {
     using namespace GetOpt;
     create_console_logger();
 
-    size_t k, sample_cnt, min_samples, min_mult, nthreads;
+    size_t k, sample_cnt, min_samples, min_mult, max_memory, nthreads;
     string output, work_dir;
 
     try {
@@ -220,6 +285,7 @@ int main(int argc, char *argv[]) {
         ops >> Option('k', k)
             >> Option('n', sample_cnt)
             >> Option('m', "min-mult", min_mult, size_t(5))
+            >> Option('M', "memory", max_memory, size_t(4))
             >> Option('s', min_samples)
             >> Option('o', output)
             >> Option('t', "threads", nthreads, size_t(1))
@@ -236,6 +302,6 @@ int main(int argc, char *argv[]) {
     }
 
     KmerMultiplicityCounter kmcounter(k, output);
-    kmcounter.CombineMultiplicities(input_files, min_samples, min_mult, work_dir, nthreads);
+    kmcounter.CombineMultiplicities(input_files, min_samples, min_mult, work_dir, max_memory << 30, nthreads);
     return 0;
 }
@@ -160,7 +160,7 @@ namespace online_visualization {
             " For example:\n" +
             "> load GraphSimplified data/saves/simplification\n" +
             " would load a new environment with the name `GraphSimplified` from the files\n" +
-            " in the folder `data/saves/simplification/` with the basename `graph_pack` (graph_pack.grseq, e.t.c).";
+            " in the folder `data/saves/simplification/` with the basename `graph_pack` (graph_pack.grpk, e.t.c).";
           return answer;
         }
 
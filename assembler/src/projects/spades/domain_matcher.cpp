@@ -22,6 +22,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,15 +34,29 @@ extern "C" {
 
 namespace nrps {
 
-static void match_contigs_internal(hmmer::HMMMatcher &matcher, const path_extend::BidirectionalPath &path,
-                                   const std::string &path_string,
+// Contig path with its sequence translated in all three frames. Paths are
+// translated once and then matched against every HMM.
+struct TranslatedPath {
+    const path_extend::BidirectionalPath *path;
+    std::string seq;
+    std::array<std::string, 3> names;
+    std::array<std::string, 3> frames;
+};
+
+// Contig matches for a single (HMM, chunk of paths) work item together with
+// the contigs to be written to restricted edges
+struct MatchResult {
+    ContigAlnInfo matches;
+    std::vector<io::SingleRead> contigs;
+};
+
+static void match_contigs_internal(hmmer::HMMMatcher &matcher, const TranslatedPath &tpath,
                                    const std::string &type, const std::string &desc,
-                                   ContigAlnInfo &res, io::OFastaReadStream &oss_contig, size_t model_length) {
-    for (size_t shift = 0; shift < 3; ++shift) {
-        std::string ref_shift = std::to_string(path.GetId()) + "_" + std::to_string(shift);
-        std::string seq_aas = aa::translate(path_string.c_str() + shift);
-        matcher.match(ref_shift.c_str(), seq_aas.c_str());
-    }
+                                   MatchResult &res, size_t model_length) {
+    const path_extend::BidirectionalPath &path = *tpath.path;
+    const std::string &path_string = tpath.seq;
+    for (size_t shift = 0; shift < 3; ++shift)
+        matcher.match(tpath.names[shift].c_str(), tpath.frames[shift].c_str());
     matcher.summarize();
 
     for (const auto &hit : matcher.hits()) {
@@ -61,47 +77,77 @@ static void match_contigs_internal(hmmer::HMMMatcher &matcher, const path_extend
             seqpos.second = seqpos.second * 3  + shift;
 
             std::string name(hit.name());
-#pragma omp critical
-            {
-                oss_contig << io::SingleRead(name, path_string);
-            }
+            res.contigs.emplace_back(name, path_string);
             DEBUG(name);
             DEBUG("First - " << seqpos.first << ", second - " << seqpos.second);
-            res.push_back({name, type, desc,
-                           unsigned(seqpos.first), unsigned(seqpos.second),
-                           path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
+            res.matches.push_back({name, type, desc,
+                                   unsigned(seqpos.first), unsigned(seqpos.second),
+                                   path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
         }
     }
     matcher.reset_top_hits();
 }
 
-static void match_contigs(const path_extend::PathContainer &contig_paths, const path_extend::ScaffoldSequenceMaker &scaffold_maker,
-                          const hmmer::HMM &hmm, const hmmer::hmmer_cfg &cfg,
-                          ContigAlnInfo &res, io::OFastaReadStream &oss_contig) {
-    DEBUG("Total contigs: " << contig_paths.size());
-    DEBUG("Model length - " << hmm.length());
-    hmmer::HMMMatcher matcher(hmm, cfg);
+static void match_contigs(const TranslatedPath *begin, const TranslatedPath *end,
+                          hmmer::HMMMatcher &matcher, const hmmer::HMM &hmm,
+                          MatchResult &res) {
+    for (const TranslatedPath *tpath = begin; tpath != end; ++tpath)
+        match_contigs_internal(matcher, *tpath,
+                               hmm.name(), hmm.desc() ? hmm.desc() : "",
+                               res, hmm.length());
+}
+
+static std::vector<TranslatedPath> TranslatePaths(const path_extend::PathContainer &contig_paths,
+                                                  const path_extend::ScaffoldSequenceMaker &scaffold_maker) {
+    // Keep the order of the sequential walk: path followed by its conjugate,
+    // the latter is skipped if the path itself is empty
+    std::vector<const path_extend::BidirectionalPath*> paths;
     for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
-        const path_extend::BidirectionalPath &path = iter.get();
-        if (path.Length() <= 0)
+        if (iter.get().Length() <= 0)
             continue;
+        paths.push_back(&iter.get());
 
-        std::string path_string = scaffold_maker.MakeSequence(path);
-        match_contigs_internal(matcher, path, path_string,
-                               hmm.name(), hmm.desc() ? hmm.desc() : "",
-                               res, oss_contig, hmm.length());
-
-        const path_extend::BidirectionalPath& conj_path = iter.getConjugate();
-        if (conj_path.Length() <= 0)
+        if (iter.getConjugate().Length() <= 0)
             continue;
+        paths.push_back(&iter.getConjugate());
+    }
 
-        std::string path_string_conj = scaffold_maker.MakeSequence(conj_path);
-        match_contigs_internal(matcher, conj_path, path_string_conj,
-                               hmm.name(), hmm.desc() ? hmm.desc() : "",
-                               res, oss_contig, hmm.length());
+    std::vector<TranslatedPath> res(paths.size());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < paths.size(); ++i) {
+        TranslatedPath &tpath = res[i];
+        tpath.path = paths[i];
+        tpath.seq = scaffold_maker.MakeSequence(*paths[i]);
+        for (size_t shift = 0; shift < 3; ++shift) {
+            tpath.names[shift] = std::to_string(paths[i]->GetId()) + "_" + std::to_string(shift);
+            tpath.frames[shift] = aa::translate(tpath.seq.c_str() + shift);
+        }
     }
+
+    return res;
 }
 
+// Splits the paths into chunks of roughly the same total length, so HMMs are
+// matched against chunks independently
+static std::vector<size_t> SplitIntoChunks(const std::vector<TranslatedPath> &paths, size_t chunk_num) {
+    size_t total_length = 0;
+    for (const auto &tpath : paths)
+        total_length += tpath.seq.size();
+
+    size_t chunk_length = std::max<size_t>(total_length / std::max<size_t>(chunk_num, 1), 1);
+    std::vector<size_t> bounds = { 0 };
+    size_t length = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        length += paths[i].seq.size();
+        if (length >= chunk_length && i + 1 < paths.size()) {
+            bounds.push_back(i + 1);
+            length = 0;
+        }
+    }
+    bounds.push_back(paths.size());
+
+    return bounds;
+}
 
 static void ParseHMMFile(std::vector<hmmer::HMM> &hmms, const std::string &filename) {
     auto hmmfile = hmmer::open_file(filename);
@@ -184,24 +230,44 @@ ContigAlnInfo DomainMatcher::MatchDomains(debruijn_graph::GraphPack &gp,
     // Setup E-value search space size
     hcfg.Z = 3 * broken_scaffolds.size();
 
-#   pragma omp parallel for
-    for (size_t i = 0; i < hmms.size(); ++i) {
-        ContigAlnInfo local_res;
-        std::string name = hmms[i].name();
-#       pragma omp critical
-        {
-            INFO("Matching contigs with " << name);
+    std::vector<TranslatedPath> paths = TranslatePaths(broken_scaffolds, scaffold_maker);
+    INFO("Total contig paths: " << paths.size());
+
+    // Work items are (HMM, chunk of paths) pairs scheduled dynamically, so large
+    // profiles do not stay alone at the end. Every thread keeps the matcher of
+    // the HMM it processed last: items of the same HMM go in a row, so it is
+    // usually reused. Results are collected per item and merged in order.
+    size_t nthreads = omp_get_max_threads();
+    std::vector<size_t> bounds = SplitIntoChunks(paths, 4 * nthreads);
+    size_t chunk_num = bounds.size() - 1;
+    std::vector<MatchResult> results(hmms.size() * chunk_num);
+    std::vector<std::unique_ptr<hmmer::HMMMatcher>> matchers(nthreads);
+    std::vector<size_t> matcher_hmms(nthreads, -1ull);
+
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t item = 0; item < results.size(); ++item) {
+        size_t i = item / chunk_num, chunk = item % chunk_num;
+        size_t thread = omp_get_thread_num();
+        if (matcher_hmms[thread] != i) {
+            matchers[thread] = std::make_unique<hmmer::HMMMatcher>(hmms[i], hcfg);
+            matcher_hmms[thread] = i;
         }
 
-        match_contigs(broken_scaffolds, scaffold_maker,
-                      hmms[i], hcfg,
-                      local_res, oss_contig);
+        match_contigs(paths.data() + bounds[chunk], paths.data() + bounds[chunk + 1],
+                      *matchers[thread], hmms[i], results[item]);
+    }
 
-#       pragma omp critical
-        {
-            INFO("Matches for '" << name << "': " << local_res.size());
-            res.insert(res.end(), std::make_move_iterator(local_res.begin()), std::make_move_iterator(local_res.end()));
+    for (size_t i = 0; i < hmms.size(); ++i) {
+        size_t matches = 0;
+        for (size_t chunk = 0; chunk < chunk_num; ++chunk) {
+            MatchResult &local_res = results[i * chunk_num + chunk];
+            matches += local_res.matches.size();
+            for (const auto &contig : local_res.contigs)
+                oss_contig << contig;
+            res.insert(res.end(),
+                       std::make_move_iterator(local_res.matches.begin()), std::make_move_iterator(local_res.matches.end()));
         }
+        INFO("Matches for '" << hmms[i].name() << "': " << matches);
     }
 
     INFO("Total domain matches: " << res.size());
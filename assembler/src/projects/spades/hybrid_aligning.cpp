@@ -297,8 +297,9 @@ void PacbioAlignLibrary(const Graph &graph,
             (lib.type() == io::LibraryType::PacBioReads ?
              alignment::BWAIndex::AlignmentMode::PacBio : alignment::BWAIndex::AlignmentMode::Ont2D);
 
-    // Initialize index
-    sensitive_aligner::GAligner galigner(graph, pb, mode);
+    // Initialize index, it is cached along with the checkpoints
+    std::string index_dir = (cfg::get().checkpoints != config::Checkpoints::None ? cfg::get().output_saves : "");
+    sensitive_aligner::GAligner galigner(graph, pb, mode, index_dir);
 
     PacbioAligner aligner(galigner, path_storage, gap_storage);
 
@@ -373,6 +374,8 @@ void HybridLibrariesAligning::run(GraphPack& gp, const char*) {
                 INFO("Finished processing long reads from lib " << lib_id);
                 gp.get_mutable<EdgeIndex<Graph>>().Detach();
             }
+            INFO(path_storage.size() << " paths of library #" << lib_id << " take "
+                 << path_storage.mem_size() / 1024 / 1024 << " Mb");
 
             bool rtype = lib.is_long_read_lib();
             if (make_additional_saves) {
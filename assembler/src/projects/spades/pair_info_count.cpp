@@ -12,6 +12,7 @@
 #include "paired_info/pair_info_filler.hpp"
 
 #include "modules/alignment/long_read_mapper.hpp"
+#include "modules/alignment/mapping_cache.hpp"
 #include "modules/alignment/bwa_sequence_mapper.hpp"
 #include "modules/alignment/rna/ss_coverage_filler.hpp"
 
@@ -31,24 +32,47 @@ using SequencingLib = io::SequencingLibrary<config::LibraryData>;
 using PairedInfoFilter = bf::counting_bloom_filter<std::pair<EdgeId, EdgeId>, 2>;
 using EdgePairCounter = hll::hll_with_hasher<std::pair<EdgeId, EdgeId>>;
 
+// BWA indices are cached along with the checkpoints
+std::string BWAIndexDir() {
+    return cfg::get().checkpoints != config::Checkpoints::None ? cfg::get().output_saves : "";
+}
+
 std::shared_ptr<SequenceMapper<Graph>> ChooseProperMapper(const GraphPack& gp,
                                                           const SequencingLib& library) {
     const auto &graph = gp.get<Graph>();
 
     if (library.type() == io::LibraryType::MatePairs) {
         INFO("Mapping mate-pairs using BWA-mem mapper");
-        return std::make_shared<alignment::BWAReadMapper<Graph>>(graph);
+        return std::make_shared<alignment::BWAReadMapper<Graph>>(graph, alignment::BWAIndex::AlignmentMode::Default,
+                                                                  BWAIndexDir());
     }
 
     if (library.data().unmerged_read_length < gp.k() && library.type() == io::LibraryType::PairedEnd) {
         INFO("Mapping PE reads shorter than K with BWA-mem mapper");
-        return std::make_shared<alignment::BWAReadMapper<Graph>>(graph);
+        return std::make_shared<alignment::BWAReadMapper<Graph>>(graph, alignment::BWAIndex::AlignmentMode::Default,
+                                                                  BWAIndexDir());
     }
 
     INFO("Selecting usual mapper");
     return MapperInstance(gp);
 }
 
+// The mapper is built only if the reads are to be mapped, e.g. no BWA index is needed
+// to replay the cached mappings
+void ProcessLibrary(SequenceMapperNotifier &notifier, io::BinaryPairedStreams &streams,
+                    size_t ilib, const GraphPack &gp, const SequencingLib &library, MappingCache *cache) {
+    if (cache && cache->recorded()) {
+        notifier.ProcessLibrary(streams, ilib, *cache);
+        return;
+    }
+
+    auto mapper = ChooseProperMapper(gp, library);
+    if (cache)
+        notifier.ProcessLibrary(streams, ilib, *mapper, *cache);
+    else
+        notifier.ProcessLibrary(streams, ilib, *mapper);
+}
+
 class DEFilter : public SequenceMapperListener {
   public:
     DEFilter(PairedInfoFilter &filter, const Graph &g)
@@ -198,7 +222,8 @@ bool ShouldObtainSingleReadsPaths(size_t ilib) {
 
 bool CollectLibInformation(const GraphPack &gp,
                            size_t &edgepairs,
-                           size_t ilib, size_t edge_length_threshold) {
+                           size_t ilib, size_t edge_length_threshold,
+                           MappingCache *cache) {
     INFO("Estimating insert size (takes a while)");
     InsertSizeCounter hist_counter(gp.get<Graph>(), edge_length_threshold);
     EdgePairCounterFiller pcounter(cfg::get().max_threads);
@@ -212,7 +237,7 @@ bool CollectLibInformation(const GraphPack &gp,
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
                                                 /*include_merged*/true);
 
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    ProcessLibrary(notifier, paired_streams, ilib, gp, reads, cache);
     //Check read length after lib processing since mate pairs a not used until this step
     VERIFY(reads.data().unmerged_read_length != 0);
 
@@ -278,6 +303,8 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
         notifier.ProcessLibrary(single_streams, ilib, *mapper_ptr);
     }
 
+    INFO(single_long_reads.size() << " paths of library #" << ilib << " take "
+         << single_long_reads.mem_size() / 1024 / 1024 << " Mb");
     return single_long_reads.size();
 }
 
@@ -285,7 +312,7 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
 void ProcessPairedReads(GraphPack &gp,
                                std::unique_ptr<PairedInfoFilter> filter,
                                unsigned filter_threshold,
-                               size_t ilib) {
+                               size_t ilib, MappingCache *cache) {
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     const auto &data = reads.data();
 
@@ -320,7 +347,7 @@ void ProcessPairedReads(GraphPack &gp,
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
                                                 /*include merged*/true);
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    ProcessLibrary(notifier, paired_streams, ilib, gp, reads, cache);
 }
 
 } // namespace
@@ -352,8 +379,14 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
                 size_t rl = lib_data.unmerged_read_length;
                 size_t k = cfg::get().K;
 
+                // Paired reads are mapped up to three times below, map them only once if asked to
+                std::unique_ptr<MappingCache> mapping_cache;
+                if (cfg::get().cache_read_mappings)
+                    mapping_cache = std::make_unique<MappingCache>(fs::tmp::make_temp_dir(cfg::get().tmp_dir, "mappings"),
+                                                                   lib_data.binary_reads_info.chunk_num);
+
                 size_t edgepairs = 0;
-                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold)) {
+                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold, mapping_cache.get())) {
                     cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
                     WARN("Unable to estimate insert size for paired library #" << i);
                     if (rl > 0 && rl <= k) {
@@ -395,14 +428,14 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                         VERIFY(lib.data().unmerged_read_length != 0);
                         auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
-                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
+                        ProcessLibrary(notifier, reads, i, gp, lib, mapping_cache.get());
                     }
                 }
 
                 INFO("Mapping library #" << i);
                 if (lib.data().mean_insert_size != 0.0) {
                     INFO("Mapping paired reads (takes a while) ");
-                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i);
+                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i, mapping_cache.get());
                 }
             }
 
@@ -113,6 +113,7 @@ class LongReadsAligner {
         auto read_stream = io::FixingWrapper(io::FileReadStream(cfg_.path_to_sequences));
         size_t n = 0;
         size_t buffer_no = 0;
+        utils::perf_counter total_pc;
         while (!read_stream.eof()) {
             std::vector<io::SingleRead> read_buffer;
             read_buffer.reserve(read_buffer_size);
@@ -122,15 +123,23 @@ class LongReadsAligner {
                 read_buffer.push_back(move(read));
             }
             INFO("Prepared batch " << buffer_no << " of " << read_buffer.size() << " reads.");
+            utils::perf_counter pc;
             AlignBatch(read_buffer);
+            ReportThroughput("Batch " + std::to_string(buffer_no), read_buffer.size(), pc.time());
             ++buffer_no;
             n += read_buffer.size();
             INFO("Processed " << n << " reads");
         }
+        ReportThroughput("Total", n, total_pc.time());
     }
 
   private:
 
+    void ReportThroughput(const std::string &what, size_t reads, double seconds) const {
+        INFO(what << ": aligned " << reads << " reads in " << utils::human_readable_time(seconds) <<
+             " (" << size_t(double(reads) / std::max(seconds, 1e-3)) << " reads/s)");
+    }
+
     OneReadMapping AlignRead(const io::SingleRead &read) const {
         DEBUG("Read " << read.name() << ". Current Read")
         utils::perf_counter pc;
@@ -6,7 +6,7 @@
 //***************************************************************************
 
 #include "profile_storage.hpp"
-#include "io/dataset_support/dataset_readers.hpp"
+#include "io/dataset_support/read_converter.hpp"
 #include "modules/alignment/kmer_mapper.hpp"
 #include "modules/alignment/sequence_mapper.hpp"
 
@@ -24,7 +24,6 @@
 
 #include <clipp/clipp.h>
 #include <unordered_map>
-#include <numeric>
 #include <sys/types.h>
 
 using namespace debruijn_graph;
@@ -32,25 +31,9 @@ using namespace debruijn_graph;
 typedef io::DataSet<config::LibraryData> DataSet;
 typedef io::SequencingLibrary<config::LibraryData> SequencingLib;
 
-static io::ReadStreamList<io::SingleRead>
-single_easy_readers_for_libs(DataSet& dataset_info,
-                             const std::vector<size_t>& libs,
-                             bool followed_by_rc = true,
-                             bool including_paired_reads = true,
-                             bool handle_Ns = true,
-                             io::OffsetType offset_type = io::PhredOffset) {
-    VERIFY(!libs.empty());
-    io::ReadStreamList<io::SingleRead> streams;
-    for (auto l_id : libs) {
-        streams.push_back(io::single_easy_reader(dataset_info[l_id],
-                                             followed_by_rc,
-                                             including_paired_reads, handle_Ns, offset_type));
-    }
-    return streams;
-}
-
 static void Run(const std::string &graph_path, const std::string &dataset_desc, size_t K,
-         const std::string &profiles_fn, size_t nthreads, const std::string &tmpdir) {
+         const std::string &profiles_fn, const std::string &binary_profiles_fn,
+         size_t nthreads, const std::string &tmpdir) {
     DataSet dataset;
     dataset.load(dataset_desc);
 
@@ -67,19 +50,28 @@ static void Run(const std::string &graph_path, const std::string &dataset_desc,
 
     gp.EnsureBasicMapping();
 
-    std::vector<size_t> libs(dataset.lib_count());
-    std::iota(libs.begin(), libs.end(), 0);
-
-    auto single_readers = single_easy_readers_for_libs(dataset, libs,
-            /*followed by rc*/true, /*including paired*/true);
+    // Binary reads are split into chunks, so every sample could be mapped by several threads
+    io::ConvertIfNeeded(dataset, unsigned(nthreads));
 
     size_t sample_cnt = dataset.lib_count();
+    std::vector<io::BinarySingleStreams> sample_readers;
+    for (size_t i = 0; i < sample_cnt; ++i)
+        sample_readers.push_back(io::single_binary_readers(dataset[i],
+                                                           /*followed by rc*/true, /*including paired*/true));
+
     debruijn_graph::coverage_profiles::EdgeProfileStorage profile_storage(graph, sample_cnt);
 
-    profile_storage.Fill(single_readers, *MapperInstance(gp));
+    INFO("Computing profiles for " << sample_cnt << " samples");
+    profile_storage.Fill(sample_readers, *MapperInstance(gp));
 
     std::ofstream os(profiles_fn);
     profile_storage.Save(os, label_helper.edge_naming_f());
+
+    if (!binary_profiles_fn.empty()) {
+        INFO("Saving binary profiles to " << binary_profiles_fn);
+        std::ofstream bos(binary_profiles_fn, std::ios::binary);
+        profile_storage.SaveBinary(bos, label_helper.edge_naming_f());
+    }
 }
 
 struct gcfg {
@@ -93,6 +85,7 @@ struct gcfg {
     std::string graph;
     std::string tmpdir;
     std::string outfile;
+    std::string binary_outfile;
     unsigned nthreads;
 };
 
@@ -105,7 +98,8 @@ static void process_cmdline(int argc, char **argv, gcfg &cfg) {
       cfg.outfile << value("output filename"),
       (option("-k") & integer("value", cfg.k)) % "k-mer length to use",
       (option("-t", "--threads") & integer("value", cfg.nthreads)) % "# of threads to use",
-      (option("--tmpdir") & value("dir", cfg.tmpdir)) % "scratch directory to use"
+      (option("--tmpdir") & value("dir", cfg.tmpdir)) % "scratch directory to use",
+      (option("--binary") & value("file", cfg.binary_outfile)) % "also save profiles as a binary matrix (could be mmapped)"
   );
 
   auto result = parse(argc, argv, cli);
@@ -138,7 +132,7 @@ int main(int argc, char** argv) {
         omp_set_num_threads((int) nthreads);
         INFO("# of threads to use: " << nthreads);
 
-        Run(cfg.graph, cfg.file, k, cfg.outfile, nthreads, tmpdir);
+        Run(cfg.graph, cfg.file, k, cfg.outfile, cfg.binary_outfile, nthreads, tmpdir);
     } catch (const std::string &s) {
         std::cerr << s << std::endl;
         return EINTR;
@@ -7,37 +7,40 @@
 
 #include "profile_storage.hpp"
 
+#include <unordered_set>
+
 namespace debruijn_graph {
 namespace coverage_profiles {
 
 void EdgeProfileStorage::HandleDelete(EdgeId e) {
-    profiles_.erase(e);
+    size_t *row = Row(e);
+    std::fill(row, row + sample_cnt_, 0);
 }
 
 void EdgeProfileStorage::HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) {
     RawAbundanceVector total(sample_cnt_, 0);
     for (EdgeId e : old_edges) {
-        Add(total, utils::get(profiles_, e));
+        Add(total, Raw(e));
     }
-    profiles_[new_edge] = std::move(total);
+    SetRaw(new_edge, total);
 }
 
 void EdgeProfileStorage::HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
-    RawAbundanceVector total(utils::get(profiles_, edge1));
-    Add(total, utils::get(profiles_, edge2));
-    profiles_[new_edge] = std::move(total);
+    RawAbundanceVector total(Raw(edge1));
+    Add(total, Raw(edge2));
+    SetRaw(new_edge, total);
 }
 
 void EdgeProfileStorage::HandleSplit(EdgeId old_edge, EdgeId new_edge1, EdgeId new_edge2) {
     AbundanceVector abund = profile(old_edge);
     if (old_edge == g().conjugate(old_edge)) {
         RawAbundanceVector raw1 = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge1] = raw1;
-        profiles_[g().conjugate(new_edge1)] = std::move(raw1);
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        SetRaw(new_edge1, raw1);
+        SetRaw(g().conjugate(new_edge1), raw1);
+        SetRaw(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)));
     } else {
-        profiles_[new_edge1] = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        SetRaw(new_edge1, MultiplyEscapeZero(abund, g().length(new_edge1)));
+        SetRaw(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)));
     }
 }
 
@@ -49,11 +52,40 @@ void EdgeProfileStorage::Save(std::ostream &os, const io::EdgeNamingF<Graph> &ed
         std::copy(prof.begin(), prof.end(), std::ostream_iterator<double>(os, "\t"));
         os << '\n';
     }
+    os.flush();
+    CHECK_FATAL_ERROR(os, "Failed to write profiles");
+}
+
+void EdgeProfileStorage::SaveBinary(std::ostream &os, const io::EdgeNamingF<Graph> &edge_namer) const {
+    std::vector<EdgeId> edges;
+    for (auto it = g().ConstEdgeBegin(true); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+
+    const char magic[8] = "EPROFv1";
+    os.write(magic, sizeof(magic));
+    uint64_t edge_cnt = edges.size(), sample_cnt = sample_cnt_;
+    os.write(reinterpret_cast<const char*>(&edge_cnt), sizeof(edge_cnt));
+    os.write(reinterpret_cast<const char*>(&sample_cnt), sizeof(sample_cnt));
+
+    for (EdgeId e : edges) {
+        auto prof = profile(e);
+        os.write(reinterpret_cast<const char*>(prof.data()), prof.size() * sizeof(double));
+    }
+
+    for (EdgeId e : edges) {
+        std::string name = edge_namer(g(), e);
+        uint64_t len = name.size();
+        os.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        os.write(name.data(), name.size());
+    }
+    os.flush();
+    CHECK_FATAL_ERROR(os, "Failed to write binary profiles");
 }
 
 void EdgeProfileStorage::Load(std::istream &is,
                               const io::EdgeLabelHelper<Graph> &label_helper,
                               bool check_consistency) {
+    std::unordered_set<EdgeId> loaded;
     std::string s;
     while (std::getline(is, s)) {
         std::istringstream ss(s);
@@ -61,14 +93,16 @@ void EdgeProfileStorage::Load(std::istream &is,
         ss >> label;
         EdgeId e = label_helper.edge(label);
         auto p = MultiplyEscapeZero(LoadAbundanceVector(ss), g().length(e));
-        profiles_[e] = p;
-        profiles_[g().conjugate(e)] = std::move(p);
+        SetRaw(e, p);
+        SetRaw(g().conjugate(e), p);
+        loaded.insert(e);
+        loaded.insert(g().conjugate(e));
     }
 
     if (check_consistency) {
         for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
             EdgeId e = *it;
-            CHECK_FATAL_ERROR(profiles_.count(e) > 0, "Failed to load profile for one of the edges");
+            CHECK_FATAL_ERROR(loaded.count(e) > 0, "Failed to load profile for one of the edges");
         }
     }
 }
@@ -8,21 +8,54 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
 #include "toolchain/edge_label_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace debruijn_graph {
 namespace coverage_profiles {
 
 //TODO always working with doubles seems easier and more correct
+// Raw profiles are kept in a dense edge-by-sample matrix, row per edge int id
 class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
     typedef Graph::EdgeId EdgeId;
     typedef Graph::VertexId VertexId;
     typedef std::vector<size_t> RawAbundanceVector;
     typedef std::vector<double> AbundanceVector;
 
+    // Coverage of the edges by the reads of a single sample collected by a
+    // thread. Only the touched edges are flushed into the matrix.
+    struct Shard {
+        RawAbundanceVector coverage;
+        std::vector<size_t> touched;
+    };
+
     size_t sample_cnt_;
-    std::unordered_map<EdgeId, RawAbundanceVector> profiles_;
+    RawAbundanceVector profiles_;
+
+    size_t *Row(EdgeId e) {
+        size_t id = e.int_id();
+        if ((id + 1) * sample_cnt_ > profiles_.size())
+            profiles_.resize(std::max((id + 1) * sample_cnt_, 2 * profiles_.size()), 0);
+        return &profiles_[id * sample_cnt_];
+    }
+
+    const size_t *Row(EdgeId e) const {
+        size_t id = e.int_id();
+        VERIFY_MSG((id + 1) * sample_cnt_ <= profiles_.size(), "No profile for edge " << id);
+        return &profiles_[id * sample_cnt_];
+    }
+
+    RawAbundanceVector Raw(EdgeId e) const {
+        const size_t *row = Row(e);
+        return RawAbundanceVector(row, row + sample_cnt_);
+    }
+
+    void SetRaw(EdgeId e, const RawAbundanceVector &p) {
+        std::copy(p.begin(), p.end(), Row(e));
+    }
 
     AbundanceVector Normalize(const RawAbundanceVector &p, size_t length) const {
         AbundanceVector answer(sample_cnt_);
@@ -58,32 +91,59 @@ class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
     }
 
     template<class SingleStream, class Mapper>
-    void Fill(SingleStream &reader, size_t stream_id, const Mapper &mapper) {
+    void Fill(SingleStream &reader, Shard &shard, const Mapper &mapper) const {
         typename SingleStream::ReadT read;
         while (!reader.eof()) {
             reader >> read;
 
             for (const auto &e_mr: mapper.MapSequence(read.sequence())) {
-                profiles_[e_mr.first][stream_id] += e_mr.second.mapped_range.size();
+                size_t id = e_mr.first.int_id();
+                if (!shard.coverage[id])
+                    shard.touched.push_back(id);
+                shard.coverage[id] += e_mr.second.mapped_range.size();
             }
         }
     };
 
+    void Flush(Shard &shard, size_t sample_id) {
+        for (size_t id : shard.touched) {
+#           pragma omp atomic
+            profiles_[id * sample_cnt_ + sample_id] += shard.coverage[id];
+            shard.coverage[id] = 0;
+        }
+        shard.touched.clear();
+    }
+
 public:
     EdgeProfileStorage(const Graph &g, size_t sample_cnt) :
             omnigraph::GraphActionHandler<Graph>(g, "EdgeProfileStorage"),
             sample_cnt_(sample_cnt) {}
 
+    // Every sample is given by a list of streams (e.g. chunks of binary reads).
+    // Reads of all the samples are mapped concurrently, (sample, stream) pairs
+    // being the units of work.
     template<class SingleStreamList, class Mapper>
-    void Fill(SingleStreamList &streams, const Mapper &mapper) {
-        //Initialize profiles
-        for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
-            profiles_[*it] = RawAbundanceVector(sample_cnt_, 0);
-        }
+    void Fill(std::vector<SingleStreamList> &samples, const Mapper &mapper) {
+        VERIFY(samples.size() == sample_cnt_);
+        size_t edge_id_bound = g().max_eid() + 1;
+        profiles_.assign(edge_id_bound * sample_cnt_, 0);
 
-#       pragma omp parallel for
+        std::vector<std::pair<size_t, size_t>> streams;
         for (size_t i = 0; i < sample_cnt_; ++i) {
-            Fill(streams[i], i, mapper);
+            for (size_t j = 0; j < samples[i].size(); ++j)
+                streams.emplace_back(i, j);
+        }
+
+        std::vector<Shard> shards(omp_get_max_threads());
+#       pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < streams.size(); ++i) {
+            Shard &shard = shards[omp_get_thread_num()];
+            if (shard.coverage.empty())
+                shard.coverage.resize(edge_id_bound, 0);
+
+            size_t sample_id = streams[i].first;
+            Fill(samples[sample_id][streams[i].second], shard, mapper);
+            Flush(shard, sample_id);
         }
     }
 
@@ -92,7 +152,7 @@ public:
     }
 
     AbundanceVector profile(EdgeId e) const {
-        return Normalize(utils::get(profiles_, e), g().length(e));
+        return Normalize(Raw(e), g().length(e));
     }
 
     void HandleDelete(EdgeId e) override;
@@ -106,6 +166,14 @@ public:
     void Save(std::ostream &os,
               const io::EdgeNamingF<Graph> &edge_namer = io::IdNamingF<Graph>()) const;
 
+    // Saves the profiles of the canonical edges in binary form, so the matrix
+    // could be mmapped. Layout (little endian):
+    //   char[8] magic "EPROFv1\0", uint64 edge count N, uint64 sample count M,
+    //   N x M doubles (row per edge, same order as Save), then N edge names,
+    //   each as uint64 length followed by the characters.
+    void SaveBinary(std::ostream &os,
+                    const io::EdgeNamingF<Graph> &edge_namer = io::IdNamingF<Graph>()) const;
+
     //TODO maybe pass EdgeDereferenceF?
     void Load(std::istream &is,
               const io::EdgeLabelHelper<Graph> &label_helper,
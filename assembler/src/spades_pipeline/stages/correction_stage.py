@@ -29,7 +29,7 @@ def prepare_config_corr(filename, cfg, ext_python_modules_home):
     data["dataset"] = cfg.dataset
     data["output_dir"] = cfg.output_dir
     data["work_dir"] = cfg.tmp_dir
-    # data["hard_memory_limit"] = cfg.max_memory
+    data["max_memory"] = cfg.max_memory
     data["max_nthreads"] = cfg.max_threads
     data["bwa"] = cfg.bwa
     with open(filename, 'w') as file_c:
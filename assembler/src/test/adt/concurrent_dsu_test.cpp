@@ -0,0 +1,54 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/concurrent_dsu.hpp"
+
+#include <random>
+#include <vector>
+
+#include <omp.h>
+
+#include <gtest/gtest.h>
+
+TEST(ConcurrentDSU, UniteIfRespectsSizeCap) {
+    const size_t n = 200000, cap = 50, nthreads = 8;
+    dsu::ConcurrentDSU uf(n);
+
+#   pragma omp parallel num_threads(nthreads)
+    {
+        std::mt19937_64 rnd(omp_get_thread_num());
+        std::uniform_int_distribution<size_t> dist(0, n - 1);
+#       pragma omp for
+        for (size_t i = 0; i < 4 * n; ++i) {
+            // Pick close elements, so that threads compete for the same sets
+            size_t x = dist(rnd), y = std::min(n - 1, x + dist(rnd) % 64);
+            uf.unite_if(x, y, [&](size_t szx, size_t szy) { return szx + szy <= cap; });
+        }
+    }
+
+    std::vector<std::vector<size_t>> sets;
+    uf.get_sets(sets);
+    size_t total = 0, full = 0;
+    for (const auto &set : sets) {
+        ASSERT_LE(set.size(), cap);
+        ASSERT_EQ(set.size(), uf.set_size(set.front()));
+        total += set.size();
+        full += set.size() == cap;
+    }
+    EXPECT_EQ(n, total);
+    EXPECT_EQ(sets.size(), uf.num_sets());
+    EXPECT_GT(full, 0);
+}
+
+TEST(ConcurrentDSU, UniteIfRejects) {
+    dsu::ConcurrentDSU uf(4);
+    EXPECT_TRUE(uf.unite_if(0, 1, [](size_t, size_t) { return true; }));
+    EXPECT_FALSE(uf.unite_if(0, 1, [](size_t, size_t) { return true; }));
+    EXPECT_FALSE(uf.unite_if(1, 2, [](size_t szx, size_t szy) { return szx + szy <= 2; }));
+    EXPECT_TRUE(uf.unite_if(2, 3, [](size_t szx, size_t szy) { return szx + szy <= 2; }));
+    EXPECT_EQ(2, uf.num_sets());
+    EXPECT_EQ(2, uf.set_size(3));
+}
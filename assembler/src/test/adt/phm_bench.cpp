@@ -0,0 +1,152 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares scalar and batched lookups in perfect hash maps.
+// Usage: phm_bench [# of k-mers] [working dir]
+
+#include "utils/ph_map/perfect_hash_map_builder.hpp"
+#include "utils/kmer_mph/kmer_splitter.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+#include "sequence/rtseq.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Map = utils::PerfectHashMap<RtSeq, uint32_t>;
+
+static const unsigned BENCH_K = 31;
+
+// k-mers are generated from their numbers, so there is no need to keep them all
+static RtSeq KMer(uint64_t i) {
+    // splitmix64
+    uint64_t z = i + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return RtSeq(BENCH_K, &z);
+}
+
+class RandomKMerSplitter : public kmers::KMerSortingSplitter<RtSeq> {
+    size_t n_;
+
+  public:
+    RandomKMerSplitter(const std::string &work_dir, size_t n)
+            : KMerSortingSplitter<RtSeq>(work_dir, BENCH_K), n_(n) {}
+
+    RawKMers Split(size_t num_files, unsigned nthreads) override {
+        auto out = PrepareBuffers(num_files, nthreads, 0);
+
+        // Every thread generates its own slice of k-mers
+        std::vector<size_t> pos(nthreads);
+        for (unsigned i = 0; i < nthreads; ++i)
+            pos[i] = n_ * i / nthreads;
+
+        bool done = false;
+        while (!done) {
+#           pragma omp parallel for num_threads(nthreads)
+            for (unsigned i = 0; i < nthreads; ++i) {
+                size_t end = n_ * (i + 1) / nthreads;
+                while (pos[i] < end)
+                    if (push_back_internal(KMer(pos[i]++), omp_get_thread_num()))
+                        break;
+            }
+            DumpBuffers(out);
+
+            done = true;
+            for (unsigned i = 0; i < nthreads; ++i)
+                done &= (pos[i] == n_ * (i + 1) / nthreads);
+        }
+        ClearBuffers();
+
+        return out;
+    }
+};
+
+static uint64_t NextQuery(uint64_t &state, size_t n) {
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state % n;
+}
+
+static uint64_t Scalar(const Map &map, size_t n, size_t queries) {
+    uint64_t state = 42, sum = 0;
+    for (size_t i = 0; i < queries; ++i) {
+        auto kwh = map.ConstructKWH(KMer(NextQuery(state, n)));
+        if (map.valid(kwh))
+            sum += map.get_raw_value_reference(kwh);
+    }
+
+    return sum;
+}
+
+static uint64_t Batched(const Map &map, size_t n, size_t queries, size_t batch) {
+    uint64_t state = 42, sum = 0;
+    std::vector<Map::KeyWithHash> kwhs;
+    for (size_t i = 0; i < queries; i += batch) {
+        kwhs.clear();
+        for (size_t j = i; j < std::min(i + batch, queries); ++j)
+            kwhs.push_back(map.ConstructKWH(KMer(NextQuery(state, n))));
+
+        map.ResolveBatch(kwhs.data(), kwhs.size());
+        for (const auto &kwh : kwhs)
+            if (map.valid(kwh))
+                sum += map.get_raw_value_reference(kwh);
+    }
+
+    return sum;
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+
+    size_t n = (argc > 1 ? std::stoull(argv[1]) : 10000000);
+    std::string workdir = (argc > 2 ? argv[2] : ".");
+    unsigned nthreads = omp_get_max_threads();
+
+    Map map(BENCH_K);
+    {
+        kmers::KMerDiskCounter<RtSeq> counter(workdir, RandomKMerSplitter(workdir, n));
+        auto storage = utils::PerfectHashMapBuilder().BuildIndex(map, counter, 16 * nthreads, nthreads);
+        n = storage.total_kmers();
+        INFO("Built map of " << n << " k-mers");
+
+        // Number values, so the sums of scalar and batched lookups could be compared
+#       pragma omp parallel for num_threads(nthreads)
+        for (size_t i = 0; i < storage.num_buckets(); ++i)
+            for (auto it = storage.bucket_begin(i), end = storage.bucket_end(i); it != end; ++it) {
+                auto kwh = map.ConstructKWH(RtSeq(BENCH_K, it->first));
+                map.get_raw_value_reference(kwh) = uint32_t(kwh.idx());
+            }
+    }
+
+    size_t queries = 2 * n;
+    utils::perf_counter pc;
+    uint64_t expected = Scalar(map, n, queries);
+    double scalar = (double) queries / pc.time();
+    std::cout << "scalar: " << scalar << " lookups/s" << std::endl;
+
+    for (size_t batch : { 16, 64, 256 }) {
+        pc.reset();
+        uint64_t sum = Batched(map, n, queries, batch);
+        double batched = (double) queries / pc.time();
+        std::cout << "batched (" << batch << "): " << batched << " lookups/s, "
+                  << batched / scalar << "x" << (sum == expected ? "" : " MISMATCH") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+
+#include "graphio.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace debruijn_graph;
+
+namespace {
+
+struct DijkstraResult {
+    std::vector<VertexId> processed;
+    std::vector<std::pair<VertexId, size_t>> distances;
+};
+
+template<class Storage>
+DijkstraResult RunBounded(const Graph &g, VertexId start, size_t length_bound) {
+    auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra<Storage>(g, length_bound, 1000);
+    dijkstra.Run(start);
+
+    DijkstraResult res;
+    res.processed = dijkstra.ProcessedVertices();
+    for (VertexId v : dijkstra.ReachedVertices())
+        res.distances.emplace_back(v, dijkstra.GetDistance(v));
+    std::sort(res.distances.begin(), res.distances.end());
+    return res;
+}
+
+// Both storages should give the same distances and process vertices in the same order
+void CompareStorages(const Graph &g) {
+    for (VertexId v : g) {
+        for (size_t length_bound : { 0, 100, 1000, 100000 }) {
+            auto hashed = RunBounded<omnigraph::HashedDijkstraStorage<Graph>>(g, v, length_bound);
+            auto dense = RunBounded<omnigraph::DenseDijkstraStorage<Graph>>(g, v, length_bound);
+            ASSERT_FALSE(hashed.processed.empty());
+            EXPECT_EQ(hashed.processed, dense.processed) << "vertex " << v << ", bound " << length_bound;
+            EXPECT_EQ(hashed.distances, dense.distances) << "vertex " << v << ", bound " << length_bound;
+        }
+    }
+}
+
+}
+
+TEST( Dijkstra, DenseStorageMatchesHashed ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+    CompareStorages(g);
+}
+
+TEST( Dijkstra, DenseWorkspaceReusedOnSmallerGraph ) {
+    typedef omnigraph::DijkstraWorkspace<Graph> Workspace;
+
+    const Workspace *workspace;
+    size_t vertices;
+    {
+        Graph g(55);
+        ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+        CompareStorages(g);
+        vertices = g.size();
+        workspace = Workspace::Acquire().get();
+    }
+
+    // The workspace of the last run returns to the pool and is leased again
+    EXPECT_EQ(workspace, Workspace::Acquire().get());
+
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    ASSERT_LT(g.size(), vertices);
+    CompareStorages(g);
+    EXPECT_EQ(workspace, Workspace::Acquire().get());
+}
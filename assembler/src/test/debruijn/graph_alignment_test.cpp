@@ -9,11 +9,15 @@
 
 #include "modules/alignment/sequence_mapper.hpp"
 #include "modules/alignment/pacbio/g_aligner.hpp"
+#include "modules/alignment/bwa_index.hpp"
 
 #include "io/reads/io_helper.hpp"
 #include "edlib/edlib.h"
 
 #include "graphio.hpp"
+#include "tmp_folder_fixture.hpp"
+
+#include "utils/filesystem/glob.hpp"
 
 #include <gtest/gtest.h>
 
@@ -196,3 +200,60 @@ TEST(GraphAligner, DijkstraGrowEndsTest ) {
     int score = ends_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
 }
+
+class BWAIndexCache : public ::testing::Test, public TmpFolderFixture {};
+
+TEST_F(BWAIndexCache, LoadedIndexAlignsTheSame) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    // The index is kept in memory only while used, so the next one is read from disk
+    std::vector<omnigraph::MappingPath<EdgeId>> expected;
+    {
+        alignment::BWAIndex built(g, alignment::BWAIndex::AlignmentMode::Default, tmp_folder());
+        for (EdgeId e : g.edges())
+            expected.push_back(built.AlignSequence(g.EdgeNucls(e)));
+    }
+    EXPECT_EQ(1, fs::glob(fs::append_path(tmp_folder(), "bwa_*.bwt")).size());
+    alignment::BWAIndex loaded(g, alignment::BWAIndex::AlignmentMode::Default, tmp_folder());
+
+    size_t mapped = 0, i = 0;
+    for (EdgeId e : g.edges()) {
+        auto actual = loaded.AlignSequence(g.EdgeNucls(e));
+        const auto &exp = expected[i++];
+        ASSERT_EQ(exp.size(), actual.size());
+        for (size_t j = 0; j < exp.size(); ++j) {
+            EXPECT_EQ(exp.edge_at(j), actual.edge_at(j));
+            EXPECT_EQ(exp.mapping_at(j).initial_range, actual.mapping_at(j).initial_range);
+            EXPECT_EQ(exp.mapping_at(j).mapped_range, actual.mapping_at(j).mapped_range);
+        }
+        mapped += (exp.size() > 0);
+    }
+    EXPECT_GT(mapped, 0);
+
+    // The index of another graph replaces the stale one
+    auto stale = fs::glob(fs::append_path(tmp_folder(), "bwa_*"));
+    Graph other(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/iter_unique_path", other);
+    alignment::BWAIndex other_index(other, alignment::BWAIndex::AlignmentMode::Default, tmp_folder());
+    auto current = fs::glob(fs::append_path(tmp_folder(), "bwa_*"));
+    EXPECT_EQ(stale.size(), current.size());
+    for (const auto &file : stale)
+        EXPECT_EQ(current.end(), std::find(current.begin(), current.end(), file));
+
+    // A mismatching index under the name of the graph is rebuilt and saved again
+    std::string bwt = fs::glob(fs::append_path(tmp_folder(), "bwa_*.bwt")).front();
+    std::string prefix = bwt.substr(0, bwt.size() - 4);
+    std::string stale_prefix = stale.front().substr(0, stale.front().rfind('.'));
+    size_t other_size = fs::filesize(bwt);
+    for (const auto &file : current)
+        ASSERT_EQ(0, std::rename(file.c_str(), (stale_prefix + file.substr(prefix.size())).c_str()));
+    {
+        alignment::BWAIndex rebuilt(g, alignment::BWAIndex::AlignmentMode::Default, tmp_folder());
+    }
+    EXPECT_EQ(stale.size(), fs::glob(fs::append_path(tmp_folder(), "bwa_*")).size());
+    EXPECT_NE(other_size, fs::filesize(stale_prefix + ".bwt"));
+    alignment::BWAIndex reloaded(g, alignment::BWAIndex::AlignmentMode::Default, tmp_folder());
+    EXPECT_EQ(expected.front().size(), reloaded.AlignSequence(g.EdgeNucls(*g.edges().begin())).size());
+}
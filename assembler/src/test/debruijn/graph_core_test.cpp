@@ -6,6 +6,7 @@
 
 #include "assembly_graph/core/graph.hpp"
 
+#include <memory>
 #include <vector>
 #include <set>
 #include <string>
@@ -106,3 +107,165 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+class EventLogger : public omnigraph::GraphActionHandler<Graph> {
+    bool deferrable_;
+
+public:
+    std::vector<std::string> log;
+
+    EventLogger(const Graph &g, bool deferrable)
+            : omnigraph::GraphActionHandler<Graph>(g, "EventLogger"), deferrable_(deferrable) {}
+
+    bool IsDeferrable() const override {
+        return deferrable_;
+    }
+
+    void HandleAdd(EdgeId e) override {
+        log.push_back("add " + std::to_string(e.int_id()) + " " + g().EdgeNucls(e).str());
+    }
+
+    void HandleDelete(EdgeId e) override {
+        log.push_back("delete " + std::to_string(e.int_id()) + " " + g().EdgeNucls(e).str());
+    }
+
+    void HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) override {
+        std::string event = "merge " + std::to_string(new_edge.int_id());
+        for (EdgeId e : old_edges)
+            event += " " + std::to_string(e.int_id());
+        log.push_back(event);
+    }
+
+    void HandleSplit(EdgeId old_edge, EdgeId new_edge1, EdgeId new_edge2) override {
+        log.push_back("split " + std::to_string(old_edge.int_id()) + " " +
+                      std::to_string(new_edge1.int_id()) + " " + std::to_string(new_edge2.int_id()));
+    }
+};
+
+TEST( GraphCore, JournaledEvents ) {
+    Graph g(11);
+    EventLogger sync(g, false), deferred(g, true);
+    g.StartJournaling();
+
+    auto data = createGraph(g, 3);
+    g.MergePath({data.second[0], data.second[1]});
+    EdgeId e = data.second[2];
+    g.SplitEdge(e, 3);
+    EXPECT_TRUE(deferred.log.empty());
+    EXPECT_FALSE(sync.log.empty());
+
+    g.FlushEvents();
+    EXPECT_EQ(sync.log, deferred.log);
+
+    g.DeleteEdge(g.GetUniqueOutgoingEdge(data.first[0]));
+    g.StopJournaling();
+    EXPECT_EQ(sync.log, deferred.log);
+}
+
+TEST( GraphCore, JournaledEventsWhileAttached ) {
+    Graph g(11);
+    EventLogger sync(g, false), deferred(g, true);
+    g.StartJournaling();
+
+    auto data = createGraph(g, 3);
+    sync.Detach();
+    deferred.Detach();
+    g.MergePath({data.second[0], data.second[1]});
+    sync.Attach();
+    deferred.Attach();
+    g.SplitEdge(data.second[2], 3);
+
+    // Only the events fired while the handler was attached are replayed
+    g.StopJournaling();
+    EXPECT_FALSE(sync.log.empty());
+    EXPECT_EQ(sync.log, deferred.log);
+}
+
+TEST( GraphCore, JournaledEventsBeyondHandlersLimit ) {
+    Graph g(11);
+    EventLogger sync(g, false);
+    // At most 64 handlers are deferred, the rest get the events right away
+    std::vector<std::unique_ptr<EventLogger>> deferred;
+    for (size_t i = 0; i < 70; ++i)
+        deferred.push_back(std::make_unique<EventLogger>(g, true));
+    g.StartJournaling();
+
+    auto data = createGraph(g, 3);
+    g.MergePath({data.second[0], data.second[1]});
+    EXPECT_TRUE(deferred[63]->log.empty());
+    EXPECT_EQ(sync.log, deferred[64]->log);
+
+    g.StopJournaling();
+    EXPECT_FALSE(sync.log.empty());
+    for (const auto &handler : deferred)
+        EXPECT_EQ(sync.log, handler->log);
+}
+
+TEST( GraphCore, JournaledDeletion ) {
+    Graph g(11);
+    auto data = createGraph(g, 1);
+    EdgeId e = data.second[0];
+    g.StartJournaling();
+
+    g.DeleteEdge(e);
+    EXPECT_FALSE(g.contains(e));
+    EXPECT_FALSE(g.contains(g.conjugate(e)));
+    EXPECT_EQ(0u, g.e_size());
+    // Deleted edges are readable and their ids are not reused until flush
+    EXPECT_EQ(Sequence("AAAAAAAAAAAAAAAAA"), g.EdgeNucls(e));
+    for (size_t i = 0; i < 100; ++i) {
+        EdgeId new_e = g.AddEdge(data.first[0], data.first[1], Sequence("ACGTACGTACGTA"));
+        EXPECT_NE(e, new_e);
+        EXPECT_NE(g.conjugate(e), new_e);
+    }
+    EXPECT_EQ(200u, g.e_size());
+
+    g.StopJournaling();
+    EXPECT_FALSE(g.journaling());
+    EXPECT_FALSE(g.contains(e));
+    EXPECT_EQ(200u, g.e_size());
+}
+
+TEST( GraphCore, IdDistributor ) {
+    omnigraph::ReclaimingIdDistributor ids(3, 100);
+    for (uint64_t i = 0; i < 70; ++i)
+        EXPECT_EQ(3 + i, ids.allocate());
+
+    ids.release(13);
+    ids.release(68);
+    EXPECT_EQ(32u, ids.free());
+    std::vector<uint64_t> occupied(ids.begin(), ids.end());
+    EXPECT_EQ(68u, occupied.size());
+    EXPECT_EQ(3u, occupied.front());
+    EXPECT_EQ(72u, occupied.back());
+    EXPECT_FALSE(ids.occupied(13));
+    EXPECT_FALSE(ids.occupied(68));
+
+    // Neighbouring ids share the bitmap words
+#   pragma omp parallel for num_threads(4)
+    for (uint64_t i = 73; i < 103; ++i)
+        ids.acquire(i);
+    EXPECT_EQ(2u, ids.free());
+
+    EXPECT_EQ(13u, ids.allocate());
+    EXPECT_EQ(68u, ids.allocate());
+    EXPECT_EQ(103u, ids.allocate());
+    EXPECT_EQ(200u, ids.size());
+    EXPECT_EQ(99u, ids.free());
+
+    // Retired ids are neither occupied nor allocated until reclaimed
+    ids.retire(13);
+    ids.retire(14);
+    EXPECT_FALSE(ids.occupied(13));
+    EXPECT_TRUE(ids.retired(14));
+    EXPECT_EQ(99u, ids.free());
+    std::vector<uint64_t> reclaimed;
+    ids.reclaim([&](uint64_t id) {
+        // The id becomes free only after it is handled
+        EXPECT_EQ(99u + reclaimed.size(), ids.free());
+        reclaimed.push_back(id);
+    });
+    EXPECT_EQ(std::vector<uint64_t>({13, 14}), reclaimed);
+    EXPECT_FALSE(ids.retired(13));
+    EXPECT_EQ(101u, ids.free());
+}
@@ -10,9 +10,13 @@
 #include "io/binary/graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/binary/long_reads.hpp"
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <sstream>
+
 using namespace debruijn_graph;
 
 template<typename T>
@@ -63,6 +67,35 @@ TEST(Io, Order) {
     CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
 }
 
+TEST(Io, PackedGraph) {
+    const auto &graph = CommonGraph();
+
+    // Convert the vertex by vertex save, as spades-convert-graph does
+    GraphIO<Graph> io;
+    io.IOSingle<Graph>::Save(file_name, graph);
+    Graph old_graph(graph.k());
+    EXPECT_TRUE(io.LoadUnpacked(file_name, old_graph));
+    PackedGraphIO<Graph>().Save(file_name, old_graph);
+
+    Graph new_graph(graph.k());
+    EXPECT_TRUE(PackedGraphIO<Graph>().Load(file_name, new_graph));
+    EXPECT_EQ(graph.size(), new_graph.size());
+    EXPECT_EQ(graph.e_size(), new_graph.e_size());
+    for (auto it = graph.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        EdgeId e = *it;
+        EXPECT_TRUE(new_graph.contains(e));
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(e));
+        EXPECT_EQ(graph.conjugate(e), new_graph.conjugate(e));
+        EXPECT_EQ(graph.EdgeStart(e), new_graph.EdgeStart(e));
+        EXPECT_EQ(graph.EdgeEnd(e), new_graph.EdgeEnd(e));
+    }
+    for (VertexId v : graph) {
+        auto edges = graph.OutgoingEdges(v), new_edges = new_graph.OutgoingEdges(v);
+        EXPECT_EQ(std::vector<EdgeId>(edges.begin(), edges.end()),
+                  std::vector<EdgeId>(new_edges.begin(), new_edges.end()));
+    }
+}
+
 TEST(Io, PairedInfo) {
     using namespace omnigraph::de;
     using Index = UnclusteredPairedInfoIndexT<Graph>;
@@ -109,3 +142,46 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+TEST(Io, LongReads) {
+    const auto &graph = CommonGraph();
+    auto all_edges = graph.edges();
+    std::vector<EdgeId> edges(all_edges.begin(), all_edges.end());
+
+    PathStorage<Graph> storage(graph);
+    std::map<std::vector<EdgeId>, size_t> expected;
+    std::mt19937 rand(42);
+    for (size_t i = 0; i < 1000; ++i) {
+        // Few distinct paths, so that most of them are added repeatedly
+        std::vector<EdgeId> path;
+        for (size_t j = 0, length = 1 + rand() % 3; j < length; ++j)
+            path.push_back(edges[rand() % 10]);
+        size_t w = 1 + rand() % 3;
+        storage.AddPath(path, (int)w);
+        expected[path] += w;
+    }
+    EXPECT_EQ(expected.size(), storage.size());
+
+    // The merged buffers keep the weights
+    PathStorage<Graph> merged(graph), buffer(graph);
+    merged.AddStorage(storage);
+    buffer.AddStorage(storage);
+    merged.AddStorage(buffer);
+    for (auto &entry : expected)
+        entry.second *= 2;
+
+    std::stringstream ss;
+    merged.BinWrite(ss);
+    PathStorage<Graph> loaded(graph);
+    loaded.BinRead(ss);
+
+    std::vector<PathInfo<Graph>> paths;
+    loaded.SaveAllPaths(paths);
+    ASSERT_EQ(expected.size(), paths.size());
+    auto it = expected.begin();
+    for (const auto &path : paths) {
+        EXPECT_EQ(it->first, path.path());
+        EXPECT_EQ(it->second, path.weight());
+        ++it;
+    }
+}
@@ -7,6 +7,7 @@
 
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "modules/path_extend/parallel_seed_extender.hpp"
 
 #include "graphio.hpp"
 
@@ -755,3 +756,92 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+static std::vector<std::vector<EdgeId>> ExtendInParallel(Graph &g, const PathContainer &seeds,
+                                                   size_t nthreads,
+                                                   const ScaffoldingUniqueEdgeStorage &unique = ScaffoldingUniqueEdgeStorage()) {
+    omnigraph::FlankingCoverage<Graph> flanking_cov(g, 50);
+    UsedUniqueStorage used_storage(unique, g);
+    GraphCoverageMap cover_map(g);
+
+    auto factory = [&](const GraphCoverageMap &cov_map, UsedUniqueStorage &storage) {
+        auto ec = std::make_shared<TrivialExtensionChooser>(g);
+        return ParallelSeedExtender::Extenders{
+            std::make_shared<SimpleExtender>(g, flanking_cov, cov_map, storage, ec,
+                                             false, false, 300)};
+    };
+    CompositeExtender main_extender(g, cover_map, used_storage, factory(cover_map, used_storage));
+    ParallelSeedExtender extender(g, main_extender, factory, nthreads, 16);
+
+    PathContainer input(seeds.begin(), seeds.end());
+    PathContainer result;
+    extender.GrowAll(input, result);
+
+    std::vector<std::vector<EdgeId>> paths;
+    for (auto it = result.begin(); it != result.end(); ++it) {
+        for (const BidirectionalPath *path : { &it.get(), &it.getConjugate() }) {
+            std::vector<EdgeId> edges;
+            for (size_t i = 0; i < path->Size(); ++i)
+                edges.push_back((*path)[i]);
+            paths.push_back(std::move(edges));
+        }
+    }
+    return paths;
+}
+
+TEST( PathExtend, ParallelExtensionDoesNotDependOnThreads ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+
+    PathContainer seeds;
+    for (EdgeId e : g.canonical_edges())
+        seeds.CreatePair(g, e);
+
+    auto single = ExtendInParallel(g, seeds, 1);
+    ASSERT_FALSE(single.empty());
+    EXPECT_EQ(single, ExtendInParallel(g, seeds, 4));
+    EXPECT_EQ(single, ExtendInParallel(g, seeds, 3));
+}
+
+TEST( PathExtend, ParallelExtensionRespectsUniqueEdges ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+
+    // Two edges trivially extended into the same edge, which is marked unique
+    EdgeId unique_edge;
+    std::vector<EdgeId> incoming;
+    for (VertexId v : g) {
+        if (g.IncomingEdgeCount(v) != 2 || g.OutgoingEdgeCount(v) != 1 || g.conjugate(v) == v)
+            continue;
+        EdgeId e = *g.out_begin(v);
+        std::vector<EdgeId> in(g.in_begin(v), g.in_end(v));
+        if (g.EdgeEnd(e) == v || g.conjugate(in[0]) == in[1])
+            continue;
+        unique_edge = e;
+        incoming = in;
+        break;
+    }
+    ASSERT_EQ(2u, incoming.size());
+    ASSERT_NE(unique_edge, g.conjugate(unique_edge));
+
+    ScaffoldingUniqueEdgeStorage unique;
+    unique.insert(unique_edge);
+    unique.insert(g.conjugate(unique_edge));
+
+    // Both seeds are grown speculatively in the same batch and claim the unique edge
+    PathContainer seeds;
+    for (EdgeId e : incoming)
+        seeds.CreatePair(g, e);
+
+    auto single = ExtendInParallel(g, seeds, 1, unique);
+    ASSERT_FALSE(single.empty());
+    EXPECT_EQ(single, ExtendInParallel(g, seeds, 2, unique));
+
+    // Only the path of the first seed gets the unique edge
+    ASSERT_EQ(4u, single.size());
+    auto has_edge = [&](const std::vector<EdgeId> &path) {
+        return std::find(path.begin(), path.end(), unique_edge) != path.end();
+    };
+    EXPECT_TRUE(has_edge(single[0]));
+    EXPECT_EQ(1, std::count_if(single.begin(), single.end(), has_edge));
+}
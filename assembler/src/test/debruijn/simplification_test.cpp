@@ -339,6 +339,42 @@ TEST_F( Simplification,  RelativeCoverageRemover4 ) {
 
 //End of relative coverage removal tests
 
+void SimplifyWithThreads(GraphPack &gp, int threads) {
+    auto &graph = gp.get_mutable<Graph>();
+    auto &flanking_cov = gp.get_mutable<omnigraph::FlankingCoverage<Graph>>();
+
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads(threads);
+    DefaultClipTips(graph);
+    debruijn::simplification::ECRemoverInstance(graph, standard_ec_config(), standard_simplif_relevant_info())->Run();
+    DefaultRemoveBulges(graph);
+    debruijn::simplification::RelativeCoverageComponentRemoverInstance(graph, flanking_cov,
+                                                                       standard_rcc_config(),
+                                                                       standard_simplif_relevant_info())->Run();
+    omp_set_num_threads(max_threads);
+}
+
+std::vector<std::string> EdgeSequences(const Graph &g) {
+    std::vector<std::string> edges;
+    for (EdgeId e : g.edges())
+        edges.push_back(g.EdgeNucls(e).str());
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+TEST_F( Simplification,  BatchedProcessingMatchesSerial ) {
+    for (std::string path : {"tips/graph", "complex_bulge/complex_bulge", "complex_bulge_2/graph",
+                             "rel_cov_ec/constructed_graph", "tipobulge_2/graph"}) {
+        path = graph_fragment_root() + path;
+        GraphPack serial_gp(55, tmp_folder(), 0), batched_gp(55, tmp_folder(), 0);
+        ASSERT_TRUE(graphio::ScanGraphPack(path, serial_gp));
+        ASSERT_TRUE(graphio::ScanGraphPack(path, batched_gp));
+
+        SimplifyWithThreads(serial_gp, 1);
+        SimplifyWithThreads(batched_gp, 4);
+        EXPECT_EQ(EdgeSequences(serial_gp.get<Graph>()), EdgeSequences(batched_gp.get<Graph>())) << path;
+    }
+}
 
 TEST_F( Simplification,  CompressorTest ) {
     std::string path = "./src/test/debruijn/graph_fragments/compression/graph";
@@ -0,0 +1,68 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares the per-query cost of bounded Dijkstra runs keeping their state in
+// hash maps and in the pooled dense workspace.
+// Usage: dijkstra_bench <K> <graph (GFA or saves)> [length bound] [# of queries]
+
+#include "toolchain/utils.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace debruijn_graph;
+
+template<class Storage>
+static size_t RunQueries(const Graph &g, const vector<VertexId> &starts, size_t length_bound, size_t queries) {
+    size_t reached = 0;
+    for (size_t i = 0; i < queries; ++i) {
+        auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra<Storage>(g, length_bound, 1000);
+        dijkstra.Run(starts[i % starts.size()]);
+        reached += dijkstra.ProcessedVertices().size();
+    }
+
+    return reached;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cout << "Usage: dijkstra_bench <K> <graph (GFA or saves)> [length bound] [# of queries]" << endl;
+        exit(1);
+    }
+    toolchain::create_console_logger();
+
+    size_t K = stoull(argv[1]);
+    string graph_path = argv[2];
+    size_t length_bound = (argc > 3 ? stoull(argv[3]) : 1000);
+    size_t queries = (argc > 4 ? stoull(argv[4]) : 1000000);
+
+    GraphPack gp(K, "tmp", 0);
+    toolchain::LoadGraph(gp, graph_path);
+    const auto &g = gp.get<Graph>();
+
+    vector<VertexId> starts(g.begin(), g.end());
+    if (starts.empty()) {
+        cout << "Graph is empty" << endl;
+        exit(1);
+    }
+
+    utils::perf_counter pc;
+    size_t hashed_reached = RunQueries<omnigraph::HashedDijkstraStorage<Graph>>(g, starts, length_bound, queries);
+    double hashed = pc.time() * 1e6 / (double) queries;
+    cout << "hashed: " << hashed << " us/query" << endl;
+
+    pc.reset();
+    size_t dense_reached = RunQueries<omnigraph::DenseDijkstraStorage<Graph>>(g, starts, length_bound, queries);
+    double dense = pc.time() * 1e6 / (double) queries;
+    cout << "dense: " << dense << " us/query, " << hashed / dense << "x"
+         << (dense_reached == hashed_reached ? "" : " MISMATCH") << endl;
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares the ways of filling k-mer statistics from many threads: the old
+// per-k-mer spinlocks, lock-free updates and per-thread accumulators.
+// K-mer frequencies are skewed, so a few k-mers get most of the updates, as
+// homopolymer ones do in Ion Torrent data.
+// Usage: kmer_count_bench [# of k-mers] [# of updates] [thread counts...]
+
+#include "kmer_data.hpp"
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sched.h>
+
+using namespace hammer;
+
+// KMerStat as it was before, guarded with a spinlock
+struct LockedKMerStat {
+  int count = 0;
+  HKMer kmer;
+  float qual = 0;
+  uint8_t lock_ = 0;
+
+  void lock() {
+    while (__sync_val_compare_and_swap(&lock_, 0, 1) == 1) sched_yield();
+  }
+  void unlock() {
+    lock_ = 0;
+    __sync_synchronize();
+  }
+};
+
+template <class Op>
+static double Run(const std::vector<size_t> &updates, unsigned nthreads, Op op) {
+  utils::perf_counter pc;
+#pragma omp parallel num_threads(nthreads)
+  {
+    unsigned thread = omp_get_thread_num();
+    size_t begin = updates.size() * thread / nthreads,
+           end = updates.size() * (thread + 1) / nthreads;
+    op(thread, begin, end);
+  }
+  return (double)updates.size() / pc.time() * 1e-6;
+}
+
+int main(int argc, char **argv) {
+  size_t n = (argc > 1 ? std::stoull(argv[1]) : 1000000);
+  size_t m = (argc > 2 ? std::stoull(argv[2]) : 50000000);
+  std::vector<unsigned> thread_counts;
+  for (int i = 3; i < argc; ++i) thread_counts.push_back((unsigned)std::stoul(argv[i]));
+  if (thread_counts.empty()) thread_counts = {1, 8, 16, 32};
+
+  // Skewed k-mer indices scattered over the whole storage
+  std::vector<size_t> updates(m);
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  for (auto &idx : updates)
+    idx = ((size_t)((double)n * std::pow(uniform(rng), 8)) * 0x9e3779b97f4a7c15ULL) % n;
+
+  for (unsigned nthreads : thread_counts) {
+    std::vector<LockedKMerStat> locked(n);
+    double locked_rate = Run(updates, nthreads, [&](unsigned, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        LockedKMerStat &stat = locked[updates[i]];
+        stat.lock();
+        stat.count += 1;
+        stat.qual += 0.5f;
+        stat.unlock();
+      }
+    });
+
+    KMerData atomic;
+    for (size_t i = 0; i < n; ++i) atomic.push_back(KMerStat());
+    double atomic_rate = Run(updates, nthreads, [&](unsigned, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) atomic[updates[i]].add(HKMer(), 1, 0.5f);
+    });
+
+    KMerData accumulated;
+    for (size_t i = 0; i < n; ++i) accumulated.push_back(KMerStat());
+    double accumulated_rate = Run(updates, nthreads, [&](unsigned, size_t begin, size_t end) {
+      KMerStatAccumulator acc(accumulated);
+      for (size_t i = begin; i < end; ++i) acc.push(updates[i], HKMer(), 0.5f);
+      acc.flush();
+    });
+
+    bool same = true;
+    for (size_t i = 0; i < n; ++i)
+      same &= (locked[i].count == atomic[i].count && locked[i].count == accumulated[i].count);
+
+    std::cout << nthreads << " threads: spinlock " << locked_rate
+              << ", atomic " << atomic_rate
+              << ", accumulated " << accumulated_rate << " M updates/s"
+              << (same ? "" : " MISMATCH") << std::endl;
+  }
+
+  return 0;
+}
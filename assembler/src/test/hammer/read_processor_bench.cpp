@@ -0,0 +1,184 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares per-read (Run) and batched (RunBatched) ReadProcessor modes on
+// operations mirroring hammer's BufferFiller and Expander.
+// Usage: read_processor_bench [reads] [threads] [batch size]
+
+#include "io/reads/ireadstream.hpp"
+#include "io/reads/read_processor.hpp"
+#include "valid_kmer_generator.hpp"
+
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using hammer::KMer;
+
+static const int TRIM_QUALITY = 4;
+
+// Only the correct probability of generated k-mers is referenced here
+double Globals::quality_probs[256] = { 0 };
+
+// Splits valid k-mers of the read and its reverse complement into per-thread buckets
+class FillerOp {
+    static const size_t BUCKETS = 16;
+    static const size_t CELL_SIZE = 1 << 16;
+    std::vector<std::vector<std::vector<KMer>>> buffers_;
+
+    void Push(const KMer &kmer, unsigned thread_id) {
+        auto &bucket = buffers_[thread_id][KMer::hash()(kmer) % BUCKETS];
+        bucket.push_back(kmer);
+        if (bucket.size() > CELL_SIZE)
+            bucket.clear();
+    }
+
+public:
+    explicit FillerOp(unsigned nthreads)
+            : buffers_(nthreads, std::vector<std::vector<KMer>>(BUCKETS)) {}
+
+    bool operator()(std::unique_ptr<Read> r) {
+        return (*this)(*r);
+    }
+
+    bool operator()(const Read &r) {
+        Read cr = r;
+        if (cr.trimNsAndBadQuality(TRIM_QUALITY) < hammer::K)
+            return false;
+
+        unsigned thread_id = omp_get_thread_num();
+        for (ValidKMerGenerator<hammer::K> gen(cr); gen.HasMore(); gen.Next()) {
+            KMer kmer = gen.kmer();
+            Push(kmer, thread_id);
+            Push(!kmer, thread_id);
+        }
+
+        return false;
+    }
+};
+
+// Checks whether every position of the read is covered by a solid k-mer
+class ExpanderOp {
+    const std::unordered_set<KMer, KMer::hash> &solid_;
+    std::atomic<size_t> covered_;
+
+public:
+    explicit ExpanderOp(const std::unordered_set<KMer, KMer::hash> &solid)
+            : solid_(solid), covered_(0) {}
+
+    size_t covered() const { return covered_; }
+
+    bool operator()(std::unique_ptr<Read> r) {
+        return (*this)(*r);
+    }
+
+    bool operator()(const Read &r) {
+        Read cr = r;
+        size_t sz = cr.trimNsAndBadQuality(TRIM_QUALITY);
+        if (sz < hammer::K)
+            return false;
+
+        std::vector<unsigned> covered_by_solid(sz, false);
+        for (ValidKMerGenerator<hammer::K> gen(cr); gen.HasMore(); gen.Next()) {
+            if (!solid_.count(gen.kmer()))
+                continue;
+
+            size_t read_pos = gen.pos() - 1;
+            for (size_t j = read_pos; j < read_pos + hammer::K; ++j)
+                covered_by_solid[j] = true;
+        }
+
+        for (size_t j = 0; j < sz; ++j)
+            if (!covered_by_solid[j])
+                return false;
+
+        covered_ += 1;
+        return false;
+    }
+};
+
+static std::string GenerateReads(const std::string &filename, size_t nreads) {
+    const size_t genome_size = 1 << 20, read_length = 150;
+    std::mt19937 rnd(42);
+    std::string genome(genome_size, 'A');
+    for (char &c : genome)
+        c = nucl(rnd() % 4);
+
+    std::ofstream out(filename);
+    std::string qual(read_length, 'I');
+    for (size_t i = 0; i < nreads; ++i) {
+        std::string read = genome.substr(rnd() % (genome_size - read_length), read_length);
+        // Sprinkle some errors to get non-solid k-mers
+        if (rnd() % 4 == 0)
+            read[rnd() % read_length] = nucl(rnd() % 4);
+        out << "@read" << i << "\n" << read << "\n+\n" << qual << "\n";
+    }
+
+    return genome;
+}
+
+template<class Op>
+static void Bench(const std::string &name, const std::string &filename, Op &op,
+                  unsigned nthreads, size_t batch_size, bool batched) {
+    ireadstream irs(filename);
+    hammer::ReadProcessor rp(nthreads);
+    utils::perf_counter pc;
+    if (batched)
+        rp.RunBatched(irs, op, batch_size);
+    else
+        rp.Run(irs, op);
+    double time = pc.time();
+
+    VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+    INFO(name << (batched ? " batched:  " : " per-read: ") << rp.processed() << " reads in "
+         << utils::human_readable_time(time) << " (" << size_t(double(rp.processed()) / time) << " reads/s)");
+}
+
+static void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+
+    size_t nreads = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    unsigned nthreads = argc > 2 ? unsigned(std::stoul(argv[2])) : unsigned(omp_get_max_threads());
+    size_t batch_size = argc > 3 ? std::stoull(argv[3]) : 256;
+
+    const std::string filename = "read_processor_bench.fastq";
+    INFO("Generating " << nreads << " reads");
+    std::string genome = GenerateReads(filename, nreads);
+
+    std::unordered_set<KMer, KMer::hash> solid;
+    for (size_t i = 0; i + hammer::K <= genome.size(); ++i) {
+        KMer kmer(genome, i);
+        solid.insert(kmer);
+        solid.insert(!kmer);
+    }
+
+    INFO("Running with " << nthreads << " threads, batch size " << batch_size);
+    for (bool batched : {false, true}) {
+        FillerOp filler(nthreads);
+        Bench("BufferFiller", filename, filler, nthreads, batch_size, batched);
+    }
+    for (bool batched : {false, true}) {
+        ExpanderOp expander(solid);
+        Bench("Expander    ", filename, expander, nthreads, batch_size, batched);
+        INFO("Reads covered by solid k-mers: " << expander.covered());
+    }
+
+    remove(filename.c_str());
+    return 0;
+}
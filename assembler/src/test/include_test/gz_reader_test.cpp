@@ -0,0 +1,150 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "io/reads/parallel_gz_reader.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace {
+
+std::string RandomReads(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string res;
+    for (size_t i = 0; i < count; ++i) {
+        res += ">read" + std::to_string(i) + "\n";
+        for (size_t j = 0; j < 100; ++j)
+            res += "ACGT"[rng() % 4];
+        res += "\n";
+    }
+    return res;
+}
+
+void PutLE(std::string &out, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i)
+        out += char((value >> (8 * i)) & 0xFF);
+}
+
+// A single BGZF member as written by bgzip
+std::string BGZFBlock(const std::string &data) {
+    z_stream zs = {};
+    EXPECT_EQ(Z_OK, deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY));
+    std::string deflated(deflateBound(&zs, uLong(data.size())), '\0');
+    zs.next_in = (Bytef*)data.data();
+    zs.avail_in = unsigned(data.size());
+    zs.next_out = (Bytef*)&deflated[0];
+    zs.avail_out = unsigned(deflated.size());
+    EXPECT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+    deflated.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    std::string block("\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0", 16);
+    PutLE(block, uint32_t(18 + deflated.size() + 8 - 1), 2);
+    block += deflated;
+    PutLE(block, uint32_t(crc32(0L, (const Bytef*)data.data(), unsigned(data.size()))), 4);
+    PutLE(block, uint32_t(data.size()), 4);
+    return block;
+}
+
+std::string BGZF(const std::string &data, size_t block_size = 60000) {
+    std::string res;
+    for (size_t i = 0; i < data.size(); i += block_size)
+        res += BGZFBlock(data.substr(i, block_size));
+    // End-of-file marker
+    return res + BGZFBlock("");
+}
+
+// Plain gzip of one member per part
+std::string Gzip(const std::vector<std::string> &parts, const std::string &tmp) {
+    std::string res;
+    for (const auto &part : parts) {
+        gzFile f = gzopen(tmp.c_str(), "wb");
+        gzwrite(f, part.data(), unsigned(part.size()));
+        gzclose(f);
+        std::ifstream in(tmp, std::ios::binary);
+        res += std::string(std::istreambuf_iterator<char>(in), {});
+    }
+    return res;
+}
+
+// Errors are fatal and reported to the log on stdout, so death tests only check the exit
+class ParallelGzReaderTest : public ::testing::Test {
+protected:
+    fs::TmpDir tmp_dir_ = fs::tmp::make_temp_dir(".", "gz_reader_test");
+
+    std::string File(const std::string &name) const {
+        return fs::append_path(tmp_dir_->dir(), name);
+    }
+
+    std::string Write(const std::string &name, const std::string &content) {
+        std::string fn = File(name);
+        std::ofstream out(fn, std::ios::binary);
+        out.write(content.data(), content.size());
+        return fn;
+    }
+
+    static std::string ReadAll(const std::string &fn, size_t nthreads) {
+        io::ParallelGzReader reader(fn, nthreads);
+        EXPECT_TRUE(reader.is_open());
+        std::string res, buf(12345, '\0');
+        while (int n = reader.read(&buf[0], unsigned(buf.size())))
+            res.append(buf.data(), size_t(n));
+        return res;
+    }
+};
+
+}
+
+TEST_F(ParallelGzReaderTest, BGZFRoundTrip) {
+    std::string data = RandomReads(60000, 1);
+    std::string fn = Write("reads.fa.gz", BGZF(data));
+    EXPECT_TRUE(io::ParallelGzReader::IsBGZF(fn));
+    for (size_t nthreads : { 1, 4 })
+        EXPECT_EQ(data, ReadAll(fn, nthreads));
+}
+
+TEST_F(ParallelGzReaderTest, MultiMemberGzip) {
+    // The members are larger than a decompression chunk in total
+    std::string part1 = RandomReads(30000, 2), part2 = RandomReads(20000, 3);
+    std::string fn = Write("reads.fa.gz", Gzip({ part1, part2 }, File("part.gz")));
+    EXPECT_FALSE(io::ParallelGzReader::IsBGZF(fn));
+    EXPECT_EQ(part1 + part2, ReadAll(fn, 4));
+}
+
+TEST_F(ParallelGzReaderTest, BGZFChecksumMismatch) {
+    std::string data = RandomReads(100, 4);
+    std::string block = BGZF(data);
+    std::string bad_crc = block, bad_isize = block;
+    // The first member is followed by the 28-byte end-of-file marker
+    size_t footer = block.size() - 28 - 8;
+    bad_crc[footer] ^= 1;
+    bad_isize[footer + 4] ^= 1;
+    std::string crc_fn = Write("crc.fa.gz", bad_crc), isize_fn = Write("isize.fa.gz", bad_isize);
+    EXPECT_DEATH(ReadAll(crc_fn, 2), "");
+    EXPECT_DEATH(ReadAll(isize_fn, 2), "");
+}
+
+TEST_F(ParallelGzReaderTest, GzipChecksumMismatch) {
+    std::string gz = Gzip({ RandomReads(100, 5) }, File("part.gz"));
+    gz[gz.size() - 8] ^= 1;
+    std::string fn = Write("crc.fa.gz", gz);
+    EXPECT_DEATH(ReadAll(fn, 2), "");
+}
+
+TEST_F(ParallelGzReaderTest, TruncatedInput) {
+    std::string data = RandomReads(1000, 6);
+    std::string bgzf = BGZF(data, 10000), gz = Gzip({ data }, File("part.gz"));
+    std::string bgzf_fn = Write("truncated.bgzf.gz", bgzf.substr(0, bgzf.size() / 2));
+    std::string gz_fn = Write("truncated.fa.gz", gz.substr(0, gz.size() / 2));
+    EXPECT_DEATH(ReadAll(bgzf_fn, 2), "");
+    EXPECT_DEATH(ReadAll(gz_fn, 2), "");
+}
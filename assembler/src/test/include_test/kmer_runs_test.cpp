@@ -0,0 +1,218 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "utils/kmer_mph/kmer_runs.hpp"
+#include "sequence/rtseq.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace kmers;
+
+namespace {
+
+struct BlockHeader {
+    uint32_t count;
+    uint32_t encoded_size;
+    uint32_t stored_size;
+};
+
+template<class T>
+std::vector<uint8_t> Encode(const std::vector<T> &data, size_t elcnt, bool compress) {
+    std::vector<uint8_t> res;
+    KMerRunCodec<T>(elcnt).Encode(data.data(), data.size() / elcnt, compress, res);
+    return res;
+}
+
+template<class T>
+std::vector<T> Decode(const std::vector<uint8_t> &encoded, size_t elcnt) {
+    std::vector<T> res;
+    for (KMerRunIterator<T> it(encoded.data(), encoded.size(), elcnt), end; it != end; ++it) {
+        auto kmer = *it;
+        EXPECT_EQ(elcnt, kmer.size());
+        res.insert(res.end(), kmer.data(), kmer.data() + kmer.size());
+    }
+    return res;
+}
+
+std::vector<BlockHeader> BlockHeaders(const std::vector<uint8_t> &encoded) {
+    std::vector<BlockHeader> res;
+    for (size_t offset = 0; offset < encoded.size(); ) {
+        BlockHeader header;
+        memcpy(&header, encoded.data() + offset, sizeof(header));
+        res.push_back(header);
+        offset += sizeof(header) + header.stored_size;
+        EXPECT_LE(offset, encoded.size());
+    }
+    return res;
+}
+
+// Runs are checked in every encoded format
+template<class T>
+void CheckRoundTrip(const std::vector<T> &data, size_t elcnt) {
+    for (bool compress : { false, true })
+        EXPECT_EQ(data, Decode<T>(Encode(data, elcnt, compress), elcnt)) << "compress: " << compress;
+}
+
+std::vector<uint64_t> FromDeltas(uint64_t start, const std::vector<uint64_t> &deltas) {
+    std::vector<uint64_t> res = { start };
+    for (uint64_t delta : deltas)
+        res.push_back(res.back() + delta);
+    return res;
+}
+
+std::vector<uint64_t> Consecutive(size_t cnt) {
+    std::vector<uint64_t> res(cnt);
+    for (size_t i = 0; i < cnt; ++i)
+        res[i] = i;
+    return res;
+}
+
+// Feeds the given k-mers to the sorting splitter, dumping the buffers often, so
+// every bucket gets several runs with k-mers repeated across them
+class VectorKMerSplitter : public KMerSortingSplitter<RtSeq> {
+public:
+    VectorKMerSplitter(fs::TmpDir work_dir, unsigned K, RawKMerFormat raw_format,
+                       const std::vector<RtSeq> &kmers)
+            : KMerSortingSplitter<RtSeq>(work_dir, K, raw_format), kmers_(kmers) {}
+
+    RawKMers Split(size_t num_files, unsigned) override {
+        auto out = PrepareBuffers(num_files, 1, 1);
+        for (size_t i = 0; i < kmers_.size(); ++i) {
+            if (push_back_internal(kmers_[i], 0) || (i + 1) % 5000 == 0)
+                DumpBuffers(out);
+        }
+        DumpBuffers(out);
+        ClearBuffers();
+        return out;
+    }
+
+private:
+    std::vector<RtSeq> kmers_;
+};
+
+}
+
+TEST(KMerRunCodec, VarintBoundaries) {
+    // Deltas taking 1, 2, 3 and up to 10 bytes
+    CheckRoundTrip(FromDeltas(0, { 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0x1FFFFF, 0x200000 }), 1);
+    CheckRoundTrip(FromDeltas(1, { (1ull << 63) - 1 }), 1);
+    CheckRoundTrip(FromDeltas(0, { 1ull << 63 }), 1);
+    CheckRoundTrip(FromDeltas(0, { ~0ull }), 1);
+    CheckRoundTrip(FromDeltas(0x80, { 0x7F, 1ull << 62, 1ull << 62 }), 1);
+}
+
+TEST(KMerRunCodec, MultiWordKMers) {
+    // Few distinct values of the leading words, so the first differing word is
+    // mostly not the first one
+    std::mt19937_64 rng(1);
+    for (size_t elcnt : { 2, 3 }) {
+        std::set<std::vector<uint64_t>> kmers;
+        while (kmers.size() < 10000) {
+            std::vector<uint64_t> kmer(elcnt);
+            kmer[0] = 5 + 4 * (rng() % 2);
+            for (size_t w = 1; w + 1 < elcnt; ++w)
+                kmer[w] = rng() % 4;
+            kmer.back() = rng() >> (rng() % 64);
+            kmers.insert(kmer);
+        }
+
+        std::vector<uint64_t> data;
+        for (const auto &kmer : kmers)
+            data.insert(data.end(), kmer.begin(), kmer.end());
+        CheckRoundTrip(data, elcnt);
+    }
+
+    // Same for narrower words
+    std::vector<uint32_t> data = { 0, 1, 7,  0, 1, 8,  0, 2, 0,  1, 0, 0,  1, 0, 0xFFFFFFFF,  1, 1, 0 };
+    CheckRoundTrip(data, 3);
+}
+
+TEST(KMerRunCodec, LongRuns) {
+    const size_t BLOCK = KMerRunCodec<uint64_t>::BLOCK_RECORDS;
+    std::vector<uint64_t> data;
+    for (size_t i = 0; i < 3 * BLOCK + 17; ++i)
+        data.push_back(i * i);
+
+    for (bool compress : { false, true }) {
+        auto encoded = Encode(data, 1, compress);
+        auto headers = BlockHeaders(encoded);
+        ASSERT_EQ(4u, headers.size());
+        for (size_t i = 0; i < 3; ++i)
+            EXPECT_EQ(BLOCK, headers[i].count);
+        EXPECT_EQ(17u, headers[3].count);
+        EXPECT_EQ(data, Decode<uint64_t>(encoded, 1));
+    }
+
+    // Exactly full blocks
+    CheckRoundTrip(Consecutive(2 * BLOCK), 1);
+}
+
+TEST(KMerRunCodec, CompressedBlocks) {
+    const size_t BLOCK = KMerRunCodec<uint64_t>::BLOCK_RECORDS;
+
+    // Unit deltas compress well
+    auto data = Consecutive(2 * BLOCK);
+    auto delta = Encode(data, 1, false), compressed = Encode(data, 1, true);
+    EXPECT_LT(compressed.size(), delta.size());
+    for (const auto &header : BlockHeaders(compressed))
+        EXPECT_LT(header.stored_size, header.encoded_size);
+    EXPECT_EQ(data, Decode<uint64_t>(compressed, 1));
+
+    // The last block of a single record does not shrink and is stored as is
+    data = Consecutive(BLOCK);
+    data.push_back(0x0123456789ABCDEF);
+    compressed = Encode(data, 1, true);
+    auto headers = BlockHeaders(compressed);
+    ASSERT_EQ(2u, headers.size());
+    EXPECT_LT(headers[0].stored_size, headers[0].encoded_size);
+    EXPECT_EQ(headers[1].stored_size, headers[1].encoded_size);
+    EXPECT_EQ(data, Decode<uint64_t>(compressed, 1));
+
+    // Nothing shrinks, so the output is the same as the uncompressed one
+    data = { 0x0123456789ABCDEF };
+    EXPECT_EQ(Encode(data, 1, false), Encode(data, 1, true));
+    EXPECT_EQ(data, Decode<uint64_t>(Encode(data, 1, true), 1));
+}
+
+TEST(KMerRunCodec, MergedFormatsAreEqual) {
+    const unsigned K = 55;
+    std::mt19937 rng(2);
+    std::vector<std::string> pool(30000);
+    for (auto &kmer : pool)
+        for (unsigned i = 0; i < K; ++i)
+            kmer += "ACGT"[rng() % 4];
+
+    std::vector<RtSeq> kmers;
+    std::set<std::string> distinct;
+    for (size_t i = 0; i < 60000; ++i) {
+        const std::string &kmer = pool[rng() % pool.size()];
+        kmers.emplace_back(K, kmer.c_str());
+        distinct.insert(kmer);
+    }
+
+    fs::TmpDir tmp_dir = fs::tmp::make_temp_dir(".", "kmer_runs_test");
+    std::vector<std::string> merged;
+    for (auto format : { RawKMerFormat::Plain, RawKMerFormat::Delta, RawKMerFormat::Compressed }) {
+        KMerDiskCounter<RtSeq> counter(tmp_dir, VectorKMerSplitter(tmp_dir, K, format, kmers));
+        auto storage = counter.Count(4, 2);
+        EXPECT_EQ(distinct.size(), storage.total_kmers()) << RawKMerFormatName(format);
+        storage.merge();
+
+        std::ifstream in(*storage.final_kmers(), std::ios::binary);
+        merged.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    EXPECT_EQ(merged[0], merged[1]);
+    EXPECT_EQ(merged[0], merged[2]);
+}
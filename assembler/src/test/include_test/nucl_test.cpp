@@ -5,6 +5,10 @@
 //***************************************************************************
 
 #include "sequence/nucl.hpp"
+#include "sequence/nucl_pack.hpp"
+#include <random>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 TEST( Nucl, Test ) {
@@ -31,3 +35,59 @@ TEST( Nucl, Test ) {
     EXPECT_TRUE(!is_nucl('0'));
     EXPECT_TRUE(!is_nucl('1'));
 }
+
+static std::vector<uint64_t> PackReference(const std::string &s, bool rc) {
+    std::vector<uint64_t> res((s.size() + 31) / 32, 0);
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = rc ? complement(dignucl(s[s.size() - 1 - i])) : dignucl(s[i]);
+        res[i / 32] |= uint64_t(c) << (2 * (i % 32));
+    }
+    return res;
+}
+
+TEST( NuclPack, Pack ) {
+    std::mt19937 rnd(239);
+    const std::string letters = "ACGTacgt";
+    for (const auto &kernels : nucl_pack::AvailableKernels()) {
+        SCOPED_TRACE(kernels.name);
+        for (size_t n = 0; n < 300; ++n) {
+            std::string s(n, 'A');
+            for (char &c : s)
+                c = letters[rnd() % letters.size()];
+
+            for (bool rc : {false, true}) {
+                std::vector<uint64_t> packed((n + 31) / 32, uint64_t(-1));
+                EXPECT_TRUE(kernels.pack(s.data(), n, packed.data(), rc));
+                EXPECT_EQ(PackReference(s, rc), packed);
+            }
+
+            if (n) {
+                std::string bad = s;
+                bad[rnd() % n] = "N0-\xC1"[rnd() % 4];
+                std::vector<uint64_t> packed((n + 31) / 32);
+                EXPECT_FALSE(kernels.pack(bad.data(), n, packed.data(), false));
+                EXPECT_FALSE(kernels.pack(bad.data(), n, packed.data(), true));
+            }
+        }
+    }
+}
+
+TEST( NuclPack, Valid ) {
+    std::mt19937 rnd(239);
+    // the first 12 symbols are valid
+    const std::string symbols("ACGTacgt\0\1\2\3Nn.\4\xC1\xE3", 18);
+    for (const auto &kernels : nucl_pack::AvailableKernels()) {
+        SCOPED_TRACE(kernels.name);
+        for (size_t n = 0; n < 300; ++n) {
+            std::string s(n, 'A');
+            for (char &c : s)
+                c = symbols[rnd() % 12];
+            EXPECT_TRUE(kernels.valid(s.data(), n));
+
+            if (n) {
+                s[rnd() % n] = symbols[12 + rnd() % 6];
+                EXPECT_FALSE(kernels.valid(s.data(), n));
+            }
+        }
+    }
+}
@@ -700,3 +700,18 @@ TEST( RtSeq, FirstLast ) {
     EXPECT_EQ(3, s2.first());
     EXPECT_EQ(3, s2.last());
 }
+
+TEST( RtSeq, FromLetters ) {
+    std::string s = "TTGCAACCGGTTAACCGGTTAACCGGTTAACCGGTTAAacgtACGTTGCAtgcaACGTACGTACG";
+    std::string digits(s.size(), 0);
+    for (size_t i = 0; i < s.size(); ++i)
+        digits[i] = dignucl(s[i]);
+
+    for (size_t k = 1; k <= 64; ++k)
+        for (size_t offset = 0; offset + k <= s.size(); ++offset) {
+            EXPECT_EQ(RtSeq(k, digits, offset), RtSeq(k, s, offset));
+            EXPECT_EQ(RtSeq(k, digits, offset), RtSeq(k, s.c_str(), offset));
+        }
+
+    EXPECT_EQ(RtSeq(5, "ACGTT"), RtSeq(5, "ACGTN"));
+}
@@ -6,6 +6,7 @@
 
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
+#include <sstream>
 #include <string>
 #include <gtest/gtest.h>
 
@@ -42,3 +43,41 @@ TEST( Sequence, ReverseComplement ) {
     Sequence s2 = Sequence("ACG");
     EXPECT_EQ("CGT", (!s2).str());
 }
+
+TEST( Sequence, BinReadSharedStorage ) {
+    std::stringstream str;
+    Sequence("ACGTACGTAC").BinWrite(str);
+    Sequence("").BinWrite(str);
+    Sequence("TTGCAACCGGTTAACCGGTTAACCGGTTAACCGGTTAA").BinWrite(str);
+    std::string data = str.str();
+
+    const uint8_t *ptr = reinterpret_cast<const uint8_t*>(data.data());
+    Sequence::SharedStorage storage(Sequence::SharedStorage::WordsFor(data.size()));
+    Sequence s1, s2, s3;
+    ptr = s1.BinRead(ptr, storage);
+    ptr = s2.BinRead(ptr, storage);
+    ptr = s3.BinRead(ptr, storage);
+
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(data.data() + data.size()), ptr);
+    EXPECT_EQ("ACGTACGTAC", s1.str());
+    EXPECT_EQ("", s2.str());
+    EXPECT_EQ("TTGCAACCGGTTAACCGGTTAACCGGTTAACCGGTTAA", s3.str());
+    EXPECT_EQ("TTAACCGGTTAACCGGTTAACCGGTTAACCGGTTGCAA", (!s3).str());
+}
+
+TEST( Sequence, FromLetters ) {
+    std::string s = "TTGCAACCGGTTAACCGGTTAACCGGTTAACCGGTTAAacgtACGTTGCAtgcaACGTACGTACG";
+    std::string digits(s.size(), 0);
+    for (size_t i = 0; i < s.size(); ++i)
+        digits[i] = dignucl(s[i]);
+
+    for (size_t n = 1; n <= s.size(); ++n) {
+        EXPECT_EQ(Sequence(digits.substr(0, n)), Sequence(s.substr(0, n)));
+        EXPECT_EQ(Sequence(digits.substr(0, n), true), Sequence(s.substr(0, n), true));
+    }
+
+    // Other symbols are packed as before
+    EXPECT_EQ("ACGT", Sequence("ACGN").str());
+    EXPECT_EQ("AAAACCCCGGGGTTTTAAAACCCCGGGGTTTTAAAAT", Sequence("AAAACCCCGGGGTTTTAAAACCCCGGGGTTTTAAAAN").str());
+    EXPECT_EQ("AGCAAAACCCCGGGGTTTTAAAACCCCGGGGTTTT", Sequence("AAAACCCCGGGGTTTTAAAACCCCGGGGTTTTGCN", true).str());
+}